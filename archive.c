@@ -0,0 +1,888 @@
+/*
+ * archive.c
+ * Francesco Piras - Dario Varano
+ * June 2015
+ */
+
+#include "archive.h"
+#include "blocks.h"
+#include "bitio.h"
+#include "checksum.h"
+#include "input.h"
+#include "threadpool.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define ARCHIVE_CHUNK		(1024 * 1024)		// size (in bytes) of the chunks of decoded data written to the extracted files
+
+/**
+ * @brief The resources of a worker thread, used for all the members it processes
+ *
+ */
+typedef struct context_struct {
+	LZ78_STREAM* stream;		// the stream, reset for every member
+	BIT_FILE* bf;				// the memory bit file of the stream, bound to the area of every member
+	uint8_t* area;				// the compressed member
+	size_t area_size;			// capacity (in bytes) of the area
+	uint8_t* chunk;				// the decoded data to be written, in extraction
+	LZ78_STATS stats;			// statistics of all the members processed by the worker thread
+} CONTEXT;
+
+/**
+ * @brief A member of the archive
+ *
+ */
+typedef struct member_struct {
+	struct archive_struct* archive;	// the archive of the member
+	char* path;					// the path of the file
+	char* name;					// the path stored in the archive
+	uint64_t raw_size;			// size (in bytes) of the file
+	uint64_t packed_size;		// size (in bytes) of the stream of the member
+	uint64_t offset;			// position of the stream of the member in the archive
+	uint8_t* packed;			// compression: the stream waiting for the previous members to be written, or NULL
+	bool done;					// compression: the member has been compressed
+	int result;					// outcome of the task on the member (0 or -1)
+} MEMBER;
+
+/**
+ * @brief An archive being compressed or extracted
+ *
+ */
+typedef struct archive_struct {
+	OPTIONS options;			// the parameters of the streams of the members
+	MEMBER* members;			// the members, in the order of the index
+	int count;					// number of members
+	int capacity;				// number of allocated members
+	int fd;						// the archive file descriptor
+	char* root;					// extraction: the directory where the members are extracted, or NULL to discard them
+	CONTEXT* contexts;			// the resources of the worker threads
+	int threads;				// number of worker threads
+	pthread_mutex_t lock;		// protects the following fields
+	int next;					// compression: next member to be written
+	uint64_t offset;			// compression: position of the next byte written
+	int result;					// outcome of the writes (0 or -1)
+} ARCHIVE;
+
+/**
+ * @brief It appends a member to the archive
+ *
+ * @param archive the pointer to the archive
+ * @param path the path of the file, which is copied
+ * @param name the path stored in the archive, which is copied
+ * @return int a flag indicating if the member has been added (0) or if an error occurs (-1)
+ */
+int archive_add (ARCHIVE* archive, const char* path, const char* name);
+
+/**
+ * @brief It adds the regular files of a directory to the archive, walking its subdirectories (symbolic links are not followed)
+ *
+ * @param archive the pointer to the archive
+ * @param path the path of the directory
+ * @param name the path of the directory stored in the archive ("" for the top directory)
+ * @return int a flag indicating if the directory has been walked (0) or if an error occurs (-1)
+ */
+int archive_walk (ARCHIVE* archive, const char* path, const char* name);
+
+/**
+ * @brief It adds the files listed by a file, one per line, to the archive
+ *
+ * @param archive the pointer to the archive
+ * @param list the path of the list ("-" for the standard input)
+ * @return int a flag indicating if all the files have been added (0) or if an error occurs (-1)
+ */
+int archive_list (ARCHIVE* archive, char* list);
+
+/**
+ * @brief It tells if a path can be stored in the archive and extracted safely: relative, without empty, "." or ".." components
+ *
+ * @param name the path
+ * @return bool true if the path is valid
+ */
+bool archive_name_valid (const char* name);
+
+/**
+ * @brief It makes the resources of the calling worker thread ready for a member: its area is at least size bytes,
+ * 		and its stream starts again on the area
+ *
+ * @param archive the pointer to the archive
+ * @param size the size (in bytes) of the area needed
+ * @param compressing flag indicating a compression
+ * @return CONTEXT* the pointer to the resources of the worker thread, or NULL if an error occurs
+ */
+CONTEXT* archive_context (ARCHIVE* archive, size_t size, bool compressing);
+
+/**
+ * @brief It releases the resources of the worker threads, adding their statistics to a total
+ *
+ * @param archive the pointer to the archive
+ * @param stats the pointer to the total, or NULL
+ * @return void
+ */
+void archive_contexts_free (ARCHIVE* archive, LZ78_STATS* stats);
+
+/**
+ * @brief It releases the members of the archive
+ *
+ * @param archive the pointer to the archive
+ * @return void
+ */
+void archive_members_free (ARCHIVE* archive);
+
+/**
+ * @brief The task compressing a member
+ *
+ * @param arg the pointer to the member
+ * @return void
+ */
+void member_compress_task (void* arg);
+
+/**
+ * @brief It writes a compressed member as soon as all the previous ones have been written, and then the following
+ * 		members already compressed: if the member can't be written yet, its stream is copied aside
+ *
+ * @param member the pointer to the member
+ * @param packed the stream of the member
+ * @return void
+ */
+void member_commit (MEMBER* member, uint8_t* packed);
+
+/**
+ * @brief The task extracting a member
+ *
+ * @param arg the pointer to the member
+ * @return void
+ */
+void member_extract_task (void* arg);
+
+/**
+ * @brief It creates the directories of a path below a root directory, up to the last component (which is not created),
+ * 		refusing the ones which already exist as anything but a directory (a symbolic link included)
+ *
+ * @param path the path, which is temporarily modified
+ * @param root_len the length of the root directory at the beginning of the path, whose components are not checked
+ * @return int a flag indicating if the directories exist (0) or if an error occurs (-1)
+ */
+int make_parents (char* path, size_t root_len);
+
+/**
+ * @brief It reads exactly len bytes from a position of a file
+ *
+ * @param fd the file descriptor
+ * @param buf the destination area
+ * @param len the number of bytes to be read
+ * @param offset the position of the first byte
+ * @return int a flag indicating if the bytes have been read (0) or if an error occurs or the file is shorter (-1)
+ */
+int pread_full (int fd, void* buf, size_t len, uint64_t offset);
+
+/**
+ * @brief It compares the stored paths of two members, for qsort
+ */
+int compare_members (const void* a, const void* b);
+
+/**
+ * @brief It compares two stored paths, given by their pointers, for qsort
+ */
+int compare_names (const void* a, const void* b);
+
+/**
+ * @brief It checks that no stored path is repeated, since two workers would write the same file: the paths are
+ * 		sorted aside, so that the members keep their order
+ *
+ * @param archive the pointer to the archive
+ * @return int a flag indicating if the paths are unique (0), or if a path is repeated or an error occurs (-1)
+ */
+int archive_names_unique (ARCHIVE* archive);
+
+int archive_compress (char* input, char* output, OPTIONS* options, LZ78_STATS* stats)
+{
+	ARCHIVE archive;
+	THREAD_POOL* pool;
+	HEADER header;
+	struct stat info;
+	uint8_t* index;
+	uint8_t* entry;
+	size_t index_size, len;
+	int i, ret;
+
+	memset(&archive, 0, sizeof(ARCHIVE));
+	archive.options = *options;
+	archive.fd = -1;
+	pool = NULL;
+	index = NULL;
+	ret = -1;
+
+	if (stats != NULL)
+		memset(stats, 0, sizeof(LZ78_STATS));
+
+	// the members: the files of a directory, sorted by path, or the ones of a list, in its order
+	if (strcmp(input, "-") != 0 && stat(input, &info) == 0 && S_ISDIR(info.st_mode)) {
+		if (archive_walk(&archive, input, "") < 0)
+			goto error;
+		qsort(archive.members, archive.count, sizeof(MEMBER), compare_members);
+	}
+	else if (archive_list(&archive, input) < 0 || archive_names_unique(&archive) < 0)
+		goto error;
+
+	archive.fd = open_output(output);
+	if (archive.fd < 0)
+		goto error;
+
+	header_init(&header, options, HEADER_FLAG_ARCHIVE, 0);
+	if (header_write(archive.fd, &header) < 0)
+		goto error;
+	archive.offset = header_size(&header);
+
+	archive.threads = (options->threads > 0)?(options->threads):(thread_pool_default_size());
+	archive.contexts = calloc(archive.threads, sizeof(CONTEXT));
+	if (archive.contexts == NULL)
+		goto error;
+	pthread_mutex_init(&archive.lock, NULL);
+
+	pool = thread_pool_create(archive.threads);
+	if (pool == NULL)
+		goto error_lock;
+
+	// the members are spread over the queues of the worker threads, which steal them from each other when idle
+	for (i = 0; i < archive.count; i++) {
+		if (thread_pool_submit(pool, member_compress_task, &archive.members[i]) < 0) {
+			archive.result = -1;
+			break;
+		}
+	}
+	thread_pool_destroy(pool);
+
+	if (archive.result < 0 || archive.next != archive.count)
+		goto error_lock;
+
+	// the index, then the trailer
+	index_size = ARCHIVE_TRAILER_SIZE;
+	for (i = 0; i < archive.count; i++)
+		index_size += ARCHIVE_ENTRY_SIZE + strlen(archive.members[i].name);
+	index = malloc(index_size);
+	if (index == NULL)
+		goto error_lock;
+
+	entry = index;
+	for (i = 0; i < archive.count; i++) {
+		len = strlen(archive.members[i].name);
+		entry[0] = len & 0xFF;
+		entry[1] = (len >> 8) & 0xFF;
+		put_le64(entry + 2, archive.members[i].raw_size);
+		put_le64(entry + 10, archive.members[i].packed_size);
+		put_le64(entry + 18, archive.members[i].offset);
+		memcpy(entry + ARCHIVE_ENTRY_SIZE, archive.members[i].name, len);
+		entry += ARCHIVE_ENTRY_SIZE + len;
+	}
+	memcpy(entry, "L78I", 4);
+	put_le32(entry + 4, archive.count);
+	put_le64(entry + 8, archive.offset);
+
+	if (write_full(archive.fd, index, index_size) < 0)
+		goto error_lock;
+
+	ret = 0;
+
+error_lock:
+	archive_contexts_free(&archive, stats);
+	pthread_mutex_destroy(&archive.lock);
+error:
+	if (archive.fd >= 0 && close(archive.fd) < 0)
+		ret = -1;
+	// a partial archive has no index, so it is removed (unless it is written on the standard output)
+	if (ret < 0 && archive.fd >= 0 && output != NULL && strcmp(output, "-") != 0)
+		unlink(output);
+	free(index);
+	archive_members_free(&archive);
+
+	return ret;
+}
+
+int archive_extract (int in, char* output, HEADER* header, OPTIONS* options, LZ78_STATS* stats)
+{
+	ARCHIVE archive;
+	THREAD_POOL* pool;
+	MEMBER* member;
+	struct stat info;
+	uint8_t trailer[ARCHIVE_TRAILER_SIZE];
+	uint8_t* index;
+	uint8_t* entry;
+	uint64_t index_offset, index_size, pos;
+	uint32_t count;
+	size_t len;
+	int i, ret;
+
+	memset(&archive, 0, sizeof(ARCHIVE));
+	archive.options = *options;
+	header_options(header, &archive.options);
+	archive.fd = in;
+	archive.root = (output != NULL && strcmp(output, "-") == 0)?("."):(output);
+	index = NULL;
+	ret = -1;
+
+	if (stats != NULL)
+		memset(stats, 0, sizeof(LZ78_STATS));
+
+	// the index is at the end of the archive, which has to be a regular file
+	if (fstat(in, &info) < 0 || !S_ISREG(info.st_mode) || info.st_size < HEADER_SIZE + ARCHIVE_TRAILER_SIZE) {
+		fprintf(stderr, "An archive can be extracted only from a regular file\n");
+		goto error;
+	}
+	if (pread_full(in, trailer, ARCHIVE_TRAILER_SIZE, info.st_size - ARCHIVE_TRAILER_SIZE) < 0 || memcmp(trailer, "L78I", 4) != 0)
+		goto error;
+
+	count = get_le32(trailer + 4);
+	index_offset = get_le64(trailer + 8);
+	if (index_offset < HEADER_SIZE || index_offset > (uint64_t)info.st_size - ARCHIVE_TRAILER_SIZE)
+		goto error;
+	index_size = info.st_size - ARCHIVE_TRAILER_SIZE - index_offset;
+	if ((uint64_t)count * ARCHIVE_ENTRY_SIZE > index_size)
+		goto error;
+
+	index = malloc(index_size + 1);
+	archive.members = calloc((count > 0)?(count):(1), sizeof(MEMBER));
+	if (index == NULL || archive.members == NULL || pread_full(in, index, index_size, index_offset) < 0)
+		goto error;
+	archive.capacity = count;
+
+	// checking every entry against the size of the index and the position of the index
+	pos = 0;
+	for (i = 0; i < (int)count; i++) {
+		if (pos + ARCHIVE_ENTRY_SIZE > index_size)
+			goto error;
+		entry = index + pos;
+		len = entry[0] | (entry[1] << 8);
+		if (len == 0 || len > ARCHIVE_MAX_PATH || pos + ARCHIVE_ENTRY_SIZE + len > index_size)
+			goto error;
+
+		member = &archive.members[i];
+		member->archive = &archive;
+		member->raw_size = get_le64(entry + 2);
+		member->packed_size = get_le64(entry + 10);
+		member->offset = get_le64(entry + 18);
+		member->name = malloc(len + 1);
+		if (member->name == NULL)
+			goto error;
+		archive.count++;
+		memcpy(member->name, entry + ARCHIVE_ENTRY_SIZE, len);
+		member->name[len] = '\0';
+
+		if (member->offset < HEADER_SIZE || member->packed_size == 0 || member->packed_size > index_offset - member->offset ||
+			member->offset > index_offset || strlen(member->name) != len || archive_name_valid(member->name) == false)
+			goto error;
+
+		pos += ARCHIVE_ENTRY_SIZE + len;
+	}
+
+	if (archive_names_unique(&archive) < 0)
+		goto error;
+
+	if (archive.root != NULL && mkdir(archive.root, 0777) < 0 && errno != EEXIST)
+		goto error;
+
+	archive.threads = (options->threads > 0)?(options->threads):(thread_pool_default_size());
+	archive.contexts = calloc(archive.threads, sizeof(CONTEXT));
+	if (archive.contexts == NULL)
+		goto error;
+
+	pool = thread_pool_create(archive.threads);
+	if (pool == NULL)
+		goto error;
+
+	for (i = 0; i < archive.count; i++) {
+		archive.members[i].result = -1;
+		if (thread_pool_submit(pool, member_extract_task, &archive.members[i]) < 0)
+			break;
+	}
+	thread_pool_destroy(pool);
+
+	ret = 0;
+	for (i = 0; i < archive.count; i++) {
+		if (archive.members[i].result < 0) {
+			fprintf(stderr, "Can't extract %s\n", archive.members[i].name);
+			ret = -1;
+		}
+	}
+
+error:
+	archive_contexts_free(&archive, stats);
+	free(index);
+	archive_members_free(&archive);
+
+	return ret;
+}
+
+int archive_add (ARCHIVE* archive, const char* path, const char* name)
+{
+	MEMBER* members;
+	MEMBER* member;
+
+	if (archive->count == archive->capacity) {
+		archive->capacity = (archive->capacity > 0)?(archive->capacity * 2):(64);
+		members = realloc(archive->members, archive->capacity * sizeof(MEMBER));
+		if (members == NULL)
+			return -1;
+		archive->members = members;
+	}
+
+	member = &archive->members[archive->count];
+	memset(member, 0, sizeof(MEMBER));
+	member->archive = archive;
+	member->path = strdup(path);
+	member->name = strdup(name);
+	if (member->path == NULL || member->name == NULL) {
+		free(member->path);
+		free(member->name);
+		return -1;
+	}
+	archive->count++;
+
+	return 0;
+}
+
+int archive_walk (ARCHIVE* archive, const char* path, const char* name)
+{
+	DIR* dir;
+	struct dirent* item;
+	struct stat info;
+	char* child_path;
+	char* child_name;
+	int ret;
+
+	dir = opendir(path);
+	if (dir == NULL)
+		return -1;
+
+	ret = 0;
+	while (ret == 0 && (item = readdir(dir)) != NULL) {
+		if (strcmp(item->d_name, ".") == 0 || strcmp(item->d_name, "..") == 0)
+			continue;
+
+		child_path = malloc(strlen(path) + strlen(item->d_name) + 2);
+		child_name = malloc(strlen(name) + strlen(item->d_name) + 2);
+		if (child_path == NULL || child_name == NULL) {
+			free(child_path);
+			free(child_name);
+			ret = -1;
+			break;
+		}
+		sprintf(child_path, "%s/%s", path, item->d_name);
+		if (name[0] != '\0')
+			sprintf(child_name, "%s/%s", name, item->d_name);
+		else
+			strcpy(child_name, item->d_name);
+
+		// the regular files are members, the directories are walked, anything else is skipped
+		if (lstat(child_path, &info) < 0)
+			ret = -1;
+		else if (S_ISDIR(info.st_mode))
+			ret = archive_walk(archive, child_path, child_name);
+		else if (S_ISREG(info.st_mode)) {
+			if (strlen(child_name) > ARCHIVE_MAX_PATH) {
+				fprintf(stderr, "Path too long: %s\n", child_path);
+				ret = -1;
+			}
+			else
+				ret = archive_add(archive, child_path, child_name);
+		}
+
+		free(child_path);
+		free(child_name);
+	}
+	closedir(dir);
+
+	return ret;
+}
+
+int archive_list (ARCHIVE* archive, char* list)
+{
+	FILE* file;
+	char* line;
+	char* name;
+	size_t size;
+	ssize_t len;
+	int fd, ret;
+
+	fd = open_input(list);
+	if (fd < 0)
+		return -1;
+	file = fdopen(fd, "r");
+	if (file == NULL) {
+		close(fd);
+		return -1;
+	}
+
+	line = NULL;
+	size = 0;
+	ret = 0;
+	while (ret == 0 && (len = getline(&line, &size, file)) >= 0) {
+		while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r'))
+			line[--len] = '\0';
+		if (len == 0)
+			continue;
+
+		// the stored path is relative: the leading "/" and "./" are dropped
+		name = line;
+		while (name[0] == '/' || (name[0] == '.' && name[1] == '/')) {
+			while (name[0] == '.' && name[1] == '/')
+				name += 2;
+			while (name[0] == '/')
+				name++;
+		}
+
+		if (archive_name_valid(name) == false || strlen(name) > ARCHIVE_MAX_PATH) {
+			fprintf(stderr, "Bad member path: %s\n", line);
+			ret = -1;
+		}
+		else
+			ret = archive_add(archive, line, name);
+	}
+
+	free(line);
+	fclose(file);
+
+	return ret;
+}
+
+bool archive_name_valid (const char* name)
+{
+	const char* component;
+	size_t len;
+
+	if (name[0] == '\0' || name[0] == '/')
+		return false;
+
+	// every component between two separators
+	component = name;
+	while (1) {
+		len = strcspn(component, "/");
+		if (len == 0 || (len == 1 && component[0] == '.') || (len == 2 && component[0] == '.' && component[1] == '.'))
+			return false;
+		if (component[len] == '\0')
+			return true;
+		component += len + 1;
+	}
+}
+
+CONTEXT* archive_context (ARCHIVE* archive, size_t size, bool compressing)
+{
+	CONTEXT* context;
+	uint8_t* area;
+	int index;
+
+	index = thread_pool_self();
+	if (index < 0 || index >= archive->threads)
+		return NULL;
+	context = &archive->contexts[index];
+
+	// the area only grows, so the largest member sets its size
+	if (size > context->area_size) {
+		area = realloc(context->area, size);
+		if (area == NULL)
+			return NULL;
+		context->area = area;
+		context->area_size = size;
+	}
+
+	// the first member of the worker thread allocates the stream, the following ones reuse it
+	if (context->bf == NULL) {
+		context->bf = bit_open_mem(context->area, context->area_size, (compressing == true)?("w"):("r"));
+		if (context->bf == NULL)
+			return NULL;
+		context->stream = lz78_open(&archive->options, context->bf, compressing);
+		if (context->stream == NULL)
+			return NULL;
+	}
+	else if (bit_reopen_mem(context->bf, context->area, size) < 0 || lz78_reset(context->stream, context->bf) < 0)
+		return NULL;
+
+	return context;
+}
+
+void archive_contexts_free (ARCHIVE* archive, LZ78_STATS* stats)
+{
+	int i;
+
+	if (archive->contexts == NULL)
+		return;
+
+	for (i = 0; i < archive->threads; i++) {
+		lz78_stats_add(stats, &archive->contexts[i].stats);
+		lz78_free(archive->contexts[i].stream);
+		if (archive->contexts[i].bf != NULL)
+			bit_close(archive->contexts[i].bf);
+		free(archive->contexts[i].area);
+		free(archive->contexts[i].chunk);
+	}
+	free(archive->contexts);
+	archive->contexts = NULL;
+}
+
+void archive_members_free (ARCHIVE* archive)
+{
+	int i;
+
+	for (i = 0; i < archive->count; i++) {
+		free(archive->members[i].path);
+		free(archive->members[i].name);
+		free(archive->members[i].packed);
+	}
+	free(archive->members);
+	archive->members = NULL;
+	archive->count = 0;
+}
+
+void member_compress_task (void* arg)
+{
+	MEMBER* member;
+	CONTEXT* context;
+	INPUT* input;
+	LZ78_STATS member_stats;
+	struct stat info;
+	const uint8_t* data;
+	size_t len, used;
+	uint32_t crc;
+	int ret;
+
+	member = arg;
+	member->result = -1;
+	context = NULL;
+
+	input = input_open(member->path, member->archive->options.buffer_size);
+	if (input == NULL || fstat(input->fd, &info) < 0) {
+		fprintf(stderr, "Can't read %s\n", member->path);
+		goto done;
+	}
+
+	// the area has room for the worst case of the size of the file
+	context = archive_context(member->archive, blocks_bound(info.st_size, member->archive->options.bits), true);
+	if (context == NULL)
+		goto done;
+
+	// a file growing while it is read is cut to the size it had when it was opened
+	member->raw_size = 0;
+	crc = 0;
+	while ((ret = input_next(input, &data, &len)) == 0) {
+		if (len > (uint64_t)info.st_size - member->raw_size)
+			len = info.st_size - member->raw_size;
+		if (lz78_encode(context->stream, data, len, &used) < 0)
+			break;
+		if (member->archive->options.checksum == true)
+			crc = crc32c(crc, data, len);
+		member->raw_size += len;
+		if (member->raw_size == (uint64_t)info.st_size) {
+			ret = 1;
+			break;
+		}
+	}
+	if (ret == 1 && lz78_encode_end(context->stream) == LZ78_END &&
+		(member->archive->options.checksum == false || checksum_write(context->bf, crc) == 0)) {
+		member->packed_size = bit_length(context->bf);
+		member->result = 0;
+	}
+
+	// the statistics are taken before the bit file is reopened, which counts its bytes from 0 again
+	lz78_stats(context->stream, &member_stats);
+	lz78_stats_add(&context->stats, &member_stats);
+
+	// the last bits go to the area
+	if (member->result == 0 && bit_reopen_mem(context->bf, context->area, context->area_size) < 0)
+		member->result = -1;
+
+done:
+	input_close(input);
+	member_commit(member, (context != NULL)?(context->area):(NULL));
+}
+
+void member_commit (MEMBER* member, uint8_t* packed)
+{
+	ARCHIVE* archive;
+	MEMBER* next;
+
+	archive = member->archive;
+
+	pthread_mutex_lock(&archive->lock);
+
+	member->done = true;
+	if (member->result < 0)
+		archive->result = -1;
+
+	// a member which can't be written yet keeps a copy of its stream
+	if (member->result == 0 && member != &archive->members[archive->next]) {
+		member->packed = malloc(member->packed_size);
+		if (member->packed == NULL)
+			archive->result = -1;
+		else
+			memcpy(member->packed, packed, member->packed_size);
+	}
+	else if (member->result == 0)
+		member->packed = packed;
+
+	// writing the members in order, as long as they are ready
+	while (archive->result == 0 && archive->next < archive->count && archive->members[archive->next].done == true) {
+		next = &archive->members[archive->next];
+		next->offset = archive->offset;
+		if (write_full(archive->fd, next->packed, next->packed_size) < 0)
+			archive->result = -1;
+		archive->offset += next->packed_size;
+
+		if (next != member)
+			free(next->packed);
+		next->packed = NULL;
+		archive->next++;
+	}
+
+	// the stream of the worker thread is never kept
+	if (member->packed == packed)
+		member->packed = NULL;
+
+	pthread_mutex_unlock(&archive->lock);
+}
+
+void member_extract_task (void* arg)
+{
+	MEMBER* member;
+	ARCHIVE* archive;
+	CONTEXT* context;
+	LZ78_STATS member_stats;
+	char* path;
+	size_t produced;
+	uint64_t total;
+	uint32_t crc;
+	int out, ret;
+
+	member = arg;
+	archive = member->archive;
+	member->result = -1;
+	out = -1;
+
+	if (member->packed_size > SIZE_MAX)
+		return;
+
+	context = archive_context(archive, member->packed_size, false);
+	if (context == NULL || pread_full(archive->fd, context->area, member->packed_size, member->offset) < 0)
+		return;
+	if (context->chunk == NULL) {
+		context->chunk = malloc(ARCHIVE_CHUNK);
+		if (context->chunk == NULL)
+			return;
+	}
+
+	// the file is created in the output directory, with its directories, unless the data is discarded
+	if (archive->root != NULL) {
+		path = malloc(strlen(archive->root) + strlen(member->name) + 2);
+		if (path == NULL)
+			return;
+		sprintf(path, "%s/%s", archive->root, member->name);
+		// a data file with the usual permissions (the umask applies), never written through a symbolic link
+		if (make_parents(path, strlen(archive->root)) == 0)
+			out = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW, 0666);
+		free(path);
+	}
+	else
+		out = open_output(NULL);
+	if (out < 0)
+		return;
+
+	// the member has to decompress exactly to the size stored in the index
+	total = 0;
+	crc = 0;
+	do {
+		ret = lz78_decode(context->stream, context->chunk, ARCHIVE_CHUNK, &produced);
+		if (ret < 0)
+			break;
+		if (archive->options.checksum == true)
+			crc = crc32c(crc, context->chunk, produced);
+		total += produced;
+		if (produced > 0 && write_full(out, context->chunk, produced) < 0)
+			ret = LZ78_ERROR;
+	} while (ret == LZ78_OK && total <= member->raw_size);
+
+	if (ret == LZ78_END && total == member->raw_size &&
+		(archive->options.checksum == false || checksum_verify(context->bf, crc) == 0))
+		member->result = 0;
+
+	lz78_stats(context->stream, &member_stats);
+	lz78_stats_add(&context->stats, &member_stats);
+
+	if (close(out) < 0)
+		member->result = -1;
+}
+
+int make_parents (char* path, size_t root_len)
+{
+	struct stat info;
+	char* separator;
+
+	// creating every directory of the path after the root: the ones already there are fine if they are real directories
+	for (separator = strchr(path + root_len + 1, '/'); separator != NULL; separator = strchr(separator + 1, '/')) {
+		*separator = '\0';
+		if (mkdir(path, 0777) < 0 && (errno != EEXIST || lstat(path, &info) < 0 || !S_ISDIR(info.st_mode))) {
+			*separator = '/';
+			return -1;
+		}
+		*separator = '/';
+	}
+
+	return 0;
+}
+
+int pread_full (int fd, void* buf, size_t len, uint64_t offset)
+{
+	size_t done;
+	ssize_t result;
+
+	done = 0;
+	while (done < len) {
+		result = pread(fd, (uint8_t*)buf + done, len - done, offset + done);
+		if (result < 0 && errno == EINTR)
+			continue;
+		if (result <= 0)
+			return -1;
+		done += result;
+	}
+
+	return 0;
+}
+
+int compare_members (const void* a, const void* b)
+{
+	return strcmp(((const MEMBER*)a)->name, ((const MEMBER*)b)->name);
+}
+
+int compare_names (const void* a, const void* b)
+{
+	return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+int archive_names_unique (ARCHIVE* archive)
+{
+	char** names;
+	int i, ret;
+
+	if (archive->count < 2)
+		return 0;
+	names = malloc(archive->count * sizeof(char*));
+	if (names == NULL)
+		return -1;
+	for (i = 0; i < archive->count; i++)
+		names[i] = archive->members[i].name;
+	qsort(names, archive->count, sizeof(char*), compare_names);
+
+	ret = 0;
+	for (i = 1; i < archive->count && ret == 0; i++) {
+		if (strcmp(names[i - 1], names[i]) == 0) {
+			fprintf(stderr, "%s is stored more than once\n", names[i]);
+			ret = -1;
+		}
+	}
+	free(names);
+
+	return ret;
+}
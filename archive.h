@@ -0,0 +1,74 @@
+/*
+ * archive.h
+ * Francesco Piras - Dario Varano
+ * June 2015
+ */
+
+#ifndef _ARCHIVE_H
+#define _ARCHIVE_H
+
+#include "definitions.h"
+#include "header.h"
+#include "lz78.h"
+
+/**
+ * NOTE ON THE ARCHIVE FORMAT
+ *
+ * An archive holds many files (its members), each one compressed on its own as a single stream with the parameters
+ * of the header (HEADER_FLAG_ARCHIVE set, block_size 0), so that the members are compressed and extracted in parallel.
+ * Every worker thread keeps its stream and its bit file for all the members it processes: a member only costs
+ * a new epoch of the dictionary. The header is followed by the streams of the members, then by the member index
+ * and by a trailer:
+ *
+ * 			+--------+-----------------------+-------------------------+---------+
+ * 			| header | streams of the members | member index (N entries) | trailer |
+ * 			+--------+-----------------------+-------------------------+---------+
+ *
+ * 		entry:		+-----------+-----------+-----------+--------------+------------------+
+ * 					| path_len	| raw_size	| packed	| offset	   | path_len bytes	  |
+ * 					+-----------+-----------+-----------+--------------+------------------+
+ * 					   16 bits	   64 bits	   64 bits	   64 bits		 the member path
+ *
+ * 		trailer:	+-----+-----+-----+-----+-----------+--------------+
+ * 					| 'L' | '7' | '8' | 'I' |	N		| index offset |
+ * 					+-----+-----+-----+-----+-----------+--------------+
+ * 												32 bits		64 bits
+ *
+ * where packed is the size of the stream of the member and offset its position in the archive. All the fields are
+ * little endian. The streams follow the order of the index, so the output doesn't depend on the number of threads,
+ * and the archive is written sequentially (on a pipe too); extracting it needs a regular file. The paths are relative,
+ * with '/' separators and without "." or ".." components.
+ */
+
+#define ARCHIVE_ENTRY_SIZE		26			// size (in bytes) of an index entry, without the path
+#define ARCHIVE_TRAILER_SIZE	16			// size (in bytes) of the trailer
+#define ARCHIVE_MAX_PATH		4096		// maximum length (in bytes) of the path of a member
+
+/**
+ * @brief It compresses many files into an archive, using options->threads worker threads (or one per online processor,
+ * 		if not specified)
+ *
+ * @param input a directory, whose regular files are archived recursively, or a file listing the paths of the files
+ * 		to be archived, one per line ("-" for the standard input)
+ * @param output the output file name
+ * @param options the compression parameters
+ * @param stats the pointer to the structure filled with the statistics of all the members, or NULL
+ * @return int a flag indicating if the compression operation has been completed successfully (0) or if an error occurs (-1)
+ */
+int archive_compress (char* input, char* output, OPTIONS* options, LZ78_STATS* stats);
+
+/**
+ * @brief It extracts all the members of an archive, whose header has already been read, using options->threads
+ * 		worker threads (or one per online processor, if not specified)
+ *
+ * @param in the input file descriptor, which has to be a regular file
+ * @param output the directory where the members are extracted ("-" for the current directory), created if needed,
+ * 		or NULL to only verify them
+ * @param header the pointer to the header of the archive
+ * @param options the decompression parameters
+ * @param stats the pointer to the structure filled with the statistics of all the members, or NULL
+ * @return int a flag indicating if the extraction has been completed successfully (0) or if an error occurs (-1)
+ */
+int archive_extract (int in, char* output, HEADER* header, OPTIONS* options, LZ78_STATS* stats);
+
+#endif
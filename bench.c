@@ -0,0 +1,583 @@
+/*
+ * bench.c
+ * Francesco Piras - Dario Varano
+ * June 2015
+ */
+
+#include <time.h>
+#include <unistd.h>
+#include <string.h>
+#include "definitions.h"
+#include "lz78.h"
+#include "dictionary.h"
+
+#define BENCH_SIZE		4					// default size (in MiB) of every file of the corpus
+#define BENCH_SLICE		(1024 * 1024)		// size (in bytes) of the slices whose latency is measured
+#define BENCH_SEED		0x9E3779B97F4A7C15ULL	// seed of the generator of the corpus
+#define BENCH_MIN_BITS	9					// smallest code width of the sweep
+#define BENCH_MAX_BITS	15					// largest code width of the sweep
+#define BENCH_DICTS		3					// number of dictionary sizes of the sweep for each code width
+
+/**
+ * @brief The generator of a synthetic file of the corpus
+ *
+ */
+typedef struct corpus_struct {
+	const char* name;						// the name of the file
+	void (*generate) (uint8_t* data, size_t size);	// the function filling the file
+} CORPUS;
+
+/**
+ * @brief The measures of a round trip
+ *
+ */
+typedef struct result_struct {
+	size_t raw_size;						// size (in bytes) of the original data
+	size_t packed_size;						// size (in bytes) of the compressed data
+	double compress_time;					// wall time (in seconds) of the fastest compression
+	double decompress_time;					// wall time (in seconds) of the fastest decompression
+	double* compress_slices;				// wall time (in seconds) of every slice compressed, in all the repetitions
+	double* decompress_slices;				// wall time (in seconds) of every slice decompressed, in all the repetitions
+	int slices;								// number of slices measured for each direction
+} RESULT;
+
+/**
+ * @brief It returns the next pseudo random number of the generator (xorshift64*), so that the corpus
+ * is the same on every machine and at every run
+ *
+ * @param state the pointer to the state of the generator
+ * @return uint64_t the pseudo random number
+ */
+uint64_t bench_random (uint64_t* state);
+
+/**
+ * @brief It fills an area with English-like text: words of a small vocabulary, the most frequent ones
+ * picked more often, grouped in sentences and lines
+ *
+ * @param data the area to be filled
+ * @param size the size (in bytes) of the area
+ * @return void
+ */
+void generate_text (uint8_t* data, size_t size);
+
+/**
+ * @brief It fills an area with the lines of a server log: increasing timestamps, a few levels and modules,
+ * addresses and numeric fields
+ *
+ * @param data the area to be filled
+ * @param size the size (in bytes) of the area
+ * @return void
+ */
+void generate_logs (uint8_t* data, size_t size);
+
+/**
+ * @brief It fills an area with binary records: increasing identifiers, small types, slowly varying values and padding
+ *
+ * @param data the area to be filled
+ * @param size the size (in bytes) of the area
+ * @return void
+ */
+void generate_binary (uint8_t* data, size_t size);
+
+/**
+ * @brief It fills an area with uniformly distributed bytes, which can't be compressed
+ *
+ * @param data the area to be filled
+ * @param size the size (in bytes) of the area
+ * @return void
+ */
+void generate_random (uint8_t* data, size_t size);
+
+/**
+ * @brief It fills an area with long runs of the same byte
+ *
+ * @param data the area to be filled
+ * @param size the size (in bytes) of the area
+ * @return void
+ */
+void generate_runs (uint8_t* data, size_t size);
+
+/**
+ * @brief It compresses and decompresses an area in memory, by slices, checking that the data is restored
+ *
+ * @param options the compression parameters
+ * @param data the original data
+ * @param size the size (in bytes) of the original data
+ * @param packed the area of the compressed data, large enough for the worst case
+ * @param restored the area of the decompressed data, as large as the original one
+ * @param repeat the number of repetitions
+ * @param result the pointer to the measures, whose arrays of slices have repeat * (size / BENCH_SLICE + 1) elements
+ * @return int a flag indicating if the round trip has been completed successfully (0) or if an error occurs (-1)
+ */
+int bench_round_trip (OPTIONS* options, const uint8_t* data, size_t size, uint8_t* packed, uint8_t* restored, int repeat, RESULT* result);
+
+/**
+ * @brief It returns the wall time elapsed from an arbitrary point of the past
+ *
+ * @return double the time (in seconds)
+ */
+double bench_time (void);
+
+/**
+ * @brief It returns a percentile of the latency of the slices, by the nearest rank
+ *
+ * @param slices the wall times of the slices, sorted in ascending order
+ * @param count the number of slices
+ * @param percent the percentile
+ * @return double the latency (in milliseconds per MiB)
+ */
+double bench_percentile (double* slices, int count, int percent);
+
+/**
+ * @brief It compares two times, for qsort
+ */
+int compare_times (const void* a, const void* b);
+
+CORPUS corpus[] = {
+	{ "text", generate_text },
+	{ "logs", generate_logs },
+	{ "binary", generate_binary },
+	{ "random", generate_random },
+	{ "runs", generate_runs },
+};
+
+int main(int argc, char** argv)
+{
+	int arg, i, k, bits, first_bits, last_bits, repeat, slices, table, ret;
+	int n_corpus = sizeof(corpus) / sizeof(corpus[0]);
+	uint32_t dict_sizes[BENCH_DICTS];
+	long int tmp;
+	size_t size, bound;
+	bool json;
+	char* only;
+	FILE* out;
+	uint8_t *data, *packed, *restored;
+	OPTIONS options;
+	RESULT result;
+	bool first;
+
+	size = (size_t)BENCH_SIZE << 20;
+	first_bits = BENCH_MIN_BITS;
+	last_bits = BENCH_MAX_BITS;
+	repeat = 1;
+	table = DICTIONARY_LINEAR;
+	json = false;
+	only = NULL;
+	out = stdout;
+
+	// parsing the options
+	while ((arg = getopt(argc, argv, "b:c:f:n:o:r:t:")) != -1) {
+		switch (arg) {
+			case 'b':
+				tmp = strtol(optarg, NULL, 10);
+				if (tmp < MIN_BITS || tmp > MAX_BITS) {
+					fprintf(stderr, "Bad code width\n");
+					return -1;
+				}
+				first_bits = last_bits = (int)tmp;
+				break;
+			case 'c':
+				only = optarg;
+				break;
+			case 'f':
+				if (strcmp(optarg, "json") == 0)
+					json = true;
+				else if (strcmp(optarg, "csv") == 0)
+					json = false;
+				else {
+					fprintf(stderr, "Bad output format\n");
+					return -1;
+				}
+				break;
+			case 'n':
+				tmp = strtol(optarg, NULL, 10);
+				if (tmp <= 0 || tmp > 1024) {
+					fprintf(stderr, "Bad corpus size\n");
+					return -1;
+				}
+				size = (size_t)tmp << 20;
+				break;
+			case 'o':
+				out = fopen(optarg, "w");
+				if (out == NULL) {
+					fprintf(stderr, "Can't open %s\n", optarg);
+					return -1;
+				}
+				break;
+			case 'r':
+				tmp = strtol(optarg, NULL, 10);
+				if (tmp <= 0 || tmp > 100) {
+					fprintf(stderr, "Bad number of repetitions\n");
+					return -1;
+				}
+				repeat = (int)tmp;
+				break;
+			case 't':
+				if (strcmp(optarg, "linear") == 0)
+					table = DICTIONARY_LINEAR;
+				else if (strcmp(optarg, "buckets") == 0)
+					table = DICTIONARY_BUCKETS;
+				else if (strcmp(optarg, "robinhood") == 0)
+					table = DICTIONARY_ROBIN_HOOD;
+				else {
+					fprintf(stderr, "Bad table layout\n");
+					return -1;
+				}
+				break;
+			case '?':
+				fprintf(stderr, "Usage: %s [-b bits] [-c corpus] [-f csv|json] [-n MiB] [-o file] [-r repetitions] [-t linear|buckets|robinhood]\n", argv[0]);
+				return -1;
+		}
+	}
+
+	// a code is at most MAX_BITS for every input byte, plus the final codes
+	bound = (size + 16) * MAX_BITS / 8 + 16;
+	slices = repeat * (int)(size / BENCH_SLICE + 1);
+	data = malloc(size);
+	packed = malloc(bound);
+	restored = malloc(size);
+	result.compress_slices = malloc(slices * sizeof(double));
+	result.decompress_slices = malloc(slices * sizeof(double));
+	if (data == NULL || packed == NULL || restored == NULL || result.compress_slices == NULL || result.decompress_slices == NULL) {
+		fprintf(stderr, "Out of memory\n");
+		return -1;
+	}
+
+	if (json == true)
+		fprintf(out, "[\n");
+	else
+		fprintf(out, "corpus,bits,dict_size,raw_bytes,packed_bytes,ratio,compress_mbs,decompress_mbs,"
+				"compress_p50_ms,compress_p99_ms,decompress_p50_ms,decompress_p99_ms\n");
+
+	ret = 0;
+	first = true;
+	for (i = 0; i < n_corpus; i++) {
+		if (only != NULL && strcmp(only, corpus[i].name) != 0)
+			continue;
+		corpus[i].generate(data, size);
+
+		for (bits = first_bits; bits <= last_bits; bits++) {
+			// the sweep of the dictionary size: all the codes, three quarters and half of them in use
+			dict_sizes[0] = 1U << (bits + 1);
+			dict_sizes[1] = 3U << (bits - 1);
+			dict_sizes[2] = 1U << bits;
+
+			for (k = 0; k < BENCH_DICTS; k++) {
+				// a dictionary without room for any code past the first symbols isn't worth measuring
+				if (dict_sizes[k] / 2 <= FIRST_CODE)
+					continue;
+
+				memset(&options, 0, sizeof(OPTIONS));
+				options.bits = bits;
+				options.dict_size = dict_sizes[k];
+				options.table = table;
+
+				if (bench_round_trip(&options, data, size, packed, restored, repeat, &result) < 0) {
+					fprintf(stderr, "Round trip failed: %s, %d bits, dictionary size %u\n", corpus[i].name, bits, dict_sizes[k]);
+					ret = -1;
+					continue;
+				}
+
+				qsort(result.compress_slices, result.slices, sizeof(double), compare_times);
+				qsort(result.decompress_slices, result.slices, sizeof(double), compare_times);
+
+				if (json == true) {
+					fprintf(out, "%s  {\"corpus\": \"%s\", \"bits\": %d, \"dict_size\": %u, \"raw_bytes\": %zu, \"packed_bytes\": %zu, "
+							"\"ratio\": %.4f, \"compress_mbs\": %.2f, \"decompress_mbs\": %.2f, "
+							"\"compress_p50_ms\": %.3f, \"compress_p99_ms\": %.3f, \"decompress_p50_ms\": %.3f, \"decompress_p99_ms\": %.3f}",
+							(first == true)?(""):(",\n"), corpus[i].name, bits, dict_sizes[k], result.raw_size, result.packed_size,
+							(double)result.raw_size / (double)result.packed_size,
+							(double)result.raw_size / (1 << 20) / result.compress_time,
+							(double)result.raw_size / (1 << 20) / result.decompress_time,
+							bench_percentile(result.compress_slices, result.slices, 50), bench_percentile(result.compress_slices, result.slices, 99),
+							bench_percentile(result.decompress_slices, result.slices, 50), bench_percentile(result.decompress_slices, result.slices, 99));
+				}
+				else {
+					fprintf(out, "%s,%d,%u,%zu,%zu,%.4f,%.2f,%.2f,%.3f,%.3f,%.3f,%.3f\n",
+							corpus[i].name, bits, dict_sizes[k], result.raw_size, result.packed_size,
+							(double)result.raw_size / (double)result.packed_size,
+							(double)result.raw_size / (1 << 20) / result.compress_time,
+							(double)result.raw_size / (1 << 20) / result.decompress_time,
+							bench_percentile(result.compress_slices, result.slices, 50), bench_percentile(result.compress_slices, result.slices, 99),
+							bench_percentile(result.decompress_slices, result.slices, 50), bench_percentile(result.decompress_slices, result.slices, 99));
+				}
+				fflush(out);
+				first = false;
+			}
+		}
+	}
+
+	if (json == true)
+		fprintf(out, "\n]\n");
+
+	if (out != stdout)
+		fclose(out);
+	free(data);
+	free(packed);
+	free(restored);
+	free(result.compress_slices);
+	free(result.decompress_slices);
+
+	return ret;
+}
+
+int bench_round_trip (OPTIONS* options, const uint8_t* data, size_t size, uint8_t* packed, uint8_t* restored, int repeat, RESULT* result)
+{
+	LZ78_STREAM* stream;
+	size_t in_pos, out_pos, in_len, in_used, out_used, end, bound;
+	double start, slice_start, elapsed;
+	int r, ret, slices;
+
+	bound = (size + 16) * MAX_BITS / 8 + 16;
+	result->raw_size = size;
+	result->slices = 0;
+	slices = 0;
+
+	for (r = 0; r < repeat; r++) {
+		// compression: a slice of input at a time, the output area is large enough for all the codes
+		stream = lz78_compress_init(options);
+		if (stream == NULL)
+			return -1;
+
+		in_pos = 0;
+		out_pos = 0;
+		start = bench_time();
+		while (in_pos < size) {
+			in_len = (size - in_pos < BENCH_SLICE)?(size - in_pos):(BENCH_SLICE);
+			slice_start = bench_time();
+			if (lz78_compress_chunk(stream, data + in_pos, in_len, &in_used, packed + out_pos, bound - out_pos, &out_used) < 0 || in_used != in_len) {
+				lz78_free(stream);
+				return -1;
+			}
+			result->compress_slices[slices] = bench_time() - slice_start;
+			slices++;
+			in_pos += in_used;
+			out_pos += out_used;
+		}
+		do {
+			ret = lz78_compress_finish(stream, packed + out_pos, bound - out_pos, &out_used);
+			out_pos += out_used;
+		} while (ret == LZ78_OK && out_used > 0);
+		elapsed = bench_time() - start;
+		lz78_free(stream);
+		if (ret != LZ78_END)
+			return -1;
+
+		if (r == 0 || elapsed < result->compress_time)
+			result->compress_time = elapsed;
+		result->packed_size = out_pos;
+
+		// decompression: all the codes are available, the output is produced a slice at a time
+		stream = lz78_decompress_init(options);
+		if (stream == NULL)
+			return -1;
+
+		in_pos = 0;
+		out_pos = 0;
+		ret = LZ78_OK;
+		start = bench_time();
+		while (ret == LZ78_OK && out_pos < size) {
+			slice_start = bench_time();
+			end = (size - out_pos < BENCH_SLICE)?(size):(out_pos + BENCH_SLICE);
+			// filling the slice, the decompressor stops when its bit buffer needs more codes
+			while (ret == LZ78_OK && out_pos < end) {
+				ret = lz78_decompress_chunk(stream, packed + in_pos, result->packed_size - in_pos, &in_used, restored + out_pos, end - out_pos, &out_used);
+				in_pos += in_used;
+				out_pos += out_used;
+				if (in_used == 0 && out_used == 0)
+					break;
+			}
+			result->decompress_slices[result->slices] = bench_time() - slice_start;
+			result->slices++;
+			if (in_used == 0 && out_used == 0)
+				break;
+		}
+		// reading EOS, which has no output
+		while (ret == LZ78_OK) {
+			ret = lz78_decompress_chunk(stream, packed + in_pos, result->packed_size - in_pos, &in_used, restored + out_pos, size - out_pos, &out_used);
+			in_pos += in_used;
+			out_pos += out_used;
+			if (in_used == 0 && out_used == 0)
+				break;
+		}
+		elapsed = bench_time() - start;
+		lz78_free(stream);
+
+		// checking the round trip
+		if (ret != LZ78_END || out_pos != size || memcmp(data, restored, size) != 0)
+			return -1;
+
+		if (r == 0 || elapsed < result->decompress_time)
+			result->decompress_time = elapsed;
+
+		// both the directions have the same number of slices
+		if (result->slices != slices)
+			return -1;
+	}
+
+	return 0;
+}
+
+double bench_time (void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+double bench_percentile (double* slices, int count, int percent)
+{
+	int rank;
+
+	if (count == 0)
+		return 0.0;
+
+	// nearest rank: the smallest value with at least percent% of the values not above it
+	rank = (count * percent + 99) / 100;
+	if (rank < 1)
+		rank = 1;
+
+	return slices[rank - 1] * 1000.0;
+}
+
+int compare_times (const void* a, const void* b)
+{
+	double x = *(const double*)a, y = *(const double*)b;
+
+	return (x > y) - (x < y);
+}
+
+uint64_t bench_random (uint64_t* state)
+{
+	*state ^= *state >> 12;
+	*state ^= *state << 25;
+	*state ^= *state >> 27;
+
+	return *state * 0x2545F4914F6CDD1DULL;
+}
+
+void generate_text (uint8_t* data, size_t size)
+{
+	static const char* words[] = {
+		"the", "of", "and", "to", "a", "in", "is", "that", "it", "was", "for", "on", "are", "as", "with", "his",
+		"they", "at", "be", "this", "from", "have", "or", "by", "one", "had", "not", "but", "what", "all", "were", "when",
+		"we", "there", "can", "an", "your", "which", "their", "said", "if", "do", "will", "each", "about", "how", "up", "out",
+		"dictionary", "compression", "symbol", "stream", "sequence", "pointer", "buffer", "output", "thread", "block", "width", "entry",
+		"several", "children", "between", "another", "without", "something", "important", "remember", "following", "government", "character", "question",
+	};
+	int n_words = sizeof(words) / sizeof(words[0]);
+	uint64_t state = BENCH_SEED;
+	size_t pos = 0, line = 0, len;
+	bool capital = true;
+	const char* word;
+
+	while (pos < size) {
+		// the product of two uniform indexes picks the first words more often, like the real frequencies
+		word = words[(bench_random(&state) % n_words) * (bench_random(&state) % n_words) / n_words];
+		len = strlen(word);
+		if (pos + len + 2 > size)
+			break;
+
+		memcpy(data + pos, word, len);
+		if (capital == true)
+			data[pos] -= 'a' - 'A';
+		pos += len;
+		line += len + 1;
+
+		capital = (bench_random(&state) % 12 == 0);
+		if (capital == true)
+			data[pos++] = (bench_random(&state) % 4 == 0)?(','):('.');
+		data[pos++] = (line > 72)?('\n'):(' ');
+		if (line > 72)
+			line = 0;
+	}
+
+	// the remaining bytes close the last line
+	memset(data + pos, '\n', size - pos);
+}
+
+void generate_logs (uint8_t* data, size_t size)
+{
+	static const char* levels[] = { "INFO", "INFO", "INFO", "DEBUG", "DEBUG", "WARN", "ERROR" };
+	static const char* modules[] = { "http", "db", "cache", "auth", "scheduler" };
+	static const char* messages[] = {
+		"request served", "query executed", "cache miss", "cache hit", "session opened", "session closed",
+		"job started", "job completed", "connection reset by peer", "slow query",
+	};
+	uint64_t state = BENCH_SEED;
+	uint64_t millis = 0, id = 1000000;
+	size_t pos = 0;
+	char line[256];
+	int len;
+
+	while (pos < size) {
+		millis += bench_random(&state) % 50;
+		id += 1 + bench_random(&state) % 3;
+		len = snprintf(line, sizeof(line), "2015-06-%02d %02d:%02d:%02d.%03d [%s] %s: %s id=%" PRIu64 " client=10.%d.%d.%d latency=%dms\n",
+				1 + (int)(millis / 86400000 % 30), (int)(millis / 3600000 % 24), (int)(millis / 60000 % 60), (int)(millis / 1000 % 60), (int)(millis % 1000),
+				levels[bench_random(&state) % 7], modules[bench_random(&state) % 5], messages[bench_random(&state) % 10], id,
+				(int)(bench_random(&state) % 4), (int)(bench_random(&state) % 16), (int)(bench_random(&state) % 256), (int)(bench_random(&state) % 500));
+		if (pos + len > size)
+			len = (int)(size - pos);
+		memcpy(data + pos, line, len);
+		pos += len;
+	}
+}
+
+void generate_binary (uint8_t* data, size_t size)
+{
+	uint64_t state = BENCH_SEED;
+	uint32_t id = 0;
+	float value = 100.0f;
+	uint8_t record[32];
+	size_t pos = 0, len;
+
+	while (pos < size) {
+		// a little endian identifier, a type, a flag, a value and a zero padding
+		memset(record, 0, sizeof(record));
+		id += 1 + bench_random(&state) % 4;
+		record[0] = id;
+		record[1] = id >> 8;
+		record[2] = id >> 16;
+		record[3] = id >> 24;
+		record[4] = bench_random(&state) % 6;
+		record[5] = (bench_random(&state) % 8 == 0);
+		value += (float)((int)(bench_random(&state) % 201) - 100) / 100.0f;
+		memcpy(record + 8, &value, sizeof(float));
+		record[12] = bench_random(&state) % 256;
+
+		len = (size - pos < sizeof(record))?(size - pos):(sizeof(record));
+		memcpy(data + pos, record, len);
+		pos += len;
+	}
+}
+
+void generate_random (uint8_t* data, size_t size)
+{
+	uint64_t state = BENCH_SEED, r;
+	size_t pos;
+
+	for (pos = 0; pos + sizeof(uint64_t) <= size; pos += sizeof(uint64_t)) {
+		r = bench_random(&state);
+		memcpy(data + pos, &r, sizeof(uint64_t));
+	}
+	for (; pos < size; pos++)
+		data[pos] = bench_random(&state);
+}
+
+void generate_runs (uint8_t* data, size_t size)
+{
+	uint64_t state = BENCH_SEED;
+	size_t pos = 0, len;
+
+	while (pos < size) {
+		// a few symbols, with runs from 1 to 4096 bytes, most of them short
+		len = 1 + (bench_random(&state) % 4096) * (bench_random(&state) % 4096) / 4096;
+		if (len > size - pos)
+			len = size - pos;
+		memset(data + pos, 'a' + (int)(bench_random(&state) % 8), len);
+		pos += len;
+	}
+}
@@ -11,18 +11,24 @@
 #include <fcntl.h>
 #include <string.h>
 #include <endian.h>
-#include <fcntl.h>
 #include <unistd.h>
 
-#define BUF_SIZE 16
+#define BIT_SLACK	16				// zeroed bytes after the buffer, so that a datum can always be loaded and stored with whole 64 bits words
 
 typedef struct bit_file {
-	int fd;						// the file descriptor
+	int fd;						// the file descriptor (-1 for a memory bit file)
+	uint8_t* mem;				// the memory area of a memory bit file (NULL for a file)
+	size_t mem_size;			// size (in bytes) of the memory area
+	size_t mem_pos;				// next byte of the memory area to be read or written
+	size_t bytes;				// number of bytes moved between the buffer and the file
 	bool reading;				// flag indicating reading mode (writing if false)
-	int next;					// next buffer bit
-	int end;					// end buffer bit
-	int size;					// number of buffer's bits
-	uint64_t buf[BUF_SIZE];		// the buffer
+	bool stream;				// flag indicating a stream bit file, whose bytes are fed and taken by the caller
+	ssize_t (*io) (void* arg, void* data, size_t len);	// the function reading or writing the bytes instead of the system calls, or NULL
+	void* io_arg;				// the argument of io
+	size_t next;				// next buffer bit
+	size_t end;					// end buffer bit
+	size_t size;				// number of buffer's bits
+	uint8_t* buf;				// the buffer, followed by BIT_SLACK zeroed bytes
 } BIT_FILE;
 
 /**
@@ -33,10 +39,66 @@ typedef struct bit_file {
  */
 int bit_flush (BIT_FILE* bf);
 
+/**
+ * @brief It writes the complete bytes of the buffer (and the last incomplete one, if final) to the file,
+ * 		and moves the remaining bits to the beginning of the buffer
+ *
+ * @param bf the pointer to the data structure where the data will be written
+ * @param final flag telling to write also the last incomplete byte, padded with zeros
+ * @return int a flag indicating if the operation has been completed successfully (0) or if an error occurs (-1)
+ */
+int bit_drain_buffer (BIT_FILE* bf, bool final);
+
+/**
+ * @brief It discards the first bytes of the buffer, moving the following ones to the beginning of the buffer
+ *
+ * @param bf the pointer to the bit file structure
+ * @param len the number of bytes to be discarded
+ * @return void
+ */
+void bit_shift (BIT_FILE* bf, size_t len);
+
+/**
+ * @brief It discards the bytes of the buffer already read, and fills the buffer again from the file
+ *
+ * @param bf the pointer to the bit file structure
+ * @return int a flag indicating if the operation has been completed successfully (0) or if an error occurs (-1)
+ */
+int bit_refill (BIT_FILE* bf);
+
+/**
+ * @brief It allocates and initializes the bit file structure, without binding it to a file or to a memory area
+ *
+ * @param mode the desired opening mode, which can be "r" (read) or "w" (write)
+ * @param size the size (in bytes) of the buffer
+ * @return BIT_FILE* pointer to the structure allocated in the dynamic memory, or NULL if an error occurs
+ */
+BIT_FILE* bit_alloc (char* mode, size_t size);
+
+/**
+ * @brief It fills the buffer area pointed by data, by reading from the file or from the memory area
+ *
+ * @param bf the pointer to the bit file structure
+ * @param data the destination area
+ * @param len the number of bytes to be read
+ * @return ssize_t the number of bytes read (0 at the end of the file) or -1 if an error occurs
+ */
+ssize_t bit_fill (BIT_FILE* bf, void* data, size_t len);
+
+/**
+ * @brief It drains the buffer area pointed by data, by writing to the file or to the memory area
+ *
+ * @param bf the pointer to the bit file structure
+ * @param data the source area
+ * @param len the number of bytes to be written
+ * @return ssize_t the number of bytes written or -1 if an error occurs
+ */
+ssize_t bit_drain (BIT_FILE* bf, void* data, size_t len);
+
 BIT_FILE* bit_open(char* name, char* mode)
 {
 	BIT_FILE* bf;
-	int size;
+	int fd;
 
 	// check that parameters are correct
 	if (name == NULL)
@@ -48,19 +110,104 @@ BIT_FILE* bit_open(char* name, char* mode)
 	// check that the mode specified as parameter is acceptable (only "r" and "w" permitted)
 	if ((strcmp(mode, "r") != 0) && (strcmp(mode, "w") != 0))
 		return NULL;
-	
-	// allocation of the bit file data structure and set all bytes to 0
-	bf = calloc(1, sizeof(BIT_FILE));
 
-	// check that the allocation succeed
+	// opening the file in the specified mode and check that the operation succeed
+	fd = open(name, (mode[0] == 'r') ? (O_RDONLY) : (O_WRONLY | O_CREAT | O_TRUNC), S_IRWXU);
+	if (fd < 0)
+		return NULL;
+
+	bf = bit_fdopen(fd, mode);
 	if (bf == NULL)
+		close(fd);
+
+	return bf;
+}
+
+BIT_FILE* bit_fdopen (int fd, char* mode)
+{
+	BIT_FILE* bf;
+
+	if (fd < 0)
 		return NULL;
 
-	// opening the file in the specified mode and check that the operation succeed
-	bf->fd = open(name, (mode[0] == 'r') ? (O_RDONLY) : (O_WRONLY | O_CREAT | O_TRUNC), S_IRWXU);
-	if (bf->fd < 0)
+	bf = bit_alloc(mode, BIT_BUFFER_SIZE);
+	if (bf == NULL)
 		return NULL;
-	
+
+	bf->fd = fd;
+
+	return bf;
+}
+
+BIT_FILE* bit_open_mem (void* mem, size_t size, char* mode)
+{
+	BIT_FILE* bf;
+
+	if (mem == NULL)
+		return NULL;
+
+	bf = bit_alloc(mode, BIT_SMALL_BUFFER_SIZE);
+	if (bf == NULL)
+		return NULL;
+
+	bf->fd = -1;
+	bf->mem = mem;
+	bf->mem_size = size;
+	bf->mem_pos = 0;
+
+	return bf;
+}
+
+int bit_reopen_mem (BIT_FILE* bf, void* mem, size_t size)
+{
+	if (bf == NULL || bf->mem == NULL || mem == NULL)
+		return -1;
+
+	// the last bits written belong to the previous area
+	if (bf->reading == false && bit_flush(bf) < 0)
+		return -1;
+
+	// the buffer starts again empty and zeroed, as a new one
+	memset(bf->buf, 0, (bf->size / 8) + BIT_SLACK);
+	bf->next = 0;
+	bf->end = (bf->reading == true)?(0):(bf->size);
+	bf->bytes = 0;
+
+	bf->mem = mem;
+	bf->mem_size = size;
+	bf->mem_pos = 0;
+
+	return 0;
+}
+
+BIT_FILE* bit_open_stream (char* mode)
+{
+	BIT_FILE* bf;
+
+	bf = bit_alloc(mode, BIT_SMALL_BUFFER_SIZE);
+	if (bf == NULL)
+		return NULL;
+
+	bf->fd = -1;
+	bf->stream = true;
+
+	return bf;
+}
+
+BIT_FILE* bit_alloc (char* mode, size_t size)
+{
+	BIT_FILE* bf;
+
+	if (mode == NULL)
+		return NULL;
+
+	// check that the mode specified as parameter is acceptable (only "r" and "w" permitted)
+	if ((strcmp(mode, "r") != 0) && (strcmp(mode, "w") != 0))
+		return NULL;
+
+	// allocation of the bit file data structure and set all bytes to 0
+	bf = calloc(1, sizeof(BIT_FILE));
+
 	// check that the allocation succeed
 	if (bf == NULL)
 		return NULL;
@@ -68,25 +215,57 @@ BIT_FILE* bit_open(char* name, char* mode)
 	// setting the reading flag
 	bf->reading = (mode[0] == 'r')?(true):(false);
 
-	// setting the size (in bits) of the buffer
-	size = sizeof(bf->buf) * 8;
-
-	// if reading, the parameter "end" is set to 0, because the buffer is empty right now
-	if (bf->reading == true) {
-		bf->next = 0;
-		bf->end = 0;
-		bf->size = size;
-	}
-	// if writing, the parameter "end" is set to the size of the buffer
-	else {
-		bf->next = 0;
-		bf->end = size;
-		bf->size = size;
+	if (bit_set_buffer(bf, size) < 0) {
+		free(bf);
+		return NULL;
 	}
 
 	return bf;
 }
 
+int bit_set_io (BIT_FILE* bf, ssize_t (*io) (void* arg, void* data, size_t len), void* arg)
+{
+	// checking parameters: only a bit file bound to a file, which hasn't moved any byte yet
+	if (bf == NULL || bf->fd < 0 || io == NULL || (bf->reading == false && (bf->bytes > 0 || bf->next > 0)))
+		return -1;
+
+	bf->io = io;
+	bf->io_arg = arg;
+
+	return 0;
+}
+
+int bit_set_buffer (BIT_FILE* bf, size_t size)
+{
+	uint8_t* buf;
+
+	// checking parameters
+	if (bf == NULL || size < BIT_MIN_BUFFER_SIZE || size > BIT_MAX_BUFFER_SIZE)
+		return -1;
+
+	// the buffer can be replaced only while it holds no data
+	if (bf->buf != NULL && (bf->next > 0 || (bf->reading == true && bf->end > 0)))
+		return -1;
+
+	// the buffer holds whole 64 bits words
+	size = (size + 7) & ~(size_t)7;
+
+	buf = calloc(1, size + BIT_SLACK);
+	if (buf == NULL)
+		return -1;
+
+	free(bf->buf);
+	bf->buf = buf;
+	bf->size = size * 8;
+	bf->next = 0;
+
+	// if reading, the parameter "end" is set to 0, because the buffer is empty right now,
+	// if writing, the parameter "end" is set to the size of the buffer
+	bf->end = (bf->reading == true)?(0):(bf->size);
+
+	return 0;
+}
+
 int bit_close (BIT_FILE* bf)
 {
 	int result;
@@ -95,112 +274,85 @@ int bit_close (BIT_FILE* bf)
 		return -1;
 
 	// if writing, we need to poor the buffer by performing a bit_flush, in order to write the entire buffer into the file
-	if (bf->reading == false) {
+	// (the bytes of a stream bit file are taken by the caller)
+	if (bf->reading == false && bf->stream == false) {
 		result = bit_flush(bf);
 		if (result < 0)
 			goto error;
 	}
 
-	// effectively closing the bit file and check that the operation succeed
-	result = close(bf->fd);
-	if (result < 0)
-		goto error;
+	// effectively closing the bit file and check that the operation succeed (memory and stream bit files have nothing to close)
+	if (bf->fd >= 0) {
+		result = close(bf->fd);
+		if (result < 0)
+			goto error;
+	}
 
 	// deallocation of the dynamic memory
+	free(bf->buf);
 	free(bf);
 	
 	return 0;
 	
 error:
+	free(bf->buf);
 	free(bf);
 	return -1;
 }
 
 int bit_read(BIT_FILE* bf, uint64_t* data, int len)
 {
-	int remaining_row_bits1, remaining_row_bits2, result, offset, available_bits;
-	uint64_t* buffer_row;
-	uint64_t tmp1, tmp2;
-	
-	// flag used to handle the case of multiple read
-	bool repeat_flag;
-
-	repeat_flag = false;
+	int offset;
+	uint8_t* bytes;
+	uint64_t tmp;
 	
 	// Checking parameters
-	if (bf == NULL || len < 1 || len > (8* sizeof(data)))
+	if (bf == NULL || len < 1 || len > (8* sizeof(*data)))
 			return -1;
 
 	// check that the we are in the case of a reading operation
 	if (bf->reading == false)
 		return -1;
 
-	while (len > 0) {
-
-		// computing the number of bits still in the buffer
-		available_bits = (bf->end - bf->next);
-
-		// if there are no available bits to be read
-		if (available_bits == 0 || bf->next == 0) {
-
-			// try to fill the buffer
-			// reading operation and check that succeed
-			result = (int)read(bf->fd, bf->buf, sizeof(bf->buf));
-			if (result < 0)
-				return -1;
-
-			// updating values of the data structure
- 			bf->next = 0;
-			bf->end = (result * 8);
-		}
-
-		// buffer_row is the pointer to the row of the buffer where the bit from which to start reading is placed
-		buffer_row = bf->buf + (bf->next / 64);
-		
-		// is the offset of the bit inside the buffer row
-		offset = bf->next % 64;
-		
-		// the remaining bits of the buffer row to read
-		remaining_row_bits1 = 64 - offset;
+	// if the datum is not entirely in the buffer, try to fill the buffer
+	if (bf->end - bf->next < len) {
 
-		// check that we read at most len bits
-		if (len < remaining_row_bits1)
-			remaining_row_bits1 = len;
+		// the bytes of a stream bit file are fed by the caller
+		if (bf->stream == true)
+			return 1;
 
-		// convert the buffer row from little endian to host format
-		tmp1 = le64toh(*buffer_row);
-		
-		// shift right the buffer row of offset bits
-		tmp1 >>= offset;
-
-		// apply a mask to read the remaining bits of the data
-		tmp1 &= (((uint64_t)1 << len)-1);
+		if (bit_refill(bf) < 0)
+			return -1;
 
-		// Update the data structure
-		bf->next = (bf->next + remaining_row_bits1) % bf->end;
-		len -= remaining_row_bits1;
+		// the file ends in the middle of the datum
+		if (bf->end - bf->next < len)
+			return -1;
+	}
 
-		// handle the case that the datum is placed on multiple rows of the buffer
-		if (len > 0) {
-			repeat_flag = true;
-			tmp2 = tmp1;
-			remaining_row_bits2 = remaining_row_bits1;
-		}
+	// bytes points to the byte of the buffer where the bit from which to start reading is placed
+	bytes = bf->buf + (bf->next / 8);
+	
+	// is the offset of the bit inside the byte
+	offset = bf->next % 8;
+	
+	// load the 64 bits word starting at that byte (the slack makes it always readable),
+	// convert it from little endian to host format, and shift it right of offset bits
+	memcpy(&tmp, bytes, sizeof(tmp));
+	tmp = le64toh(tmp) >> offset;
 
-	}
+	// handle the case that the datum is longer than the remaining bits of the word: the following byte is concatenated
+	if (offset + len > 64)
+		tmp |= (uint64_t)bytes[8] << (64 - offset);
 
-	// if we are in the case of a repetition in the reading operation
-	// we need to shift the new data and concatenate the old ones
-	if (repeat_flag == true){
-		tmp1 = tmp1 << remaining_row_bits2;
-		tmp1 = (tmp1|tmp2);
-	}
+	// apply a mask to read only len bits
+	if (len < 64)
+		tmp &= (((uint64_t)1 << len)-1);
 
-	// convert back from host to little endian format
-	tmp1 = htole64(tmp1);
+	// Update the data structure
+	bf->next += len;
 
 	// assign the read values to data
-	*data = tmp1;
+	*data = tmp;
 
 	// check if the read data is EOS
 	if (*data == EOS)
@@ -211,13 +363,9 @@ int bit_read(BIT_FILE* bf, uint64_t* data, int len)
 
 int bit_write(BIT_FILE* bf, uint64_t* data, int len)
 {
-	//static int count = 0;
-	//bit_print_data(data, "0x%03x", &count);
-
-	int space, offset, result, remaining_row_bits;
-
-	uint64_t* buffer_row;
-	uint64_t tmp;
+	int offset;
+	uint8_t* bytes;
+	uint64_t tmp, word;
 
 	// checking parameters
 	if (bf == NULL || len < 1 || len > (8* sizeof(*data)))
@@ -227,62 +375,45 @@ int bit_write(BIT_FILE* bf, uint64_t* data, int len)
 	if (bf->reading == true)
 		return -1;
 
-	while (len > 0) {
-		
-		// computing the available space in the buffer
-		space = bf->end - bf->next;
-		if (space < 0) {
-			printf("Error here!\n");
+	// if the datum doesn't fit in the buffer, flush the complete bytes to the file
+	if (bf->end - bf->next < len) {
+
+		// the bytes of a stream bit file are taken by the caller
+		if (bf->stream == true)
+			return 1;
+
+		if (bit_drain_buffer(bf, false) < 0)
 			return -1;
-		}
+	}
 
-		// if buffer is full, flush data to file and reinit BIT_IO struct
-		if (space == 0) {
-			result = bit_flush(bf);
-			if (result < 0)
-				return -1;
-		}
-		
-		// which buffer row
-		buffer_row = bf->buf + (bf->next/64);
-		
-		// offset inside the row
-		offset = bf->next % 64;
-		
-		// how many bits
-		remaining_row_bits = 64 - offset;
-		
-		// put at most len bits into the buffer
-		if (len < remaining_row_bits)
-			remaining_row_bits = len;
+	// put at most len bits into the buffer
+	tmp = *data;
+	if (len < 64)
+		tmp &= (((uint64_t)1 << len)-1);
 
-		// convert from little endian to host format
-		tmp = le64toh(*buffer_row);
-		
-		// shift and concatenate data by offset bits
-		tmp |= ((*data) << offset);
-		
-		// convert back from host to little endian format
-		*buffer_row = htole64(tmp);
+	// which byte of the buffer
+	bytes = bf->buf + (bf->next / 8);
+	
+	// offset inside the byte
+	offset = bf->next % 8;
+	
+	// the bits after next are zero: load the 64 bits word starting at that byte, concatenate data by offset bits and store it back
+	memcpy(&word, bytes, sizeof(word));
+	word = htole64(le64toh(word) | (tmp << offset));
+	memcpy(bytes, &word, sizeof(word));
 
-		// update the bit file structure
-		bf->next += remaining_row_bits;
-		
-		// compute how many bits still to write
-		len -= remaining_row_bits;
-		
-		// shift right data of remaining_row_bits
-		*data >>= remaining_row_bits;
-		
-	}
+	// handle the case that the datum is longer than the remaining bits of the word: the high bits go to the following byte
+	if (offset + len > 64)
+		bytes[8] |= (uint8_t)(tmp >> (64 - offset));
+
+	// update the bit file structure
+	bf->next += len;
 
 	return 0;
 }
 
 int bit_flush(BIT_FILE* bf)
 {
-	int size, align, result, i;
-
 	// Checking parameters
 	if (bf == NULL)
 			return -1;
@@ -291,28 +422,232 @@ int bit_flush(BIT_FILE* bf)
 	if (bf->reading == true)
 		return -1;
 
-	// align to byte
-	align = ((bf->next % 8) > 0)?(1):(0);
-	
-	// data size in byte
-	size = (bf->next / 8) + align;
+	return bit_drain_buffer(bf, true);
+}
+
+int bit_drain_buffer (BIT_FILE* bf, bool final)
+{
+	size_t size;
+
+	// data size in byte, aligned to byte if final
+	size = bf->next / 8;
+	if (final == true && (bf->next % 8) > 0)
+		size++;
+
+	if (size == 0)
+		return 0;
+
+	// write to file the data and check that the operation succeed
+	if (bit_drain(bf, bf->buf, size) < 0)
+		return -1;
+
+	bit_shift(bf, size);
+
+	return 0;
+}
+
+void bit_shift (BIT_FILE* bf, size_t len)
+{
+	uint8_t* bytes;
+	size_t used;
+
+	if (len == 0)
+		return;
+
+	bytes = bf->buf;
+
+	// the bytes of the buffer are in file order
+	used = (bf->reading == true)?(bf->end / 8):((bf->next + 7) / 8);
+	if (len > used)
+		len = used;
+
+	memmove(bytes, bytes + len, used - len);
+	memset(bytes + used - len, 0, (bf->size / 8) - (used - len));
+
+	bf->next = (bf->next > len * 8)?(bf->next - len * 8):(0);
+	if (bf->reading == true)
+		bf->end -= len * 8;
+}
+
+int bit_refill (BIT_FILE* bf)
+{
+	ssize_t result;
+
+	// discard the complete bytes already read
+	bit_shift(bf, bf->next / 8);
+
+	// read until the buffer is full or the file ends
+	while (bf->end < bf->size) {
+		result = bit_fill(bf, bf->buf + (bf->end / 8), (bf->size - bf->end) / 8);
+		if (result < 0)
+			return -1;
+		if (result == 0)
+			break;
+		bf->end += result * 8;
+	}
+
+	return 0;
+}
 
-	// write to file the remaining data and check that the operation succeed
-	result = (int)write(bf->fd, bf->buf, size);
-	if (result < 0)
+size_t bit_feed (BIT_FILE* bf, const void* data, size_t len)
+{
+	size_t space;
+
+	if (bf == NULL || bf->reading == false || (bf->stream == false && bf->mem != NULL))
+		return 0;
+
+	// discard the complete bytes already read, to make room for the new ones
+	bit_shift(bf, bf->next / 8);
+
+	space = (bf->size - bf->end) / 8;
+	if (len > space)
+		len = space;
+
+	memcpy(bf->buf + (bf->end / 8), data, len);
+	bf->end += len * 8;
+	bf->bytes += len;
+
+	return len;
+}
+
+size_t bit_take (BIT_FILE* bf, void* data, size_t len, bool final)
+{
+	size_t size;
+
+	if (bf == NULL || bf->reading == true || bf->stream == false)
+		return 0;
+
+	// complete bytes, and the last incomplete one if final
+	size = bf->next / 8;
+	if (final == true && (bf->next % 8) > 0)
+		size++;
+
+	if (len > size)
+		len = size;
+
+	memcpy(data, bf->buf, len);
+	bf->bytes += len;
+	bit_shift(bf, len);
+
+	return len;
+}
+
+ssize_t bit_fill (BIT_FILE* bf, void* data, size_t len)
+{
+	ssize_t result;
+
+	// file: a single read system call, or the function replacing it
+	if (bf->io != NULL) {
+		result = bf->io(bf->io_arg, data, len);
+	}
+	else if (bf->mem == NULL) {
+		result = read(bf->fd, data, len);
+	}
+	// memory: copy at most the remaining bytes of the area
+	else {
+		if (len > bf->mem_size - bf->mem_pos)
+			len = bf->mem_size - bf->mem_pos;
+
+		memcpy(data, bf->mem + bf->mem_pos, len);
+		bf->mem_pos += len;
+		result = len;
+	}
+
+	if (result > 0)
+		bf->bytes += result;
+
+	return result;
+}
+
+ssize_t bit_drain (BIT_FILE* bf, void* data, size_t len)
+{
+	ssize_t result;
+	size_t done;
+
+	// file: the function replacing the system calls takes all the data at once
+	if (bf->io != NULL) {
+		if (bf->io(bf->io_arg, data, len) < 0)
+			return -1;
+	}
+	// file: write system calls until all the data is written
+	else if (bf->mem == NULL) {
+		for (done = 0; done < len; done += result) {
+			result = write(bf->fd, (uint8_t*)data + done, len - done);
+			if (result < 0)
+				return -1;
+		}
+	}
+	// memory: the whole data has to fit in the remaining bytes of the area
+	else {
+		if (len > bf->mem_size - bf->mem_pos)
+			return -1;
+
+		memcpy(bf->mem + bf->mem_pos, data, len);
+		bf->mem_pos += len;
+	}
+
+	bf->bytes += len;
+
+	return len;
+}
+
+int bit_seek (BIT_FILE* bf, uint64_t offset)
+{
+	// checking parameters
+	if (bf == NULL || bf->reading == false || bf->stream == true || bf->io != NULL)
 		return -1;
 
-	// update the value of the data structure
+	// moving to the byte containing the bit
+	if (bf->mem == NULL) {
+		if (lseek(bf->fd, offset / 8, SEEK_SET) < 0)
+			return -1;
+	}
+	else {
+		if (offset / 8 > bf->mem_size)
+			return -1;
+		bf->mem_pos = offset / 8;
+	}
+	bf->bytes = offset / 8;
+
+	// emptying the buffer: the next bit_read fills it
 	bf->next = 0;
-	bf->end = bf->size;
-	
-	// set the buffer to 0
-	for (i = 0; i < (bf->size / 64); i++)
-		bf->buf[i] = 0;
+	bf->end = 0;
+	if ((offset % 8) == 0)
+		return 0;
+
+	// otherwise the buffer is filled now, and the first bits of the byte are skipped
+	if (bit_refill(bf) < 0 || bf->end == 0)
+		return -1;
+
+	bf->next = offset % 8;
 
 	return 0;
 }
 
+size_t bit_length (BIT_FILE* bf)
+{
+	if (bf == NULL)
+		return 0;
+
+	// the bits still in the buffer will take (next / 8) bytes, plus one for the last incomplete byte
+	if (bf->reading == false)
+		return bf->bytes + (bf->next / 8) + (((bf->next % 8) > 0)?(1):(0));
+
+	return bf->bytes;
+}
+
+uint64_t bit_tell (BIT_FILE* bf)
+{
+	if (bf == NULL)
+		return 0;
+
+	// the bits of the buffer not read yet have been counted in bytes
+	if (bf->reading == true)
+		return (uint64_t)bf->bytes * 8 - (bf->end - bf->next);
+
+	return (uint64_t)bf->bytes * 8 + bf->next;
+}
+
 void bit_print_data(uint64_t data, char* format, int* count)
 {
 	printf(format, data);
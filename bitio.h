@@ -9,6 +9,13 @@
 
 #include "definitions.h"
 
+#include <sys/types.h>
+
+#define BIT_BUFFER_SIZE			(1024 * 1024)		// default size (in bytes) of the buffer of a bit file bound to a file
+#define BIT_SMALL_BUFFER_SIZE	(64 * 1024)			// default size (in bytes) of the buffer of a memory or stream bit file
+#define BIT_MIN_BUFFER_SIZE		64					// minimum size (in bytes) of the buffer
+#define BIT_MAX_BUFFER_SIZE		(1024 * 1024 * 1024)	// maximum size (in bytes) of the buffer
+
 /**
  * NOTE ON REPRESENTATION OF DATA
  * 
@@ -55,13 +62,77 @@ typedef struct bit_file BIT_FILE;
  */
 BIT_FILE* bit_open (char* name, char* mode);
 
+/**
+ * @brief It binds a bit file to an already opened file descriptor, which will be closed by bit_close
+ * 
+ * @param fd the file descriptor
+ * @param mode the desired opening mode, which can be "r" (read) or "w" (write)
+ * @return BIT_FILE* pointer to the structure allocated in the dynamic memory, or NULL if an error occurs
+ */
+BIT_FILE* bit_fdopen (int fd, char* mode);
+
+/**
+ * @brief It opens a bit file on a memory area, which is read or written in place and is not released by bit_close
+ * 
+ * @param mem the memory area
+ * @param size the size (in bytes) of the memory area: a write beyond it is an error
+ * @param mode the desired opening mode, which can be "r" (read) or "w" (write)
+ * @return BIT_FILE* pointer to the structure allocated in the dynamic memory, or NULL if an error occurs
+ */
+BIT_FILE* bit_open_mem (void* mem, size_t size, char* mode);
+
+/**
+ * @brief It binds a memory bit file to another memory area, keeping its mode and its buffer, so that a bit file
+ * 		can be used for many areas without allocating it again. In writing mode the last bits go to the previous area
+ * 		first, as with bit_close
+ * 
+ * @param bf the pointer to the memory bit file
+ * @param mem the new memory area
+ * @param size the size (in bytes) of the new memory area
+ * @return int a flag indicating if the bit file has been bound to the new area (0) or if an error occurs (-1)
+ */
+int bit_reopen_mem (BIT_FILE* bf, void* mem, size_t size);
+
+/**
+ * @brief It opens a stream bit file, which is not bound to a file: in reading mode the caller feeds the bytes with bit_feed,
+ * 		in writing mode the caller takes the bytes with bit_take
+ * 
+ * @param mode the desired opening mode, which can be "r" (read) or "w" (write)
+ * @return BIT_FILE* pointer to the structure allocated in the dynamic memory, or NULL if an error occurs
+ */
+BIT_FILE* bit_open_stream (char* mode);
+
+/**
+ * @brief It replaces the buffer of a bit file, which has to be done before the first bit_read, bit_write or bit_feed
+ * 
+ * @param bf the pointer to the bit file structure
+ * @param size the size (in bytes) of the new buffer, between BIT_MIN_BUFFER_SIZE and BIT_MAX_BUFFER_SIZE
+ * 		(rounded up to a multiple of 8): the larger it is, the fewer system calls are done
+ * @return int a flag indicating if the buffer has been replaced (0) or if an error occurs (-1)
+ */
+int bit_set_buffer (BIT_FILE* bf, size_t size);
+
+/**
+ * @brief It replaces the read or write system calls of a bit file bound to a file by a function, which moves the bytes
+ * 		from or to somewhere else (as the rings of a pipeline do); the file descriptor is still closed by bit_close, and
+ * 		bit_seek can't be used anymore. It has to be done before the first bit_read or bit_write (a bit_feed is allowed)
+ * 
+ * @param bf the pointer to the bit file structure
+ * @param io the function, which returns the number of bytes read (0 at the end of the file), or len if writing,
+ * 		or -1 if an error occurs
+ * @param arg the first argument of the function
+ * @return int a flag indicating if the function has been set (0) or if an error occurs (-1)
+ */
+int bit_set_io (BIT_FILE* bf, ssize_t (*io) (void* arg, void* data, size_t len), void* arg);
+
 /**
  * @brief It reads data from a bit file. 
  * 
  * @param bf the pointer to the structure to be read
  * @param data the pointer to the data where the read data will be placed
  * @param len the size (in bits) of the data to be read (at most 64 bits)
- * @return int a flag indicating if the read operation has been completed successfully (0) or if an error occurs (-1)
+ * @return int a flag indicating if the read operation has been completed successfully (0), if EOS is read (2),
+ * 		if a stream bit file needs more bytes (1, nothing is read) or if an error occurs (-1)
  */
 int bit_read (BIT_FILE* bf, uint64_t* data, int len);
 
@@ -71,10 +142,43 @@ int bit_read (BIT_FILE* bf, uint64_t* data, int len);
  * @param bf the pointer to the structure where the data will be written
  * @param data the the data to be written
  * @param len the size (in bits) of the data to be written (at most 64 bits)
- * @return int a flag indicating if the write operation has been completed successfully (0), if an error occurs (-1) or if EOS is reached (2)
+ * @return int a flag indicating if the write operation has been completed successfully (0),
+ * 		if the buffer of a stream bit file is full (1, nothing is written) or if an error occurs (-1)
  */
 int bit_write (BIT_FILE* bf, uint64_t* data, int len);
 
+/**
+ * @brief It appends bytes to the buffer of a stream bit file opened in reading mode. A bit file bound to a file
+ * 		can be fed too, before the first bit_read: the bytes are read before the ones of the file
+ * 		(as the ones already taken from a pipe, which can't seek back)
+ * 
+ * @param bf the pointer to the bit file structure
+ * @param data the bytes to be appended
+ * @param len the number of bytes available
+ * @return size_t the number of bytes appended, limited by the free space of the buffer
+ */
+size_t bit_feed (BIT_FILE* bf, const void* data, size_t len);
+
+/**
+ * @brief It moves the complete bytes out of the buffer of a stream bit file opened in writing mode
+ * 
+ * @param bf the pointer to the bit file structure
+ * @param data the destination area
+ * @param len the size (in bytes) of the destination area
+ * @param final flag telling to take also the last incomplete byte, padded with zeros (after the last bit_write)
+ * @return size_t the number of bytes moved
+ */
+size_t bit_take (BIT_FILE* bf, void* data, size_t len, bool final);
+
+/**
+ * @brief It moves the reading position of a bit file, so that the next bit_read starts from the specified bit
+ * 
+ * @param bf the pointer to the bit file structure, opened in reading mode on a memory area or on a seekable file
+ * @param offset the position (in bits, from the beginning of the file) of the next bit to be read
+ * @return int a flag indicating if the seek operation has been completed successfully (0) or if an error occurs (-1)
+ */
+int bit_seek (BIT_FILE* bf, uint64_t offset);
+
 /**
  * @brief It closes the bit file
  * 
@@ -83,6 +187,23 @@ int bit_write (BIT_FILE* bf, uint64_t* data, int len);
  */
 int bit_close (BIT_FILE* bf);
 
+/**
+ * @brief It returns the number of bytes read from the bit file, or written to it (counting also the bytes still in the buffer)
+ * 
+ * @param bf the pointer to the bit file structure
+ * @return size_t the number of bytes
+ */
+size_t bit_length (BIT_FILE* bf);
+
+/**
+ * @brief It returns the number of bits written to a bit file opened in writing mode, the ones still in the buffer included,
+ * 		or the position of the next bit to be read from a bit file opened in reading mode
+ * 
+ * @param bf the pointer to the bit file structure
+ * @return uint64_t the number of bits, which is also the position of the next bit to be written (or read)
+ */
+uint64_t bit_tell (BIT_FILE* bf);
+
 /**
  * @brief print the content of a bit file to the standard output
  * 
@@ -0,0 +1,470 @@
+/*
+ * blocks.c
+ * Francesco Piras - Dario Varano
+ * June 2015
+ */
+
+#include "blocks.h"
+#include "threadpool.h"
+#include "bitio.h"
+#include "checksum.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#define BLOCKS_PER_THREAD	2				// blocks of a batch for every worker thread
+
+/**
+ * @brief A block and its compressed form
+ * 
+ */
+typedef struct block_struct {
+	uint8_t* raw;				// uncompressed data
+	size_t raw_size;			// number of uncompressed bytes
+	uint8_t* packed;			// compressed data
+	size_t packed_size;			// number of compressed bytes
+	size_t packed_max;			// capacity of the compressed data area
+	OPTIONS options;			// parameters of the stream of the block
+	LZ78_STATS stats;			// statistics of the stream of the block
+	int result;					// outcome of the last task on the block (0 or -1)
+	LZ78_STREAM** streams;		// the streams of the worker threads, reused by all the blocks they process
+} BLOCK;
+
+/**
+ * @brief Two batches of blocks: while the worker threads process one, the other one is read or written
+ * 
+ */
+typedef struct batches_struct {
+	BLOCK* blocks;				// all the blocks (2 * size)
+	int size;					// number of blocks of a batch
+	THREAD_POOL* pool;			// the worker threads
+	LZ78_STREAM** streams;		// the stream of every worker thread, or NULL before its first block
+	int threads;				// number of worker threads
+} BATCHES;
+
+/**
+ * @brief It allocates the batches and starts the worker threads
+ * 
+ * @param batches the pointer to the structure to be initialized
+ * @param threads the number of worker threads
+ * @param block_size the size of the blocks
+ * @param options the parameters of the streams of the blocks
+ * @return int a flag indicating if the allocation has been completed successfully (0) or if an error occurs (-1)
+ */
+int batches_alloc (BATCHES* batches, int threads, size_t block_size, OPTIONS* options);
+
+/**
+ * @brief It waits for the worker threads and deallocates the batches
+ * 
+ * @param batches the pointer to the structure to be deallocated
+ * @return void
+ */
+void batches_free (BATCHES* batches);
+
+/**
+ * @brief It returns the stream of the worker thread running a block task, bound to the bit file of the block:
+ * 		the first block of the thread allocates it, the following ones reset it, so that its dictionary is allocated
+ * 		(or mapped from the image of a preset dictionary) only once
+ * 
+ * @param block the pointer to the block
+ * @param bf the bit file of the codes of the block
+ * @param compressing flag indicating a compression stream (decompression if false)
+ * @return LZ78_STREAM* the pointer to the stream, or NULL if an error occurs
+ */
+LZ78_STREAM* block_stream (BLOCK* block, BIT_FILE* bf, bool compressing);
+
+/**
+ * @brief The task compressing a block
+ * 
+ * @param arg the pointer to the block
+ * @return void
+ */
+void block_compress_task (void* arg);
+
+/**
+ * @brief The task decompressing a block
+ * 
+ * @param arg the pointer to the block
+ * @return void
+ */
+void block_decompress_task (void* arg);
+
+/**
+ * @brief It writes a block table entry followed by the compressed block
+ * 
+ * @param fd the output file descriptor
+ * @param block the pointer to the block
+ * @return int a flag indicating if the write operation has been completed successfully (0) or if an error occurs (-1)
+ */
+int block_write (int fd, BLOCK* block);
+
+/**
+ * @brief It reads a block table entry followed by the compressed block
+ * 
+ * @param fd the input file descriptor
+ * @param block the pointer to the block
+ * @param block_size the maximum uncompressed size of a block
+ * @return int a flag indicating if a block has been read (0), if the terminating entry has been read (1) or if an error occurs (-1)
+ */
+int block_read (int fd, BLOCK* block, size_t block_size);
+
+int blocks_compress (char* input, char* output, OPTIONS* options, LZ78_STATS* stats)
+{
+	BATCHES batches;
+	BLOCK* current;
+	BLOCK* next;
+	BLOCK* tmp;
+	HEADER header;
+	uint8_t entry[BLOCK_ENTRY_SIZE];
+	int in, out, i, current_count, next_count;
+	size_t block_size;
+	ssize_t result;
+	
+	block_size = (options->block_size > 0)?(options->block_size):(DEFAULT_BLOCK_SIZE);
+	
+	if (stats != NULL)
+		memset(stats, 0, sizeof(LZ78_STATS));
+	
+	// opening the input and the output files
+	in = open_input(input);
+	if (in < 0)
+		return -1;
+	
+	out = open_output(output);
+	if (out < 0) {
+		close(in);
+		return -1;
+	}
+	
+	if (batches_alloc(&batches, options->threads, block_size, options) < 0) {
+		close(in);
+		close(out);
+		return -1;
+	}
+	
+	// writing the header
+	header_init(&header, options, HEADER_FLAG_BLOCKS, block_size);
+	if (header_write(out, &header) < 0)
+		goto error;
+	
+	current = batches.blocks;
+	next = batches.blocks + batches.size;
+	current_count = 0;
+	
+	do {
+		// reading the next batch while the worker threads compress the current one
+		for (next_count = 0; next_count < batches.size; next_count++) {
+			result = read_full(in, next[next_count].raw, block_size);
+			if (result < 0)
+				goto error;
+			if (result == 0)
+				break;
+			next[next_count].raw_size = result;
+		}
+		
+		thread_pool_wait(batches.pool);
+		
+		for (i = 0; i < next_count; i++) {
+			if (thread_pool_submit(batches.pool, block_compress_task, &next[i]) < 0)
+				goto error;
+		}
+		
+		// writing the current batch, in order, while the worker threads compress the next one
+		for (i = 0; i < current_count; i++) {
+			if (current[i].result < 0)
+				goto error;
+			if (block_write(out, &current[i]) < 0)
+				goto error;
+			lz78_stats_add(stats, &current[i].stats);
+		}
+		
+		tmp = current;
+		current = next;
+		next = tmp;
+		current_count = next_count;
+		
+	} while (current_count > 0);
+	
+	// writing the terminating entry
+	put_le32(entry, 0);
+	put_le32(entry + 4, 0);
+	if (write_full(out, entry, BLOCK_ENTRY_SIZE) < 0)
+		goto error;
+	
+	batches_free(&batches);
+	close(in);
+	
+	return (close(out) < 0)?(-1):(0);
+	
+error:
+	batches_free(&batches);
+	close(in);
+	close(out);
+	return -1;
+}
+
+int blocks_decompress (int in, char* output, HEADER* header, OPTIONS* options, LZ78_STATS* stats)
+{
+	BATCHES batches;
+	OPTIONS block_options;
+	BLOCK* current;
+	BLOCK* next;
+	BLOCK* tmp;
+	int out, i, threads, current_count, next_count, result;
+	bool last;
+	
+	if (header->block_size == 0)
+		return -1;
+	
+	threads = (options->threads > 0)?(options->threads):(thread_pool_default_size());
+	
+	if (stats != NULL)
+		memset(stats, 0, sizeof(LZ78_STATS));
+	
+	out = open_output(output);
+	if (out < 0)
+		return -1;
+	
+	// the parameters of the blocks are the ones of the header
+	block_options = *options;
+	header_options(header, &block_options);
+	
+	if (batches_alloc(&batches, threads, header->block_size, &block_options) < 0) {
+		close(out);
+		return -1;
+	}
+	
+	current = batches.blocks;
+	next = batches.blocks + batches.size;
+	current_count = 0;
+	last = false;
+	
+	do {
+		// reading the next batch while the worker threads decompress the current one
+		next_count = 0;
+		while (last == false && next_count < batches.size) {
+			result = block_read(in, &next[next_count], header->block_size);
+			if (result < 0)
+				goto error;
+			if (result == 1)
+				last = true;
+			else
+				next_count++;
+		}
+		
+		thread_pool_wait(batches.pool);
+		
+		for (i = 0; i < next_count; i++) {
+			if (thread_pool_submit(batches.pool, block_decompress_task, &next[i]) < 0)
+				goto error;
+		}
+		
+		// writing the current batch, in order, while the worker threads decompress the next one
+		for (i = 0; i < current_count; i++) {
+			if (current[i].result < 0)
+				goto error;
+			if (write_full(out, current[i].raw, current[i].raw_size) < 0)
+				goto error;
+			lz78_stats_add(stats, &current[i].stats);
+		}
+		
+		tmp = current;
+		current = next;
+		next = tmp;
+		current_count = next_count;
+		
+	} while (current_count > 0);
+	
+	batches_free(&batches);
+	
+	return (close(out) < 0)?(-1):(0);
+	
+error:
+	batches_free(&batches);
+	close(out);
+	return -1;
+}
+
+size_t blocks_bound (size_t raw_size, int bits)
+{
+	// every code but the last one and EOS consumes at least one byte of input
+	return (((raw_size + 1) * bits) + 7) / 8 + sizeof(uint64_t) + CHECKSUM_BITS / 8;
+}
+
+int batches_alloc (BATCHES* batches, int threads, size_t block_size, OPTIONS* options)
+{
+	int i;
+	BLOCK* block;
+	
+	batches->size = threads * BLOCKS_PER_THREAD;
+	batches->pool = NULL;
+	batches->threads = threads;
+	batches->streams = calloc(threads, sizeof(LZ78_STREAM*));
+	batches->blocks = calloc(2 * batches->size, sizeof(BLOCK));
+	if (batches->blocks == NULL || batches->streams == NULL) {
+		free(batches->blocks);
+		free(batches->streams);
+		batches->blocks = NULL;
+		return -1;
+	}
+	
+	for (i = 0; i < 2 * batches->size; i++) {
+		block = &batches->blocks[i];
+		block->options = *options;
+		block->streams = batches->streams;
+		block->packed_max = blocks_bound(block_size, options->bits);
+		block->raw = malloc(block_size);
+		block->packed = malloc(block->packed_max);
+		if (block->raw == NULL || block->packed == NULL)
+			goto error;
+	}
+	
+	batches->pool = thread_pool_create(threads);
+	if (batches->pool == NULL)
+		goto error;
+	
+	return 0;
+	
+error:
+	batches_free(batches);
+	return -1;
+}
+
+void batches_free (BATCHES* batches)
+{
+	int i;
+	
+	if (batches->blocks == NULL)
+		return;
+	
+	// the worker threads could still be using the blocks
+	thread_pool_destroy(batches->pool);
+	batches->pool = NULL;
+	
+	for (i = 0; i < 2 * batches->size; i++) {
+		free(batches->blocks[i].raw);
+		free(batches->blocks[i].packed);
+	}
+	free(batches->blocks);
+	batches->blocks = NULL;
+	
+	for (i = 0; i < batches->threads; i++)
+		lz78_free(batches->streams[i]);
+	free(batches->streams);
+	batches->streams = NULL;
+}
+
+void block_compress_task (void* arg)
+{
+	BLOCK* block;
+	BIT_FILE* output;
+	LZ78_STREAM* stream;
+	size_t used;
+	
+	block = arg;
+	block->result = -1;
+	
+	// the block is compressed into a memory bit file
+	output = bit_open_mem(block->packed, block->packed_max, "w");
+	if (output == NULL)
+		return;
+	
+	stream = block_stream(block, output, true);
+	if (stream != NULL) {
+		if (lz78_encode(stream, block->raw, block->raw_size, &used) == LZ78_OK && lz78_encode_end(stream) == LZ78_END &&
+				(block->options.checksum == false || checksum_write(output, crc32c(0, block->raw, block->raw_size)) == 0))
+			block->result = 0;
+		lz78_stats(stream, &block->stats);
+	}
+	
+	block->packed_size = bit_length(output);
+	if (bit_close(output) < 0)
+		block->result = -1;
+}
+
+void block_decompress_task (void* arg)
+{
+	BLOCK* block;
+	BIT_FILE* input;
+	LZ78_STREAM* stream;
+	size_t produced, extra;
+	
+	block = arg;
+	block->result = -1;
+	
+	input = bit_open_mem(block->packed, block->packed_size, "r");
+	if (input == NULL)
+		return;
+	
+	// the block has to decompress exactly to the size stored in the block table:
+	// after filling the raw area, the only code left is EOS, followed by the checksum
+	stream = block_stream(block, input, false);
+	if (stream != NULL) {
+		if (lz78_decode(stream, block->raw, block->raw_size, &produced) >= 0 && produced == block->raw_size &&
+				lz78_decode(stream, block->raw + produced, 0, &extra) == LZ78_END &&
+				(block->options.checksum == false || checksum_verify(input, crc32c(0, block->raw, block->raw_size)) == 0))
+			block->result = 0;
+		lz78_stats(stream, &block->stats);
+	}
+	
+	bit_close(input);
+}
+
+LZ78_STREAM* block_stream (BLOCK* block, BIT_FILE* bf, bool compressing)
+{
+	LZ78_STREAM** stream;
+	int index;
+	
+	index = thread_pool_self();
+	if (index < 0)
+		return NULL;
+	stream = &block->streams[index];
+	
+	if (*stream == NULL) {
+		*stream = lz78_open(&block->options, bf, compressing);
+		return *stream;
+	}
+	
+	return (lz78_reset(*stream, bf) == LZ78_OK)?(*stream):(NULL);
+}
+
+int block_write (int fd, BLOCK* block)
+{
+	uint8_t entry[BLOCK_ENTRY_SIZE];
+	
+	put_le32(entry, block->raw_size);
+	put_le32(entry + 4, block->packed_size);
+	
+	if (write_full(fd, entry, BLOCK_ENTRY_SIZE) < 0)
+		return -1;
+	
+	return write_full(fd, block->packed, block->packed_size);
+}
+
+int block_read (int fd, BLOCK* block, size_t block_size)
+{
+	uint8_t entry[BLOCK_ENTRY_SIZE];
+	ssize_t result;
+	
+	result = read_full(fd, entry, BLOCK_ENTRY_SIZE);
+	if (result != BLOCK_ENTRY_SIZE)
+		return -1;
+	
+	block->raw_size = get_le32(entry);
+	block->packed_size = get_le32(entry + 4);
+	
+	// terminating entry
+	if (block->raw_size == 0)
+		return 1;
+	
+	// checking the entry against the size of the areas
+	if (block->raw_size > block_size || block->packed_size > block->packed_max)
+		return -1;
+	
+	result = read_full(fd, block->packed, block->packed_size);
+	if (result < 0 || (size_t)result != block->packed_size)
+		return -1;
+	
+	return 0;
+}
@@ -0,0 +1,66 @@
+/*
+ * blocks.h
+ * Francesco Piras - Dario Varano
+ * June 2015
+ */
+
+#ifndef _BLOCKS_H
+#define _BLOCKS_H
+
+#include "definitions.h"
+#include "header.h"
+#include "lz78.h"
+
+/**
+ * NOTE ON THE BLOCK CONTAINER FORMAT
+ * 
+ * The input is split into blocks of block_size bytes (the last one can be shorter), and every block is compressed
+ * on its own, with a fresh dictionary and its own bit file, so that blocks can be compressed and decompressed in parallel.
+ * After the header (HEADER_FLAG_BLOCKS set) every block is preceded by its entry of the block table:
+ * 
+ * 			+---------------+---------------+-------------------------------+
+ * 			|	raw_size	|	packed_size	|	packed_size bytes of codes	|
+ * 			+---------------+---------------+-------------------------------+
+ * 
+ * where both sizes are 32 bits little endian values. An entry with raw_size equal to 0 terminates the stream.
+ * With HEADER_FLAG_CHECKSUM the codes of every block end with the checksum of the block (see checksum.h).
+ * The output only depends on the block size, never on the number of threads.
+ */
+
+#define DEFAULT_BLOCK_SIZE	(1 << 20)		// default size (in bytes) of a block
+#define BLOCK_ENTRY_SIZE	8				// size (in bytes) of a block table entry
+
+/**
+ * @brief It compresses the input file into the block container format, using options->threads worker threads
+ * 
+ * @param input the input file name
+ * @param output the output file name
+ * @param options the compression parameters
+ * @param stats the pointer to the structure filled with the statistics of all the blocks, or NULL
+ * @return int a flag indicating if the compression operation has been completed successfully (0) or if an error occurs (-1)
+ */
+int blocks_compress (char* input, char* output, OPTIONS* options, LZ78_STATS* stats);
+
+/**
+ * @brief It decompresses a block container, whose header has already been read, using options->threads worker threads
+ * 		(or one per online processor, if not specified)
+ * 
+ * @param in the input file descriptor, placed right after the header
+ * @param output the output file name, or NULL to discard the decoded data
+ * @param header the pointer to the header of the stream
+ * @param options the decompression parameters
+ * @param stats the pointer to the structure filled with the statistics of all the blocks, or NULL
+ * @return int a flag indicating if the decompression operation has been completed successfully (0) or if an error occurs (-1)
+ */
+int blocks_decompress (int in, char* output, HEADER* header, OPTIONS* options, LZ78_STATS* stats);
+
+/**
+ * @brief It returns the maximum compressed size of a block
+ * 
+ * @param raw_size the size (in bytes) of the uncompressed block
+ * @param bits the number of bits used for encoding
+ * @return size_t the maximum size (in bytes) of the compressed block
+ */
+size_t blocks_bound (size_t raw_size, int bits);
+
+#endif
@@ -0,0 +1,154 @@
+/*
+ * checksum.c
+ * Francesco Piras - Dario Varano
+ * June 2015
+ */
+
+#include "checksum.h"
+
+#include <pthread.h>
+#include <string.h>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <nmmintrin.h>
+#define CHECKSUM_SSE42
+#endif
+
+#define CRC32C_POLY		0x82F63B78		// the Castagnoli polynomial, bit reversed
+
+// the tables of the software CRC32C, which processes 8 bytes at a time (slicing by 8)
+static uint32_t crc_table[8][256];
+static pthread_once_t crc_table_once = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief It fills the tables of the software CRC32C
+ *
+ * @return void
+ */
+void crc32c_init (void);
+
+/**
+ * @brief It updates a CRC32C (without the final inversion) by the tables
+ *
+ * @param crc the inverted CRC32C of the previous bytes
+ * @param data the following bytes
+ * @param len the number of bytes
+ * @return uint32_t the inverted CRC32C of all the bytes
+ */
+uint32_t crc32c_sw (uint32_t crc, const uint8_t* data, size_t len);
+
+#ifdef CHECKSUM_SSE42
+/**
+ * @brief It updates a CRC32C (without the final inversion) by the crc32 instruction of SSE4.2, 8 bytes at a time
+ *
+ * @param crc the inverted CRC32C of the previous bytes
+ * @param data the following bytes
+ * @param len the number of bytes
+ * @return uint32_t the inverted CRC32C of all the bytes
+ */
+uint32_t crc32c_hw (uint32_t crc, const uint8_t* data, size_t len) __attribute__((target("sse4.2")));
+#endif
+
+uint32_t crc32c (uint32_t crc, const void* data, size_t len)
+{
+	crc = ~crc;
+
+#ifdef CHECKSUM_SSE42
+	if (__builtin_cpu_supports("sse4.2"))
+		return ~crc32c_hw(crc, data, len);
+#endif
+
+	pthread_once(&crc_table_once, crc32c_init);
+
+	return ~crc32c_sw(crc, data, len);
+}
+
+int checksum_write (BIT_FILE* bf, uint32_t crc)
+{
+	uint64_t data;
+
+	data = crc;
+
+	return (bit_write(bf, &data, CHECKSUM_BITS) == 0)?(0):(-1);
+}
+
+int checksum_verify (BIT_FILE* bf, uint32_t crc)
+{
+	uint64_t data;
+
+	if (bit_read(bf, &data, CHECKSUM_BITS) != 0)
+		return -1;
+
+	return (data == crc)?(0):(-1);
+}
+
+void crc32c_init (void)
+{
+	uint32_t crc;
+	int i, j;
+
+	for (i = 0; i < 256; i++) {
+		crc = i;
+		for (j = 0; j < 8; j++)
+			crc = (crc >> 1) ^ ((crc & 1)?(CRC32C_POLY):(0));
+		crc_table[0][i] = crc;
+	}
+
+	// the table k gives the contribution of a byte followed by k bytes
+	for (i = 0; i < 256; i++)
+		for (j = 1; j < 8; j++)
+			crc_table[j][i] = (crc_table[j - 1][i] >> 8) ^ crc_table[0][crc_table[j - 1][i] & 0xFF];
+}
+
+uint32_t crc32c_sw (uint32_t crc, const uint8_t* data, size_t len)
+{
+	uint32_t low, high;
+
+	while (len >= 8) {
+		low = crc ^ ((uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24));
+		high = (uint32_t)data[4] | ((uint32_t)data[5] << 8) | ((uint32_t)data[6] << 16) | ((uint32_t)data[7] << 24);
+		crc = crc_table[7][low & 0xFF] ^ crc_table[6][(low >> 8) & 0xFF] ^ crc_table[5][(low >> 16) & 0xFF] ^ crc_table[4][low >> 24] ^
+			crc_table[3][high & 0xFF] ^ crc_table[2][(high >> 8) & 0xFF] ^ crc_table[1][(high >> 16) & 0xFF] ^ crc_table[0][high >> 24];
+		data += 8;
+		len -= 8;
+	}
+
+	while (len > 0) {
+		crc = (crc >> 8) ^ crc_table[0][(crc ^ *data) & 0xFF];
+		data++;
+		len--;
+	}
+
+	return crc;
+}
+
+#ifdef CHECKSUM_SSE42
+uint32_t crc32c_hw (uint32_t crc, const uint8_t* data, size_t len)
+{
+	uint64_t crc64, word;
+
+	// the unaligned head, byte by byte
+	while (len > 0 && ((uintptr_t)data & 7) != 0) {
+		crc = _mm_crc32_u8(crc, *data);
+		data++;
+		len--;
+	}
+
+	crc64 = crc;
+	while (len >= 8) {
+		memcpy(&word, data, sizeof(word));
+		crc64 = _mm_crc32_u64(crc64, word);
+		data += 8;
+		len -= 8;
+	}
+	crc = (uint32_t)crc64;
+
+	while (len > 0) {
+		crc = _mm_crc32_u8(crc, *data);
+		data++;
+		len--;
+	}
+
+	return crc;
+}
+#endif
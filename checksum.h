@@ -0,0 +1,52 @@
+/*
+ * checksum.h
+ * Francesco Piras - Dario Varano
+ * June 2015
+ */
+
+#ifndef _CHECKSUM_H
+#define _CHECKSUM_H
+
+#include "definitions.h"
+#include "bitio.h"
+
+/**
+ * NOTE ON THE CHECKSUM
+ *
+ * With HEADER_FLAG_CHECKSUM every stream (the single one following the header, every block of a container,
+ * every member of an archive) is followed by the CRC32C (Castagnoli polynomial) of its uncompressed data, written
+ * as a 32 bits code right after EOS. The decompressor reads it after EOS and compares it with the CRC32C
+ * of the data it decoded, so that a corrupted or truncated stream is detected.
+ */
+
+#define CHECKSUM_BITS		32			// width (in bits) of the checksum following EOS
+
+/**
+ * @brief It updates the CRC32C of a sequence of bytes, using the SSE4.2 instruction when the processor has it
+ *
+ * @param crc the CRC32C of the previous bytes (0 for the first ones)
+ * @param data the following bytes
+ * @param len the number of bytes
+ * @return uint32_t the CRC32C of all the bytes
+ */
+uint32_t crc32c (uint32_t crc, const void* data, size_t len);
+
+/**
+ * @brief It writes the checksum of a stream, right after its EOS code
+ *
+ * @param bf the pointer to the bit file of the stream
+ * @param crc the CRC32C of the uncompressed data
+ * @return int a flag indicating if the checksum has been written (0) or if an error occurs (-1)
+ */
+int checksum_write (BIT_FILE* bf, uint32_t crc);
+
+/**
+ * @brief It reads the checksum of a stream, right after its EOS code, and compares it with the decoded data
+ *
+ * @param bf the pointer to the bit file of the stream
+ * @param crc the CRC32C of the decoded data
+ * @return int a flag indicating if the checksum matches (0) or if it doesn't or it can't be read (-1)
+ */
+int checksum_verify (BIT_FILE* bf, uint32_t crc);
+
+#endif
@@ -5,150 +5,174 @@
  */
 
 #include "compressor.h"
-#include "dictionary.h"
-#include "bitio.h"
+#include "blocks.h"
+#include "header.h"
+#include "input.h"
+#include "checksum.h"
+#include "seek.h"
+#include "pipeline.h"
 
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 /**
- * @brief It actually performs the compression
+ * @brief It actually performs the compression, walking the contiguous areas of the input file
  *
  * @param input the pointer to the data structure of the input file
  * @param output the pointer to the data structure of the output bit file
+ * @param options the compression parameters
+ * @param stats the pointer to the structure filled with the statistics of the compression, or NULL
  * @return int a flag indicating if the compression operation has been completed successfully (0) or if an error occurs (-1)
  */
-int compressor_impl (FILE* input, BIT_FILE* output, int bits, int dict_size);
+int compressor_impl (INPUT* input, BIT_FILE* output, OPTIONS* options, LZ78_STATS* stats);
 
 /**
- * @brief It performs closing operations for the compressor, in particular it writes EOS and closes the bit file
+ * @brief It opens the output bit file, starting it with a header when the codes have a variable width,
+ * 		the dictionary is not simply reset, a checksum or a seek index is appended or a preset dictionary is used (the headerless
+ * 		format only describes fixed width codes and fixed resets of an empty dictionary, without checksum)
  *
- * @param dictionary the pointer to the dictionary
- * @param output the pointer to the data structure of the output file
- * @return int a flag indicating if the closing operation has been completed successfully (0) or if an error occurs (-1)
+ * @param output the output file name, or "-" for the standard output
+ * @param options the compression parameters
+ * @param writer the pointer to be set to the writer thread of the pipelined mode, which the bit file writes to (NULL otherwise)
+ * @return BIT_FILE* the pointer to the output bit file, or NULL if an error occurs
  */
-int compressor_close (dictionary* dictionary, BIT_FILE* output, int bits);
+BIT_FILE* compressor_open (char* output, OPTIONS* options, PIPELINE** writer);
 
-int compress(char* input, char* output, int bits, int dict_size) {
-	FILE* fd;
+int compress(char* input, char* output, OPTIONS* options, LZ78_STATS* stats) {
+	INPUT* in;
 	BIT_FILE* bf;
+	PIPELINE* writer;
+	int ret;
 	
-	// opening the input file in reading mode
-	fd = fopen(input,"r");
+	// the block container is compressed by a pool of worker threads
+	if (options->threads > 0)
+		return blocks_compress(input, output, options, stats);
 	
-	//opening the output bit file in writing mode
-	bf = bit_open(output,"w");
+	// opening the input file in reading mode (by a reader thread in the pipelined mode)
+	if (options->pipeline == true)
+		in = input_open_pipelined(input, options->buffer_size);
+	else
+		in = input_open(input, options->buffer_size);
 	
-	// checking if the opening operations succeed
-	if ((fd != NULL) && (bf != NULL)) {
-		return compressor_impl(fd, bf, bits, dict_size);
-	}
-	return -1;
-}
-
-int compressor_impl(FILE* input, BIT_FILE* output, int bits, int dict_size) {
-	CODE next_code;			// next node
-	CODE current_code;		// current node
-	CODE index;				// node of the found character
-	int character;
-	int ret, dictionary_counter;
-	uint64_t data;
-	uint16_t max_code;
-	dictionary* dictionary;
-	
-	// computing the values for the maximum rapresentable code
-	max_code = (1 << bits)-1;
-	
-	next_code = FIRST_CODE;
-	
-	// dictionary allocation
-	dictionary = dictionary_alloc(dict_size);
-	if (dictionary == NULL)
+	//opening the output bit file in writing mode
+	bf = compressor_open(output, options, &writer);
+	
+	// checking if the opening operations succeed, and setting the size of the output buffer
+	if ((in == NULL) || (bf == NULL) || (options->buffer_size > 0 && bit_set_buffer(bf, options->buffer_size) < 0)) {
+		input_close(in);
+		if (bf != NULL)
+			bit_close(bf);
+		if (writer != NULL)
+			pipeline_close(writer);
 		return -1;
+	}
 	
-	// initialization of the compressor's dictionary
-	dictionary_compressor_init(dictionary);
+	ret = compressor_impl(in, bf, options, stats);
 	
-	// checking if the file is empty
-	if ((current_code = getc(input)) == EOF)
-		goto end;
+	// closing the bit file, whose last bytes go to the writer thread, which is stopped after writing them
+	if (bit_close(bf) < 0) {
+		fprintf(stderr, "Ops: error during closing\n");
+		ret = -1;
+	}
+	if (writer != NULL && pipeline_close(writer) < 0) {
+		fprintf(stderr, "Ops: error during writing\n");
+		ret = -1;
+	}
+	input_close(in);
 	
-	while ((character = getc(input)) != EOF) {
-		
-		// performing a look up of the extracted character
-		index  = dictionary_lookup(dictionary, current_code, (SYMBOL)character);
-		
-		// if it's already in the dictionary, set current code as the code of the entry found using the dictionary_lookup
-		if (dictionary_is_entry_unused(dictionary, index) == false) {
-			current_code = dictionary_get_entry_code(dictionary, index);
-		}
-		// the code is not in the dictionary
-		else {
-			// emit code
-			data = (uint64_t)current_code;
-			ret = bit_write(output, &data, bits);
-			if( ret < 0) {
-				goto error;
-			}
-			
-			// init dictonary entry
-			ret = dictionary_insert(dictionary, index, current_code, next_code, (SYMBOL)character);
-			
-			next_code++;
-			
-			// set current_code as code of node child of the root with symbol == character
-			current_code = (CODE)character;
-			
-			// getting the number of used entries in the dictionary
-			dictionary_counter = dictionary_count(dictionary);
-			
-			// check if next_code has reached max admissible value, or half of the table is filled (optimization)
-			if ((next_code > max_code) || (dictionary_counter > dict_size/2)) {
-				// reinit the dictionary
-				dictionary_compressor_init(dictionary);
-				
-				next_code = FIRST_CODE;
-			}
+	return ret;
+}
+
+BIT_FILE* compressor_open (char* output, OPTIONS* options, PIPELINE** writer)
+{
+	BIT_FILE* bf;
+	HEADER header;
+	int out;
+	
+	*writer = NULL;
+	
+	out = open_output(output);
+	if (out < 0)
+		return NULL;
+	
+	// a single stream, without blocks
+	if (options->variable == true || options->adaptive == true || options->lru == true || options->standby > 0 || options->checksum == true ||
+		options->preset != NULL || options->index == true) {
+		header_init(&header, options, 0, 0);
+		if (header_write(out, &header) < 0) {
+			close(out);
+			return NULL;
 		}
 	}
 	
-	// writing the last code extracted
-	data = (uint64_t)current_code;
-	ret = bit_write (output, &data, bits);
-	if (ret < 0) {
-		goto error;
+	bf = bit_fdopen(out, "w");
+	if (bf == NULL) {
+		close(out);
+		return NULL;
 	}
 	
-end:
-	return compressor_close (dictionary, output, bits);
+	// in the pipelined mode the buffer of the bit file is written by the writer thread, after the header
+	if (options->pipeline == true) {
+		*writer = pipeline_writer(out, options->buffer_size);
+		if (*writer == NULL || bit_set_io(bf, pipeline_drain, *writer) < 0) {
+			if (*writer != NULL)
+				pipeline_close(*writer);
+			*writer = NULL;
+			bit_close(bf);
+			return NULL;
+		}
+	}
 	
-error:
-	dictionary_free(dictionary);
-	return -1;
+	return bf;
 }
 
-int compressor_close (dictionary* dictionary, BIT_FILE* output, int bits) {
-	
+int compressor_impl(INPUT* input, BIT_FILE* output, OPTIONS* options, LZ78_STATS* stats) {
+	LZ78_STREAM* stream;
+	const LZ78_RESTART* restarts;
+	const uint8_t* data;
+	size_t len, used, count;
+	uint64_t raw_size;
+	uint32_t crc;
 	int ret;
-	uint64_t eos_code;
 	
-	eos_code = EOS;
-	// writing EOS
-	ret = bit_write(output, &eos_code, bits);
-	if (ret < 0) {
-		goto error;
+	crc = 0;
+	raw_size = 0;
+	
+	// the stream writes the codes on the output bit file
+	stream = lz78_open(options, output, true);
+	if (stream == NULL)
+		return -1;
+	
+	// the areas of the file are encoded in place, a mapped file as a whole
+	while ((ret = input_next(input, &data, &len)) == 0) {
+		if (lz78_encode(stream, data, len, &used) < 0) {
+			ret = -1;
+			break;
+		}
+		
+		// the checksum is updated while the area is still in the cache
+		if (options->checksum == true)
+			crc = crc32c(crc, data, len);
+		raw_size += len;
 	}
 	
-	// closing the bit file
-	if (bit_close(output) < 0) {
-		printf("Ops: error during closing\n");
-		goto error;
+	// checking that the whole file has been read, then writing the last code and EOS, followed by the checksum
+	if (ret == 1)
+		ret = (lz78_encode_end(stream) == LZ78_END)?(0):(-1);
+	if (ret == 0 && options->checksum == true)
+		ret = checksum_write(output, crc);
+	
+	// the seek index follows the whole stream
+	if (ret == 0 && options->index == true) {
+		restarts = lz78_restarts(stream, &count);
+		ret = seek_write(output, restarts, count, raw_size);
 	}
 	
-	// deallocation of the data structure
-	dictionary_free(dictionary);
+	if (stats != NULL)
+		lz78_stats(stream, stats);
 	
-	return 0;
+	lz78_free(stream);
 	
-error:	
-	dictionary_free(dictionary);
-	return -1;
+	return ret;
 }
@@ -7,13 +7,18 @@
 #ifndef _COMPRESSOR_H
 #define _COMPRESSOR_H
 
+#include "definitions.h"
+#include "lz78.h"
+
 /**
  * @brief It performs the compression of the input file, by producing the output file
  * 
  * @param input the input file name
  * @param output the output file name
+ * @param options the compression parameters (a number of threads greater than 0 selects the block container format)
+ * @param stats the pointer to the structure filled with the statistics of the compression, or NULL
  * @return int a flag indicating if the compression operation has been completed successfully (0) or if an error occurs (-1)
  */
-int compress (char* input, char* output, int bits, int dict_size);
+int compress (char* input, char* output, OPTIONS* options, LZ78_STATS* stats);
 
 #endif
@@ -5,169 +5,369 @@
  */
 
 #include "decompressor.h"
-#include "bitio.h"
-#include "dictionary.h"
+#include "header.h"
+#include "blocks.h"
+#include "segments.h"
+#include "archive.h"
+#include "checksum.h"
+#include "preset.h"
+#include "seek.h"
+#include "pipeline.h"
 
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 /**
- * @brief Move up in the tree starting from code node to root node, storing the encountered symbols
+ * @brief It actually performs the decompression, writing the output file by large buffers
  *
- * @param stack the pointer to the symbols' stack
- * @param stack_index the index of the stack from which it starts storing symbols
- * @param code the code of the node from which we start to move up
- * @return int size of the stack
+ * @param input the pointer to the data structure of the input bit file
+ * @param output the descriptor of the output file
+ * @param writer the writer thread of the pipelined mode, whose blocks are decoded in place of the output file, or NULL
+ * @param options the decompression parameters
+ * @param stats the pointer to the structure filled with the statistics of the decompression, or NULL
+ * @return int a flag indicating if the decompression operation has been completed successfully (0) or if an error occurs (-1)
  */
-int decode_string (dictionary* dictionary, SYMBOL* stack, int stack_index, CODE code);
+int decompressor_impl (BIT_FILE* input, int output, PIPELINE* writer, OPTIONS* options, LZ78_STATS* stats);
 
 /**
- * @brief It actually performs the decompression
+ * @brief It decodes a stream from its current code, discarding the first bytes and writing the following ones
  *
- * @param input the pointer to the data structure of the input bit file
- * @param output the pointer to the data structure of the output file
- * @param bits the number of bits used for encoding
- * @param tab_size the size of the dictionary
- * @return int a flag indicating if the decompression operation has been completed successfully (0) or if an error occurs (-1)
+ * @param input the pointer to the data structure of the input bit file, placed on the first code to be decoded
+ * @param output the descriptor of the output file, or -1 to discard the decoded data
+ * @param options the decompression parameters
+ * @param restart the restart point of the first code, or NULL for the beginning of the stream
+ * @param skip the number of decoded bytes to be discarded
+ * @param len the number of decoded bytes to be written after them
+ * @param stats the pointer to the structure filled with the statistics of the decompression, or NULL
+ * @return int a flag indicating if the bytes have been decoded, or EOS has been reached before (0), or if an error occurs (-1)
  */
-int decompressor_impl (BIT_FILE* input, FILE* output, int bits, int dict_size);
+int decompressor_range (BIT_FILE* input, int output, OPTIONS* options, const LZ78_RESTART* restart, uint64_t skip, uint64_t len,
+		LZ78_STATS* stats);
 
-int decompress (char* input, char* output, int bits, int dict_size)
+int decompress (char* input, char* output, OPTIONS* options, LZ78_STATS* stats)
 {
-	FILE* fd;
 	BIT_FILE* bf;
+	HEADER header;
+	OPTIONS stream_options;
+	PIPELINE* reader;
+	PIPELINE* writer;
+	uint8_t first[HEADER_SIZE];
+	ssize_t len;
+	bool rewound;
+	int in, out, ret;
 	
-	// opening the input file in writing mode
-	fd = fopen(output,"w");
+	// opening the input file in reading mode
+	in = open_input(input);
+	if (in < 0)
+		return -1;
 	
-	// opening the output file in reading mode
-	bf = bit_open(input,"r");
+	// a stream with a header describes itself, otherwise it is a headerless stream and we start again from the first byte
+	len = read_full(in, first, HEADER_SIZE);
+	if (len < 0) {
+		close(in);
+		return -1;
+	}
+	ret = (len < HEADER_SIZE)?(1):(header_decode(first, &header));
+	if (ret < 0 || (ret == 0 && header_read_preset(in, &header) < 0)) {
+		close(in);
+		return -1;
+	}
 	
-	// checking if the opening operations succeed
-	if (fd && bf != NULL)
-		return decompressor_impl(bf, fd, bits, dict_size);
+	// a stream compressed with a preset dictionary is decompressed only with the same one
+	if (ret == 0 && (header.flags & HEADER_FLAG_PRESET) != 0 && (options->preset == NULL || options->preset->id != header.preset_id)) {
+		fprintf(stderr, "The stream needs the preset dictionary %08x\n", header.preset_id);
+		close(in);
+		return -1;
+	}
+	if (ret == 0 && (header.flags & HEADER_FLAG_BLOCKS) != 0) {
+		ret = blocks_decompress(in, output, &header, options, stats);
+		close(in);
+		return ret;
+	}
+	if (ret == 0 && (header.flags & HEADER_FLAG_ARCHIVE) != 0) {
+		ret = archive_extract(in, output, &header, options, stats);
+		close(in);
+		return ret;
+	}
 	
-	return -1;
-}
-
-int decode_string (dictionary* dictionary, SYMBOL* stack, int stack_index, CODE code)
-{
-	while(code != ROOT_CODE) {
-		stack[stack_index++] = dictionary_get_entry_symbol(dictionary, code);
-		code = dictionary_get_entry_parent(dictionary, code);
+	// a single stream following a header is decoded with its parameters from the byte after the header;
+	// a pipe can't seek back, so the first bytes of a headerless stream are fed to the bit file instead
+	stream_options = *options;
+	rewound = false;
+	if (ret == 0)
+		header_options(&header, &stream_options);
+	else if (lseek(in, 0, SEEK_SET) == 0)
+		rewound = true;
+	else if (errno != ESPIPE) {
+		close(in);
+		return -1;
 	}
-	return stack_index;
-}
-
-int decompressor_impl (BIT_FILE* input, FILE* output, int bits, int dict_size)
-{
+	options = &stream_options;
 	
-	CODE old_code, next_code, new_code;
-	SYMBOL character;
-	uint64_t data;
-	uint16_t max_code;
-	int res, count, dictionary_counter;
-	dictionary* dictionary;
+	// a headerless stream is split into segments decoded in parallel, if it is a regular file
+	if (rewound == true && options->threads > 0) {
+		ret = segments_decompress(in, output, options, stats);
+		if (ret != 1) {
+			close(in);
+			return ret;
+		}
+	}
 	
-	SYMBOL symbols_stack[dict_size];
+	// opening the output file in writing mode
+	out = open_output(output);
 	
-	// dictionary allocation
-	dictionary = dictionary_alloc(dict_size);
-	if (dictionary == NULL)
-		return -1;
+	// binding the input bit file to the opened descriptor
+	bf = bit_fdopen(in,"r");
 	
-	// initialization of the decompressor's dictionary
-	dictionary_decompressor_init(dictionary);
-	next_code = FIRST_CODE;
-	count = 0;
+	// in the pipelined mode the rest of the input file is read by the reader thread, and the output file is written by the writer thread
+	reader = writer = NULL;
+	if (options->pipeline == true && out >= 0 && bf != NULL) {
+		reader = pipeline_reader(in, options->buffer_size);
+		writer = pipeline_writer(out, options->buffer_size);
+	}
 	
-	// reading the first code
-	res = bit_read(input, &data, bits);
-	if (res < 0) {
-		goto error;
+	// checking if the opening operations succeed, setting the size of the input buffer and feeding the bytes already read
+	if ((out < 0) || (bf == NULL) || (options->buffer_size > 0 && bit_set_buffer(bf, options->buffer_size) < 0) ||
+		(ret == 1 && rewound == false && bit_feed(bf, first, len) != (size_t)len) ||
+		(options->pipeline == true && (reader == NULL || writer == NULL || bit_set_io(bf, pipeline_fill, reader) < 0))) {
+		if (reader != NULL)
+			pipeline_close(reader);
+		if (writer != NULL)
+			pipeline_close(writer);
+		if (out >= 0)
+			close(out);
+		if (bf != NULL)
+			bit_close(bf);
+		else
+			close(in);
+		return -1;
 	}
 	
-	// checking that the first code read is EOS
-	old_code = (CODE)data;
-	if (old_code == EOS) {
-		goto end;
+	ret = decompressor_impl(bf, out, writer, options, stats);
+	
+	// closing the bit file, then stopping the reader thread and the writer thread, once it has written the last block
+	if (bit_close(bf) < 0) {
+		fprintf(stderr, "decompress2: error during closing\n");
+		ret = -1;
 	}
-	// computing the values for the maximum rapresentable code
-	max_code = (1 << bits) - 1;
+	if (reader != NULL)
+		pipeline_close(reader);
+	if (writer != NULL && pipeline_close(writer) < 0)
+		ret = -1;
+	if (close(out) < 0)
+		ret = -1;
 	
-	character = (SYMBOL)old_code;
+	return ret;
+}
+
+int decompressor_impl (BIT_FILE* input, int output, PIPELINE* writer, OPTIONS* options, LZ78_STATS* stats)
+{
+	LZ78_STREAM* stream;
+	uint8_t* buffer;
+	uint8_t* chunk;
+	size_t size, len;
+	uint32_t crc;
+	int ret;
+
+	// the decoded data is collected in a buffer as large as the input one, and written with a single system call
+	// (the pipelined mode decodes into the blocks of the writer thread instead)
+	size = (options->buffer_size > 0)?(options->buffer_size):(BIT_BUFFER_SIZE);
+	buffer = NULL;
+	if (writer == NULL) {
+		buffer = malloc(size);
+		if (buffer == NULL)
+			return -1;
+	}
+	chunk = buffer;
 	
-	// writing the first code to the output file
-	res = fputc(old_code, output);
-	if (res < 0) {
-		goto error;
+	// the stream reads the codes from the input bit file
+	stream = lz78_open(options, input, false);
+	if (stream == NULL) {
+		free(buffer);
+		return -1;
 	}
 	
-	// read untill EOS is reached (2 is an internal code for EOS)
-	while (bit_read(input, &data, bits) != 2) {
-		new_code = (CODE)data;
-		
-		// regular case:
-		// checking that the node labeled with the next code is still in the dicitonary
-		if (new_code < next_code) {
-			
-			// build the symbols' stack, to be write in the output file
-			count = decode_string(dictionary, symbols_stack, 0, new_code);
-		}
-		// special case:
-		// the node labeled with the next code is not still in the dictionary
-		else {
-			
-			// initialization of the stack
-			symbols_stack[0] = (SYMBOL)character;
-			
-			// in this case we start from the position 1 of the stack, 
-			// because position 0 was previously initialized
-			count = decode_string(dictionary, symbols_stack, 1, old_code);
+	// decoding a buffer at a time, untill EOS is reached
+	crc = 0;
+	do {
+		if (writer != NULL && pipeline_buffer(writer, &chunk, &size) < 0) {
+			ret = -1;
+			break;
 		}
 		
-		// child of the root
-		character = symbols_stack[count -1];
+		ret = lz78_decode(stream, chunk, size, &len);
+		if (ret < 0)
+			break;
 		
-		while (count > 0) {
-			
-			// writing of the symbols contained in the stack, in the output file
-			res = fputc(symbols_stack[--count], output);
-			if (res < 0) {
-				goto error;
-			}
+		if (options->checksum == true)
+			crc = crc32c(crc, chunk, len);
+		if (writer != NULL) {
+			if (pipeline_commit(writer, len) < 0)
+				ret = -1;
 		}
-		
-		// adding a new entry in the dictionary
-		res = dictionary_insert(dictionary, (uint32_t)next_code, old_code, next_code, character);
-		
-		next_code++;
-		
-		// getting the number of used entries in the dictionary
-		dictionary_counter = dictionary_count(dictionary);
-		
-		//check if next_code has reached max admissible value
-		if ((next_code > max_code) || (dictionary_counter > dict_size/2)) {
+		else if (len > 0 && write_full(output, chunk, len) < 0)
+			ret = -1;
+	} while (ret == LZ78_OK);
+	
+	// the checksum follows EOS
+	if (ret == LZ78_END && options->checksum == true && checksum_verify(input, crc) < 0) {
+		fprintf(stderr, "Checksum mismatch: the compressed data is corrupted\n");
+		ret = -1;
+	}
+	
+	if (stats != NULL)
+		lz78_stats(stream, stats);
+	
+	lz78_free(stream);
+	free(buffer);
+	
+	return (ret == LZ78_END)?(0):(-1);
+}
 
-			next_code = FIRST_CODE;
-			
-			// reinit the dictionary
-			dictionary_decompressor_init(dictionary);
-		}
-		
-		old_code = new_code;
+int decompress_range (char* input, char* output, OPTIONS* options, uint64_t start, uint64_t len, LZ78_STATS* stats)
+{
+	BIT_FILE* bf;
+	HEADER header;
+	OPTIONS stream_options;
+	LZ78_RESTART* restarts;
+	const LZ78_RESTART* restart;
+	uint8_t first[HEADER_SIZE];
+	uint64_t raw_size;
+	size_t count;
+	ssize_t read_len;
+	bool rewound;
+	int in, out, ret;
+	
+	// opening the input file in reading mode
+	in = open_input(input);
+	if (in < 0)
+		return -1;
+	
+	// the header is checked as a full decompression does, but only a single stream can be decoded from the middle
+	read_len = read_full(in, first, HEADER_SIZE);
+	if (read_len < 0) {
+		close(in);
+		return -1;
+	}
+	ret = (read_len < HEADER_SIZE)?(1):(header_decode(first, &header));
+	if (ret < 0 || (ret == 0 && header_read_preset(in, &header) < 0)) {
+		close(in);
+		return -1;
+	}
+	if (ret == 0 && (header.flags & HEADER_FLAG_PRESET) != 0 && (options->preset == NULL || options->preset->id != header.preset_id)) {
+		fprintf(stderr, "The stream needs the preset dictionary %08x\n", header.preset_id);
+		close(in);
+		return -1;
+	}
+	if (ret == 0 && (header.flags & (HEADER_FLAG_BLOCKS | HEADER_FLAG_ARCHIVE)) != 0) {
+		fprintf(stderr, "A range is decompressed only from a single stream\n");
+		close(in);
+		return -1;
+	}
+	
+	// the last restart point before the range, if the stream has a seek index in a regular file
+	restarts = NULL;
+	restart = NULL;
+	if (ret == 0 && (header.extra & HEADER_EXTRA_INDEX) != 0 && seek_read(in, &restarts, &count, &raw_size) == 0) {
+		if (start >= raw_size)
+			len = 0;
+		restart = seek_find(restarts, count, start);
+		if (restart->offset == 0)
+			restart = NULL;
 	}
 	
-	// closing the bit file
-	if (bit_close(input) < 0) {
-		printf("decompress2: error during closing\n");
-		goto error;
+	// a headerless stream starts again from the first byte (or from the bytes already read, on a pipe)
+	stream_options = *options;
+	rewound = false;
+	if (ret == 0)
+		header_options(&header, &stream_options);
+	else if (lseek(in, 0, SEEK_SET) == 0)
+		rewound = true;
+	else if (errno != ESPIPE) {
+		close(in);
+		return -1;
+	}
+	options = &stream_options;
+	
+	// opening the output file in writing mode
+	out = (output != NULL)?(open_output(output)):(-1);
+	
+	// binding the input bit file to the opened descriptor, and placing it on the first code of the restart point
+	bf = bit_fdopen(in,"r");
+	if ((output != NULL && out < 0) || (bf == NULL) || (options->buffer_size > 0 && bit_set_buffer(bf, options->buffer_size) < 0) ||
+		(ret == 1 && rewound == false && bit_feed(bf, first, read_len) != (size_t)read_len) ||
+		(restart != NULL && bit_seek(bf, (uint64_t)header_size(&header) * 8 + restart->bit_offset) < 0)) {
+		if (out >= 0)
+			close(out);
+		if (bf != NULL)
+			bit_close(bf);
+		else
+			close(in);
+		free(restarts);
+		return -1;
 	}
 	
-end:	
-	dictionary_free(dictionary);
-	return 0;
+	ret = decompressor_range(bf, out, options, restart, start - ((restart != NULL)?(restart->offset):(0)), len, stats);
 	
-error:	
-	dictionary_free(dictionary);
-	return -1;
+	// only the codes decoded count: neither the ones skipped by the seek nor the ones read ahead in the buffer
+	if (stats != NULL)
+		stats->bytes_in = (bit_tell(bf) - ((restart != NULL)?((uint64_t)header_size(&header) * 8 + restart->bit_offset):(0)) + 7) / 8;
+	
+	if (bit_close(bf) < 0)
+		ret = -1;
+	if (out >= 0 && close(out) < 0)
+		ret = -1;
+	free(restarts);
+	
+	return ret;
 }
 
+int decompressor_range (BIT_FILE* input, int output, OPTIONS* options, const LZ78_RESTART* restart, uint64_t skip, uint64_t len,
+		LZ78_STATS* stats)
+{
+	LZ78_STREAM* stream;
+	uint8_t* chunk;
+	size_t size, produced, from, count;
+	int ret;
+	
+	size = (options->buffer_size > 0)?(options->buffer_size):(BIT_BUFFER_SIZE);
+	chunk = malloc(size);
+	if (chunk == NULL)
+		return -1;
+	
+	stream = lz78_open(options, input, false);
+	if (stream == NULL || (restart != NULL && lz78_decode_restart(stream, restart) != LZ78_OK)) {
+		lz78_free(stream);
+		free(chunk);
+		return -1;
+	}
+	
+	// decoding a buffer at a time, untill the end of the range or EOS is reached
+	ret = LZ78_OK;
+	while (len > 0 && ret == LZ78_OK) {
+		// the last buffer holds just the end of the range
+		ret = lz78_decode(stream, chunk, (len < size && skip < size - len)?((size_t)(skip + len)):(size), &produced);
+		if (ret < 0)
+			break;
+		
+		// the bytes before the range are discarded
+		from = (skip < produced)?((size_t)skip):(produced);
+		skip -= from;
+		count = produced - from;
+		if (count > len)
+			count = (size_t)len;
+		len -= count;
+		if (count > 0 && output >= 0 && write_full(output, chunk + from, count) < 0)
+			ret = -1;
+	}
+	
+	if (stats != NULL)
+		lz78_stats(stream, stats);
+	
+	lz78_free(stream);
+	free(chunk);
+	
+	return (ret < 0)?(-1):(0);
+}
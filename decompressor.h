@@ -7,14 +7,35 @@
 #ifndef _DECOMPRESSOR_H
 #define _DECOMPRESSOR_H
 
+#include "definitions.h"
+#include "lz78.h"
+
 /**
- * @brief It performs the decompression of the input file, by producing the output file
+ * @brief It performs the decompression of the input file, by producing the output file.
+ * 		A stream starting with a header carries its own parameters, which take the place of the ones in options
  * 
  * @param input the input file name
- * @param output the output file name
+ * @param output the output file name, or NULL to discard the decoded data
+ * @param options the decompression parameters of a headerless stream, and the number of worker threads
+ * @param stats the pointer to the structure filled with the statistics of the decompression, or NULL
  * @return int a flag indicating if the decompression operation has been completed successfully (0) or if an error occurs (-1)
  */
-int decompress (char* input, char* output, int bits, int dict_size);
+int decompress (char* input, char* output, OPTIONS* options, LZ78_STATS* stats);
+
+/**
+ * @brief It decompresses only a range of the uncompressed data of a single stream. With a seek index the decoding
+ * 		starts from the last restart point before the range, otherwise from the beginning of the stream; it stops
+ * 		at the end of the range, so the checksum is not verified
+ * 
+ * @param input the input file name
+ * @param output the output file name, or NULL to discard the decoded data
+ * @param options the decompression parameters of a headerless stream
+ * @param start the position (in bytes) of the uncompressed data where the range starts
+ * @param len the length (in bytes) of the range, which ends earlier if the data does
+ * @param stats the pointer to the structure filled with the statistics of the decompression, or NULL
+ * @return int a flag indicating if the range has been decompressed (0) or if an error occurs (-1)
+ */
+int decompress_range (char* input, char* output, OPTIONS* options, uint64_t start, uint64_t len, LZ78_STATS* stats);
 
 
 #endif
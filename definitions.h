@@ -19,6 +19,21 @@
 #define FIRST_CODE 	257					// first code to use as next code
 #define ROOT_CODE	-1					// root node code
 
+#define MIN_BITS	9					// minimum number of bits used for encoding (the first symbols and EOS have to fit)
+#define MAX_BITS	24					// maximum number of bits used for encoding
+
+#define MIN_DICT_SIZE	(SYMBOLS + 1)	// minimum dictionary size (the first symbols and one more entry)
+#define MAX_DICT_SIZE	0x7FFFFFFF		// maximum dictionary size (it is stored in an int)
+
+#define PROBE_BUCKETS	8				// buckets of the histogram of the probe lengths: 0, 1, 2, 3, 4-7, 8-15, 16-31 and 32 or more
+
+// the counters which the codec doesn't need (lookups, probes, resets and timings) are compiled out with -DLZ78_NO_STATS
+#ifdef LZ78_NO_STATS
+#define STATS(x)
+#else
+#define STATS(x)	x
+#endif
+
 #ifndef bool
 typedef enum { false = 0, true = 1 } bool;
 #endif
@@ -26,8 +41,27 @@ typedef enum { false = 0, true = 1 } bool;
 typedef uint16_t SYMBOL;
 typedef uint32_t CODE;
 
-// Performance analysis variables
-int COLLISIONS;
-int LOOKUP_COUNT;
+/**
+ * @brief The parameters of a compression or decompression
+ * 
+ */
+typedef struct options_struct {
+	int bits;					// number of bits used for encoding the symbols
+	int dict_size;				// number of dictionary entries
+	int threads;				// number of worker threads (0 selects the sequential, headerless format)
+	int block_size;				// size (in bytes) of the independent blocks of the container format
+	int buffer_size;			// size (in bytes) of the input and output buffers (0 selects the default size)
+	int load_factor;			// maximum percentage of used entries of the compressor's hash table (0 selects the default one)
+	int table;					// layout of the compressor's hash table (DICTIONARY_LINEAR, DICTIONARY_BUCKETS or DICTIONARY_ROBIN_HOOD, not with lru)
+	bool variable;				// flag selecting codes as wide as the dictionary needs, up to bits (only with a header)
+	bool adaptive;				// flag selecting the adaptive reset policy: a full dictionary is kept until a CLEAR code (only with a header)
+	int standby;				// fill percentage of the dictionary from which a standby one is populated to replace it (0 disables it, only with a header)
+	bool lru;					// flag selecting the LRU replacement policy: a full dictionary reuses its least recently used leaves (only with a header)
+	struct preset_struct* preset;	// the preset dictionary loaded by every reset of the streams, or NULL (only with a header)
+	bool checksum;				// flag appending the CRC32C of the uncompressed data to every stream (only with a header)
+	int reset_threshold;		// loss (in percent) of the compression ratio which makes the compressor write CLEAR (0 selects the default one)
+	bool index;					// flag telling the compressor to record the restart points of a seek index (only with a header)
+	bool pipeline;				// flag selecting the pipelined mode: a reader, a codec and a writer thread (a single stream only)
+} OPTIONS;
 
 #endif
@@ -5,6 +5,36 @@
  */
 
 #include "dictionary.h"
+#include "checksum.h"
+
+#include <sys/mman.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define DICTIONARY_SIMD
+#endif
+
+#define HASH_MULTIPLIER		0x9E3779B97F4A7C15ULL		// 2^64 divided by the golden ratio (Fibonacci hashing)
+#define HASH_MULTIPLIER2	0xC2B2AE3D27D4EB4FULL		// an odd constant with well mixed bits, for the second bucket of a key
+
+#define BUCKET_SLOTS		7							// entries of a bucket (the index of a bucket's slot takes 3 bits)
+#define BUCKET_NONE			BUCKET_SLOTS				// slot of the index returned when no room is found for a new entry
+#define BUCKET_PATH			32							// maximum number of entries moved to their other bucket to make room
+#define BUCKET_HOLE			0							// key of a slot freed by a move (no hashed key is lower than FIRST_CODE << 8)
+#define BUCKET_FREE			0							// code of a free slot returned by a lookup (no hashed code is lower than FIRST_CODE)
+
+#define ROBIN_MAX_DISTANCE	255							// maximum distance of an entry of the Robin Hood table from its home slot
+#define ROBIN_NONE			0xFFFFFFFF					// pending slot when the last lookup found its key
+
+#define DIRECT_FANOUT		256							// symbols (and parents) of the depth 1 nodes held by the direct table
+#define DIRECT_UNUSED		0							// content of an unused slot of the direct table (no code is lower than FIRST_CODE)
+#define DIRECT_FREED		1							// content of a slot of the direct table which is unused, but already logged
+
+#define LRU_NONE			0							// end of the recency list (no code lower than FIRST_CODE is in the list)
+
+#define IMAGE_ORDER			0x01020304					// byte order mark of a dictionary image
 
 /**
  * @brief A dictionary entry
@@ -13,72 +43,382 @@
 typedef struct dictionary_entry_struct {
 	CODE parent;
 	CODE code;
-	SYMBOL symbol;
+	uint8_t symbol;
+	uint8_t distance;				// distance from the home slot of the entry (DICTIONARY_ROBIN_HOOD only)
+	uint16_t epoch;					// the entry is used only if it has been inserted in the current epoch
 } dictionary_entry;
 
+/**
+ * @brief A bucket of the bucketized table, as large as a cache line: the keys are compared all together
+ * 
+ */
+typedef struct dictionary_bucket_struct {
+	uint32_t keys[BUCKET_SLOTS];	// (parent << 8) | symbol of every slot, or BUCKET_HOLE
+	uint16_t epoch;					// the slots are used only if the bucket has been written in the current epoch
+	uint8_t count;					// number of the first slots which are used (or holes)
+	uint8_t victim;					// next slot whose entry is moved to its other bucket
+	CODE codes[BUCKET_SLOTS + 1];	// code of every slot, 0 for a free one (as the slot BUCKET_NONE, which is never used)
+} __attribute__((aligned(64))) dictionary_bucket;
+
+/**
+ * @brief The header of a dictionary image, in the byte order of the machine
+ * 
+ */
+typedef struct dictionary_image_struct {
+	uint8_t magic[4];				// 'L' '7' '8' 'T'
+	uint32_t version;				// DICTIONARY_IMAGE_VERSION
+	uint32_t order;					// IMAGE_ORDER, as the machine which wrote the image stores it
+	uint32_t entry_size;			// size (in bytes) of an entry, which depends on the layout of the structure
+	uint32_t size;					// number of total entries
+	uint32_t counter;				// number of used entries
+	uint32_t direct_count;			// number of used slots of the direct table
+	uint16_t epoch;					// the epoch of the used entries
+	uint16_t layout;				// DICTIONARY_LINEAR, DICTIONARY_BUCKETS or DICTIONARY_ROBIN_HOOD
+	uint32_t crc;					// CRC32C of the entries table, the direct table and its used slots
+} DICTIONARY_IMAGE;
+
+static const uint8_t image_magic[4] = { 'L', '7', '8', 'T' };
+
 /**
  * @brief The dictionary structure
  * 
  */
 typedef struct dictionary_struct {
-	int size;						// number of total entries
+	int size;						// number of total entries (a power of two), or 8 times the buckets
+	int layout;						// DICTIONARY_LINEAR, DICTIONARY_BUCKETS or DICTIONARY_ROBIN_HOOD
+	uint32_t mask;					// size - 1, to wrap the indexes
+	int shift;						// 64 - log2(size), to take the index from the top bits of the hash
 	int counter;					// number of used entries
-	dictionary_entry* entries;		// entries array pointer
+	uint16_t epoch;					// current epoch, incremented by every reset (never 0)
+	dictionary_entry* entries;		// entries array pointer (DICTIONARY_LINEAR and DICTIONARY_ROBIN_HOOD)
+	dictionary_bucket* buckets;		// buckets array pointer (DICTIONARY_BUCKETS)
+	uint32_t (*bucket_match) (const dictionary_bucket* bucket, uint32_t key);	// comparison of the keys of a bucket
+	uint32_t pending;				// slot of the Robin Hood table where the key of the last lookup goes, or ROBIN_NONE
+	CODE* direct;					// direct table of the children of the first symbols, indexed by (parent, symbol), or NULL
+	uint32_t* direct_used;			// slots of the direct table used since the last reset, which has to clear them
+	int direct_count;				// number of used slots of the direct table
+	uint64_t direct_lookups;		// number of lookups served by the direct table (performance analysis)
+	uint64_t lookups;				// number of lookups (performance analysis)
+	uint64_t collisions;			// number of collisions (performance analysis)
+	uint64_t max_probe;				// length of the longest sequence of collisions (performance analysis)
+	uint64_t probes[PROBE_BUCKETS];	// histogram of the probe lengths of the hashed lookups (performance analysis)
+	CODE* lru_next;					// for every code, the next less recently used one, or NULL without LRU replacement
+	CODE* lru_prev;					// for every code, the next more recently used one
+	uint32_t* lru_index;			// for every code, the index of its entry
+	CODE lru_codes;					// number of codes of the recency list arrays
+	CODE lru_head;					// most recently used code
+	CODE lru_tail;					// least recently used code, always a leaf
+	bool hashed;					// the entries are placed by the hash function, so that a removal has to keep the probe sequences
+	uint8_t* image_base;			// mapping of the entries and direct tables from a dictionary image, or NULL
+	size_t image_len;				// size (in bytes) of the mapping
+	bool image_tried;				// an image has been checked already (mapped or rejected), so it isn't checked again
 } DICTIONARY;
 
 
 /**
- * @brief An implementation of the modified Bernstein hash function
+ * @brief A multiplicative hash function of the (parent, symbol) key: a single multiplication,
+ * 		whose most mixed (top) bits are taken as the index
  * 
- * @param key The key used for the hashing
- * @param len The length of the key
+ * @param parent the parent code of the key
+ * @param symbol the symbol of the key
+ * @param shift 64 - log2 of the number of entries of the dictionary
  * @return uint32_t An index inside the dictionary
  */
-uint32_t hash (void* key, int len);
+uint32_t hash (CODE parent, SYMBOL symbol, int shift);
+
+/**
+ * @brief It computes the two buckets of a key of the bucketized table, which are different
+ * 
+ * @param dictionary The pointer to the dictionary
+ * @param key the key, (parent << 8) | symbol
+ * @param first the first bucket (set by the function)
+ * @param second the second bucket (set by the function)
+ * @return void
+ */
+void bucket_pair (DICTIONARY* dictionary, uint32_t key, uint32_t* first, uint32_t* second);
+
+/**
+ * @brief It looks for a key in the bucketized table, making room for it in one of its buckets if it is not there
+ * 
+ * @param dictionary The pointer to the dictionary
+ * @param key the key, (parent << 8) | symbol
+ * @return uint32_t the index of the entry of the key, or of a free slot (BUCKET_NONE if there is no room)
+ */
+uint32_t bucket_lookup (DICTIONARY* dictionary, uint32_t key);
+
+/**
+ * @brief It returns a free slot of a bucket: the first one after the used ones, or a hole left by a move
+ * 
+ * @param dictionary The pointer to the dictionary
+ * @param bucket the index of the bucket
+ * @return int the slot, or BUCKET_NONE if the bucket is full
+ */
+int bucket_free_slot (DICTIONARY* dictionary, uint32_t bucket);
+
+/**
+ * @brief It makes room in a full bucket: it walks a path of entries, each one moved to its other bucket in place
+ * 		of the next one, until a bucket with a free slot is found, and then it moves them from the last one back
+ * 
+ * @param dictionary The pointer to the dictionary
+ * @param bucket the index of the full bucket
+ * @param moves the number of moved entries (set by the function)
+ * @return int the freed slot of the bucket, or BUCKET_NONE if no path is found
+ */
+int bucket_make_room (DICTIONARY* dictionary, uint32_t bucket, uint64_t* moves);
+
+/**
+ * @brief It puts an entry in a free slot of a bucket
+ * 
+ * @param dictionary The pointer to the dictionary
+ * @param bucket the index of the bucket
+ * @param slot the free slot
+ * @param key the key of the entry
+ * @param code the code of the entry
+ * @return void
+ */
+void bucket_put (DICTIONARY* dictionary, uint32_t bucket, int slot, uint32_t key, CODE code);
+
+/**
+ * @brief It compares a key with the keys of a bucket, one at a time
+ * 
+ * @param bucket the pointer to the bucket
+ * @param key the key
+ * @return uint32_t a mask with the bit of every slot holding the key (the slots after the used ones included)
+ */
+uint32_t bucket_match_scalar (const dictionary_bucket* bucket, uint32_t key);
+
+#ifdef DICTIONARY_SIMD
+/**
+ * @brief It compares a key with the keys of a bucket by two SSE2 comparisons (the eighth lane is not a key)
+ * 
+ * @param bucket the pointer to the bucket
+ * @param key the key
+ * @return uint32_t a mask with the bit of every slot holding the key (the slots after the used ones included)
+ */
+uint32_t bucket_match_sse2 (const dictionary_bucket* bucket, uint32_t key);
+
+/**
+ * @brief It compares a key with the keys of a bucket by a single AVX2 comparison (the eighth lane is not a key)
+ * 
+ * @param bucket the pointer to the bucket
+ * @param key the key
+ * @return uint32_t a mask with the bit of every slot holding the key (the slots after the used ones included)
+ */
+uint32_t bucket_match_avx2 (const dictionary_bucket* bucket, uint32_t key) __attribute__((target("avx2")));
+#endif
+
+/**
+ * @brief It looks for a key in the Robin Hood table: the search stops at the first entry which is closer to its home
+ * 		slot than the key would be, since the key would have taken its place
+ * 
+ * @param dictionary The pointer to the dictionary
+ * @param parent the parent code of the key
+ * @param symbol the symbol of the key
+ * @return uint32_t the index of the entry of the key, or of the slot where it goes (recorded as pending)
+ */
+uint32_t robin_lookup (DICTIONARY* dictionary, CODE parent, SYMBOL symbol);
+
+/**
+ * @brief It inserts an entry in the Robin Hood table: from its slot on, every entry which is closer to its home slot
+ * 		than the one being placed is swapped with it, up to the first unused slot
+ * 
+ * @param dictionary The pointer to the dictionary
+ * @param index the slot returned by the lookup of the key
+ * @param parent the parent code of the entry
+ * @param code the code of the entry
+ * @param symbol the symbol of the entry
+ * @return void
+ */
+void robin_put (DICTIONARY* dictionary, uint32_t index, CODE parent, CODE code, SYMBOL symbol);
+
+/**
+ * @brief It returns the size of the hash table of the dictionary (its entries or its buckets)
+ * 
+ * @param dictionary The pointer to the dictionary
+ * @return size_t the size (in bytes) of the table
+ */
+size_t dictionary_table_bytes (DICTIONARY* dictionary);
+
+/**
+ * @brief It returns the bucket of the histogram of the probe lengths: one for each of the shortest lengths,
+ * 		then one for each power of two
+ * 
+ * @param probe the number of collisions of a lookup
+ * @return int the index of the bucket
+ */
+int probe_bucket (uint64_t probe);
+
+/**
+ * @brief It empties the dictionary by starting a new epoch, so that all the entries become unused at once.
+ * 		Only when the epoch counter wraps around, the entries are actually swept
+ * 
+ * @param dictionary The pointer to the dictionary
+ * @return void
+ */
+void dictionary_reset (DICTIONARY* dictionary);
+
+/**
+ * @brief It returns the size of the mapping of a table: a large table is rounded up to a whole number of huge pages
+ * 
+ * @param size the size (in bytes) of the table
+ * @return size_t the size (in bytes) of the mapping
+ */
+size_t dictionary_table_size (size_t size);
+
+/**
+ * @brief It rounds a size or a position up to the alignment of the sections of a dictionary image
+ * 
+ * @param size the size (in bytes)
+ * @return size_t the aligned size (in bytes)
+ */
+size_t image_align (size_t size);
+
+/**
+ * @brief It computes the CRC32C of the sections of a dictionary image
+ * 
+ * @param table the entries table (or the buckets)
+ * @param table_len the size (in bytes) of the entries table, without its padding
+ * @param direct the direct table
+ * @param used the used slots of the direct table
+ * @param used_count the number of used slots
+ * @return uint32_t the CRC32C
+ */
+uint32_t image_crc (const void* table, size_t table_len, const CODE* direct, const uint32_t* used, uint32_t used_count);
+
+/**
+ * @brief It checks that the tables of an image hold only codes and slots within its bounds, so that neither the
+ * 		compressor nor the resets go out of them whatever the file holds
+ * 
+ * @param dictionary The pointer to the dictionary the image is for
+ * @param header the header of the image
+ * @param table the mapped entries table (or the buckets)
+ * @param direct the mapped direct table
+ * @param used the used slots of the direct table
+ * @return bool true if the tables are consistent with the header
+ */
+bool image_valid (DICTIONARY* dictionary, const DICTIONARY_IMAGE* header, const void* table, const CODE* direct, const uint32_t* used);
+
+/**
+ * @brief It removes a code from the recency list
+ * 
+ * @param dictionary The pointer to the dictionary
+ * @param code the code to be removed
+ * @return void
+ */
+void lru_unlink (DICTIONARY* dictionary, CODE code);
+
+/**
+ * @brief It inserts a code in the recency list, right after another one (that is less recently used than it)
+ * 
+ * @param dictionary The pointer to the dictionary
+ * @param code the code to be inserted
+ * @param prev the code preceding the inserted one, or LRU_NONE to make it the most recently used one
+ * @return void
+ */
+void lru_link (DICTIONARY* dictionary, CODE code, CODE prev);
+
+/**
+ * @brief It removes an entry of the hash table, moving back the following entries of its cluster which
+ * 		would not be found anymore (backward shift deletion), so that no tombstone is needed
+ * 
+ * @param dictionary The pointer to the dictionary
+ * @param index the index of the entry to be removed
+ * @return void
+ */
+void dictionary_remove (DICTIONARY* dictionary, uint32_t index);
 
 void dictionary_compressor_init (DICTIONARY* dictionary)
 {
-	// mark all dictionary entries as UNUSED
-	int i;
-	for (i = 0; i < dictionary->size; i++)
-		dictionary->entries[i].code = UNUSED;
-	
-	dictionary->counter = 0;
-	
-	// load first 256 symbols into the dictionary
-	SYMBOL s;
-	for (s = 0; s < SYMBOLS; s++) {
-		uint32_t index;
-		index = dictionary_lookup(dictionary, ROOT_CODE, s);
-		dictionary_insert(dictionary, index, ROOT_CODE, (CODE)s, (SYMBOL)s);
-	}
+	// the children of the root are implicit: their code is their symbol, and they are never looked up
+	dictionary_reset(dictionary);
 }
 
 void dictionary_decompressor_init (DICTIONARY* dictionary)
 {
-	// mark all dictionary entries as UNUSED
+	// the children of the root are implicit: their code is their symbol, so only the codes from FIRST_CODE on are stored
+	dictionary_reset(dictionary);
+}
+
+void dictionary_reset (DICTIONARY* dictionary)
+{
 	int i;
-	for (i = 0; i < dictionary->size; i++)
-		dictionary->entries[i].code = UNUSED;
 	
-	dictionary->counter = 0;
+	dictionary->epoch++;
+	
+	// the epoch counter wrapped around: the entries stamped with the old epochs have to be marked as UNUSED
+	if (dictionary->epoch == 0) {
+		if (dictionary->buckets != NULL)
+			for (i = 0; i < dictionary->size / 8; i++)
+				dictionary->buckets[i].epoch = 0;
+		else
+			for (i = 0; i < dictionary->size; i++)
+				dictionary->entries[i].epoch = 0;
+		dictionary->epoch = 1;
+	}
 	
-	// load first 256 symbols into the dictionary
-	SYMBOL s;
-	for (s = 0; s < SYMBOLS; s++) {
-		dictionary_insert(dictionary, s, ROOT_CODE, (CODE)s, (SYMBOL)s);
+	// the slots of the direct table are cleared one by one, so a reset costs as much as the insertions since the previous one
+	if (dictionary->direct != NULL) {
+		for (i = 0; i < dictionary->direct_count; i++)
+			dictionary->direct[dictionary->direct_used[i]] = DIRECT_UNUSED;
+		dictionary->direct_count = 0;
 	}
+	
+	// the first symbols are always in the dictionary
+	dictionary->counter = SYMBOLS;
+	dictionary->pending = ROBIN_NONE;
+	
+	dictionary->lru_head = LRU_NONE;
+	dictionary->lru_tail = LRU_NONE;
 }
 
-DICTIONARY* dictionary_alloc (int size)
+DICTIONARY* dictionary_alloc (int size, bool direct, int layout)
 {	
 	DICTIONARY* dictionary;
+	int log2;
+	
+	// the buckets hold the hashed entries only, the children of the first symbols being in the direct table
+	if (layout == DICTIONARY_BUCKETS && direct == false)
+		return NULL;
 	
-	dictionary = malloc(sizeof(DICTIONARY));
+	// rounding the size up to a power of two, so that the indexes are wrapped by a mask; the buckets are at least two,
+	// and their number is a power of two
+	if (layout == DICTIONARY_BUCKETS)
+		size = (size + BUCKET_SLOTS - 1) / BUCKET_SLOTS;
+	for (log2 = 1; log2 < ((layout == DICTIONARY_BUCKETS)?(28):(31)) && (1 << log2) < size; log2++)
+		;
+	size = 1 << log2;
+	
+	dictionary = calloc(1, sizeof(DICTIONARY));
 	if(dictionary != NULL) {
-		dictionary->size = size;
+		dictionary->size = (layout == DICTIONARY_BUCKETS)?(size * 8):(size);
+		dictionary->layout = layout;
+		dictionary->pending = ROBIN_NONE;
+		dictionary->mask = dictionary->size - 1;
+		dictionary->shift = 64 - log2;
 		dictionary->counter = 0;
-		dictionary->entries = malloc(size * sizeof(dictionary_entry));
+		// the entries (or the buckets) start with epoch 0, which is never the current one
+		if (layout == DICTIONARY_BUCKETS) {
+			dictionary->buckets = dictionary_table_alloc((size_t)size * sizeof(dictionary_bucket));
+			dictionary->bucket_match = bucket_match_scalar;
+#ifdef DICTIONARY_SIMD
+			dictionary->bucket_match = (__builtin_cpu_supports("avx2"))?(bucket_match_avx2):(bucket_match_sse2);
+#endif
+		}
+		else
+			dictionary->entries = dictionary_table_alloc((size_t)size * sizeof(dictionary_entry));
+		if (direct == true) {
+			dictionary->direct = calloc(DIRECT_FANOUT * DIRECT_FANOUT, sizeof(CODE));
+			dictionary->direct_used = malloc(DIRECT_FANOUT * DIRECT_FANOUT * sizeof(uint32_t));
+		}
+		if ((dictionary->entries == NULL && dictionary->buckets == NULL) ||
+			(direct == true && (dictionary->direct == NULL || dictionary->direct_used == NULL))) {
+			dictionary_table_free(dictionary->entries, dictionary_table_bytes(dictionary));
+			dictionary_table_free(dictionary->buckets, dictionary_table_bytes(dictionary));
+			free(dictionary->direct);
+			free(dictionary->direct_used);
+			free(dictionary);
+			dictionary = NULL;
+		}
 	}
 	
 	return dictionary;
@@ -87,38 +427,284 @@ DICTIONARY* dictionary_alloc (int size)
 void dictionary_free (DICTIONARY* dictionary)
 {	
 	if (dictionary != NULL) {
-		if (dictionary->entries != NULL) {
-			free(dictionary->entries);
+		// the tables mapped from an image are released all together
+		if (dictionary->image_base != NULL) {
+			munmap(dictionary->image_base, dictionary->image_len);
 			dictionary->entries = NULL;
+			dictionary->buckets = NULL;
+			dictionary->direct = NULL;
 		}
+		dictionary_table_free(dictionary->entries, dictionary_table_bytes(dictionary));
+		dictionary_table_free(dictionary->buckets, dictionary_table_bytes(dictionary));
+		free(dictionary->direct);
+		free(dictionary->direct_used);
+		dictionary_table_free(dictionary->lru_next, (size_t)dictionary->lru_codes * sizeof(CODE));
+		dictionary_table_free(dictionary->lru_prev, (size_t)dictionary->lru_codes * sizeof(CODE));
+		dictionary_table_free(dictionary->lru_index, (size_t)dictionary->lru_codes * sizeof(uint32_t));
 		free(dictionary);
 	}
 	dictionary = NULL;
 }
 
+int dictionary_image_save (DICTIONARY* dictionary, FILE* fp)
+{
+	static const uint8_t zeros[DICTIONARY_IMAGE_ALIGN];
+	DICTIONARY_IMAGE header;
+	const void* table;
+	size_t len;
+	long pos;
+	
+	if (dictionary == NULL || dictionary->direct == NULL || dictionary->lru_next != NULL)
+		return -1;
+	
+	memset(&header, 0, sizeof(DICTIONARY_IMAGE));
+	memcpy(header.magic, image_magic, sizeof(image_magic));
+	header.version = DICTIONARY_IMAGE_VERSION;
+	header.order = IMAGE_ORDER;
+	header.entry_size = (dictionary->layout == DICTIONARY_BUCKETS)?(sizeof(dictionary_bucket)):(sizeof(dictionary_entry));
+	header.layout = dictionary->layout;
+	header.size = dictionary->size;
+	header.counter = dictionary->counter;
+	header.direct_count = dictionary->direct_count;
+	header.epoch = dictionary->epoch;
+	table = (dictionary->buckets != NULL)?((void*)dictionary->buckets):((void*)dictionary->entries);
+	header.crc = image_crc(table, dictionary_table_bytes(dictionary), dictionary->direct, dictionary->direct_used, header.direct_count);
+	
+	// every section is padded up to the alignment
+	pos = ftell(fp);
+	if (pos < 0 || fwrite(zeros, 1, image_align(pos) - pos, fp) != image_align(pos) - pos ||
+		fwrite(&header, 1, sizeof(DICTIONARY_IMAGE), fp) != sizeof(DICTIONARY_IMAGE) ||
+		fwrite(zeros, 1, DICTIONARY_IMAGE_ALIGN - sizeof(DICTIONARY_IMAGE), fp) != DICTIONARY_IMAGE_ALIGN - sizeof(DICTIONARY_IMAGE))
+		return -1;
+	
+	len = dictionary_table_bytes(dictionary);
+	if (fwrite(table, 1, len, fp) != len || fwrite(zeros, 1, image_align(len) - len, fp) != image_align(len) - len)
+		return -1;
+	
+	len = DIRECT_FANOUT * DIRECT_FANOUT * sizeof(CODE);
+	if (fwrite(dictionary->direct, 1, len, fp) != len)
+		return -1;
+	
+	// the used slots are only read, by the resets which clear them
+	len = (size_t)dictionary->direct_count * sizeof(uint32_t);
+	if (fwrite(dictionary->direct_used, 1, len, fp) != len)
+		return -1;
+	
+	return 0;
+}
+
+int dictionary_image_map (DICTIONARY* dictionary, int fd, off_t offset)
+{
+	DICTIONARY_IMAGE header;
+	size_t entries_len, len;
+	uint32_t* used;
+	uint8_t* base;
+	long page;
+	
+	if (dictionary == NULL || dictionary->direct == NULL || dictionary->lru_next != NULL)
+		return 1;
+	
+	// the image is only the starting state: the resets of a dictionary which has already copied most of its pages
+	// are cheaper by insertions than by faulting them in again, and a rejected image isn't checked at every reset
+	if (dictionary->image_tried == true)
+		return 1;
+	dictionary->image_tried = true;
+	
+	entries_len = image_align(dictionary_table_bytes(dictionary));
+	
+	// checking the header, and that the sections are aligned to the pages of this machine
+	page = sysconf(_SC_PAGESIZE);
+	if (pread(fd, &header, sizeof(DICTIONARY_IMAGE), offset) != sizeof(DICTIONARY_IMAGE) ||
+		memcmp(header.magic, image_magic, sizeof(image_magic)) != 0 || header.version != DICTIONARY_IMAGE_VERSION ||
+		header.order != IMAGE_ORDER || header.layout != dictionary->layout || header.size != (uint32_t)dictionary->size ||
+		header.entry_size != ((dictionary->layout == DICTIONARY_BUCKETS)?(sizeof(dictionary_bucket)):(sizeof(dictionary_entry))) ||
+		header.direct_count > DIRECT_FANOUT * DIRECT_FANOUT || header.epoch == 0 ||
+		header.counter < SYMBOLS || header.counter > (uint32_t)dictionary->size ||
+		page <= 0 || DICTIONARY_IMAGE_ALIGN % page != 0 || offset % DICTIONARY_IMAGE_ALIGN != 0)
+		return 1;
+	
+	len = entries_len + DIRECT_FANOUT * DIRECT_FANOUT * sizeof(CODE);
+	base = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, offset + DICTIONARY_IMAGE_ALIGN);
+	if (base == MAP_FAILED)
+		return 1;
+	
+	// the list of the used slots is short, and it is written by the insertions: it is read instead of being mapped
+	used = malloc((header.direct_count > 0)?(header.direct_count * sizeof(uint32_t)):(1));
+	if (used == NULL || pread(fd, used, header.direct_count * sizeof(uint32_t), offset + DICTIONARY_IMAGE_ALIGN + len) != (ssize_t)(header.direct_count * sizeof(uint32_t)))
+		goto error;
+	
+	// the image is used only if it is the one which has been written, and its codes and slots are within bounds
+	if (image_crc(base, dictionary_table_bytes(dictionary), (CODE*)(base + entries_len), used, header.direct_count) != header.crc ||
+		image_valid(dictionary, &header, base, (CODE*)(base + entries_len), used) == false)
+		goto error;
+	
+	// the mapping replaces the tables of the dictionary
+	if (dictionary->buckets != NULL) {
+		dictionary_table_free(dictionary->buckets, dictionary_table_bytes(dictionary));
+		dictionary->buckets = (dictionary_bucket*)base;
+	}
+	else {
+		dictionary_table_free(dictionary->entries, dictionary_table_bytes(dictionary));
+		dictionary->entries = (dictionary_entry*)base;
+	}
+	free(dictionary->direct);
+	dictionary->direct = (CODE*)(base + entries_len);
+	dictionary->image_base = base;
+	dictionary->image_len = len;
+	
+	dictionary->epoch = header.epoch;
+	dictionary->counter = header.counter;
+	dictionary->direct_count = header.direct_count;
+	memcpy(dictionary->direct_used, used, header.direct_count * sizeof(uint32_t));
+	dictionary->pending = ROBIN_NONE;
+	dictionary->lru_head = LRU_NONE;
+	dictionary->lru_tail = LRU_NONE;
+	
+	free(used);
+	return 0;
+	
+error:
+	// the dictionary still has its own tables, so the preset entries are inserted instead
+	free(used);
+	munmap(base, len);
+	return 1;
+}
+
+uint32_t image_crc (const void* table, size_t table_len, const CODE* direct, const uint32_t* used, uint32_t used_count)
+{
+	uint32_t crc;
+	
+	crc = crc32c(0, table, table_len);
+	crc = crc32c(crc, direct, DIRECT_FANOUT * DIRECT_FANOUT * sizeof(CODE));
+	return crc32c(crc, used, (size_t)used_count * sizeof(uint32_t));
+}
+
+bool image_valid (DICTIONARY* dictionary, const DICTIONARY_IMAGE* header, const void* table, const CODE* direct, const uint32_t* used)
+{
+	const dictionary_entry* entries;
+	const dictionary_bucket* buckets;
+	CODE limit;
+	int i, j;
+	
+	// the codes of the image are the ones assigned before its counter: from FIRST_CODE to FIRST_CODE + entries - 1
+	limit = FIRST_CODE + (header->counter - SYMBOLS);
+	
+	if (header->layout == DICTIONARY_BUCKETS) {
+		buckets = table;
+		for (i = 0; i < dictionary->size / 8; i++) {
+			if (buckets[i].epoch != header->epoch)
+				continue;
+			if (buckets[i].count > BUCKET_SLOTS || buckets[i].victim >= BUCKET_SLOTS || buckets[i].codes[BUCKET_NONE] != 0)
+				return false;
+			for (j = 0; j < buckets[i].count; j++)
+				if (buckets[i].codes[j] >= limit || (buckets[i].codes[j] != 0 && buckets[i].codes[j] < FIRST_CODE))
+					return false;
+		}
+	}
+	else {
+		entries = table;
+		for (i = 0; i < dictionary->size; i++)
+			if (entries[i].epoch == header->epoch &&
+				(entries[i].code < FIRST_CODE || entries[i].code >= limit || entries[i].parent >= limit))
+				return false;
+	}
+	
+	for (i = 0; i < DIRECT_FANOUT * DIRECT_FANOUT; i++)
+		if (direct[i] != DIRECT_UNUSED && (direct[i] < FIRST_CODE || direct[i] >= limit))
+			return false;
+	
+	for (i = 0; i < (int)header->direct_count; i++)
+		if (used[i] >= DIRECT_FANOUT * DIRECT_FANOUT)
+			return false;
+	
+	return true;
+}
+
+size_t image_align (size_t size)
+{
+	return (size + DICTIONARY_IMAGE_ALIGN - 1) & ~(size_t)(DICTIONARY_IMAGE_ALIGN - 1);
+}
+
+size_t dictionary_table_size (size_t size)
+{
+	if (size < DICTIONARY_HUGE_PAGE)
+		return size;
+	
+	return (size + DICTIONARY_HUGE_PAGE - 1) & ~((size_t)DICTIONARY_HUGE_PAGE - 1);
+}
+
+void* dictionary_table_alloc (size_t size)
+{
+	void* table;
+	
+	if (size == 0)
+		return NULL;
+	
+	// small tables don't fill a huge page, but they start at a cache line, as the buckets need
+	if (size < DICTIONARY_HUGE_PAGE) {
+		if (posix_memalign(&table, 64, size) != 0)
+			return NULL;
+		return memset(table, 0, size);
+	}
+	
+	size = dictionary_table_size(size);
+	
+#ifdef MAP_HUGETLB
+	// explicit huge pages, if the system has reserved some of them
+	table = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	if (table != MAP_FAILED)
+		return table;
+#endif
+	
+	// anonymous pages are zeroed, and the kernel is asked to back them by transparent huge pages (the hint is only advisory)
+	table = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (table == MAP_FAILED)
+		return NULL;
+#ifdef MADV_HUGEPAGE
+	madvise(table, size, MADV_HUGEPAGE);
+#endif
+	
+	return table;
+}
+
+void dictionary_table_free (void* table, size_t size)
+{
+	if (table == NULL)
+		return;
+	
+	if (size < DICTIONARY_HUGE_PAGE)
+		free(table);
+	else
+		munmap(table, dictionary_table_size(size));
+}
+
 uint32_t dictionary_lookup (DICTIONARY* dictionary, CODE parent, SYMBOL symbol)
 {
-	CODE key;
-	uint32_t mask, index, symbol32;
+	uint32_t index;
+	uint64_t probe;
 	
-	LOOKUP_COUNT++;
+	STATS(dictionary->lookups++);
 	
-	// 0x0000FFFF
-	mask = (1 << (sizeof(symbol) * 8))-1;
+	// the children of the first symbols are in the direct table, whose slots follow the entries
+	if (dictionary->direct != NULL && parent < DIRECT_FANOUT && symbol < DIRECT_FANOUT) {
+		STATS(dictionary->direct_lookups++);
+		return dictionary->size + (parent * DIRECT_FANOUT + symbol);
+	}
 	
-	// 0xXXXX0000 shit symbol left by 16 bits
-	symbol32 = (symbol << (sizeof(symbol)*8));
+	// the deeper nodes are in one of two buckets
+	if (dictionary->buckets != NULL)
+		return bucket_lookup(dictionary, ((uint32_t)parent << 8) | symbol);
 	
-	// concatenation of symbol and parent --> symbol | parent
-	key = (symbol32 | (mask & parent));
+	if (dictionary->layout == DICTIONARY_ROBIN_HOOD)
+		return robin_lookup(dictionary, parent, symbol);
 	
 	// get index using hash function
-	index = hash((void*)&key, sizeof(key)) % dictionary->size;
+	index = hash(parent, symbol, dictionary->shift);
 	
-	while (1) {
+	for (probe = 0; ; probe++) {
 		
 		// check if the current entry is unused
-		if (dictionary->entries[index].code == UNUSED)
+		if (dictionary->entries[index].epoch != dictionary->epoch)
 			break;
 		
 		// check if the current entry matches parent and symbol
@@ -126,28 +712,286 @@ uint32_t dictionary_lookup (DICTIONARY* dictionary, CODE parent, SYMBOL symbol)
 			break;
 		
 		// collision occurs -> linear search jumping by 1
-		index = (index + 1) % dictionary->size;
+		index = (index + 1) & dictionary->mask;
+	}
+	
+#ifndef LZ78_NO_STATS
+	dictionary->collisions += probe;
+	if (probe > dictionary->max_probe)
+		dictionary->max_probe = probe;
+	dictionary->probes[probe_bucket(probe)]++;
+#endif
+	
+	return index;
+}
+
+uint32_t robin_lookup (DICTIONARY* dictionary, CODE parent, SYMBOL symbol)
+{
+	dictionary_entry* entry;
+	uint32_t index;
+	uint64_t probe;
+	
+	index = hash(parent, symbol, dictionary->shift);
+	
+	// the entries of a cluster are sorted by home slot, so the key can't lie after one which is closer to its home than
+	// the key would be: the probe length is at most ROBIN_MAX_DISTANCE + 1, even for a missing key
+	for (probe = 0; ; probe++) {
+		entry = &dictionary->entries[index];
+		if (entry->epoch != dictionary->epoch || entry->distance < probe) {
+			dictionary->pending = index;
+			break;
+		}
+		if (entry->parent == parent && entry->symbol == symbol) {
+			dictionary->pending = ROBIN_NONE;
+			break;
+		}
+		index = (index + 1) & dictionary->mask;
+	}
+	
+#ifndef LZ78_NO_STATS
+	dictionary->collisions += probe;
+	if (probe > dictionary->max_probe)
+		dictionary->max_probe = probe;
+	dictionary->probes[probe_bucket(probe)]++;
+#endif
+	
+	return index;
+}
+
+void robin_put (DICTIONARY* dictionary, uint32_t index, CODE parent, CODE code, SYMBOL symbol)
+{
+	dictionary_entry entry, tmp;
+	uint32_t distance;
+	
+	distance = (index - hash(parent, symbol, dictionary->shift)) & dictionary->mask;
+	entry.parent = parent;
+	entry.code = code;
+	entry.symbol = (uint8_t)symbol;
+	entry.epoch = dictionary->epoch;
+	dictionary->pending = ROBIN_NONE;
+	
+	for (;;) {
+		// an entry which would be too far from its home slot is dropped (see dictionary.h)
+		if (distance > ROBIN_MAX_DISTANCE)
+			return;
+		entry.distance = (uint8_t)distance;
 		
-		COLLISIONS++;
+		if (dictionary->entries[index].epoch != dictionary->epoch) {
+			dictionary->entries[index] = entry;
+			return;
+		}
+		
+		// the entry takes the slot of a richer one, which goes on looking for a slot
+		if (dictionary->entries[index].distance < distance) {
+			tmp = dictionary->entries[index];
+			dictionary->entries[index] = entry;
+			entry = tmp;
+			distance = entry.distance;
+		}
+		
+		distance++;
+		index = (index + 1) & dictionary->mask;
 	}
+}
+
+uint32_t bucket_lookup (DICTIONARY* dictionary, uint32_t key)
+{
+	dictionary_bucket* bucket;
+	uint32_t first, second, match, index;
+	uint64_t probe;
+	int count, slot;
+	
+	bucket_pair(dictionary, key, &first, &second);
+	
+	// both cache lines are requested at once, since the second one is read whenever the key is not in the first one
+	__builtin_prefetch(&dictionary->buckets[second]);
+	
+	bucket = &dictionary->buckets[first];
+	count = (bucket->epoch == dictionary->epoch)?(bucket->count):(0);
+	match = dictionary->bucket_match(bucket, key) & ((1U << count) - 1);
+	probe = 0;
+	
+	if (match != 0)
+		index = (first << 3) | (uint32_t)__builtin_ctz(match);
+	else {
+		bucket = &dictionary->buckets[second];
+		count = (bucket->epoch == dictionary->epoch)?(bucket->count):(0);
+		match = dictionary->bucket_match(bucket, key) & ((1U << count) - 1);
+		probe = 1;
+		
+		// a new key goes in its first bucket while it has room, so that most of the keys are found by reading a single
+		// cache line, then in the second one, or in a slot freed by moving other entries away from the first one
+		if (match != 0)
+			index = (second << 3) | (uint32_t)__builtin_ctz(match);
+		else if ((slot = bucket_free_slot(dictionary, first)) != BUCKET_NONE)
+			index = (first << 3) | (uint32_t)slot;
+		else if ((slot = bucket_free_slot(dictionary, second)) != BUCKET_NONE)
+			index = (second << 3) | (uint32_t)slot;
+		else
+			index = (first << 3) | (uint32_t)bucket_make_room(dictionary, first, &probe);
+	}
+	
+#ifndef LZ78_NO_STATS
+	dictionary->collisions += probe;
+	if (probe > dictionary->max_probe)
+		dictionary->max_probe = probe;
+	dictionary->probes[probe_bucket(probe)]++;
+#endif
+	
+	// the code of the returned slot tells if it is used, as for the direct table
+	if (match == 0)
+		dictionary->buckets[index >> 3].codes[index & 7] = BUCKET_FREE;
 	
 	return index;
 }
 
-uint32_t hash (void* key, int len)
+void bucket_pair (DICTIONARY* dictionary, uint32_t key, uint32_t* first, uint32_t* second)
 {
-	unsigned char* p;
-	uint32_t h;
-	int i;
+	*first = (uint32_t)(((uint64_t)key * HASH_MULTIPLIER) >> dictionary->shift);
+	*second = (uint32_t)(((uint64_t)key * HASH_MULTIPLIER2) >> dictionary->shift);
+	if (*second == *first)
+		*second ^= 1;
+}
+
+int bucket_free_slot (DICTIONARY* dictionary, uint32_t bucket)
+{
+	dictionary_bucket* b;
+	uint32_t holes;
+	
+	b = &dictionary->buckets[bucket];
+	if (b->epoch != dictionary->epoch)
+		return 0;
+	if (b->count < BUCKET_SLOTS)
+		return b->count;
+	
+	// the holes are left by the moves whose new entry hasn't been inserted (because the key was only looked up)
+	holes = dictionary->bucket_match(b, BUCKET_HOLE) & ((1U << BUCKET_SLOTS) - 1);
+	
+	return (holes != 0)?(__builtin_ctz(holes)):(BUCKET_NONE);
+}
+
+int bucket_make_room (DICTIONARY* dictionary, uint32_t bucket, uint64_t* moves)
+{
+	dictionary_bucket* b;
+	uint32_t path_buckets[BUCKET_PATH + 1];
+	int path_slots[BUCKET_PATH + 1];
+	uint32_t first, second, key;
+	int depth, slot, i;
+	
+	// walking the path: every entry goes to its other bucket, in place of the next entry of the path
+	path_buckets[0] = bucket;
+	for (depth = 0; depth < BUCKET_PATH; depth++) {
+		b = &dictionary->buckets[path_buckets[depth]];
+		slot = b->victim;
+		b->victim = (b->victim + 1) % BUCKET_SLOTS;
+		
+		// an entry can't be moved twice
+		for (i = 0; i < depth; i++)
+			if (path_buckets[i] == path_buckets[depth] && path_slots[i] == slot)
+				return BUCKET_NONE;
+		path_slots[depth] = slot;
+		
+		bucket_pair(dictionary, b->keys[slot], &first, &second);
+		path_buckets[depth + 1] = (first == path_buckets[depth])?(second):(first);
+		slot = bucket_free_slot(dictionary, path_buckets[depth + 1]);
+		if (slot != BUCKET_NONE)
+			break;
+	}
+	if (depth == BUCKET_PATH)
+		return BUCKET_NONE;
+	
+	// moving the entries from the last one, each one to the slot freed by the following one
+	path_slots[depth + 1] = slot;
+	for (i = depth; i >= 0; i--) {
+		b = &dictionary->buckets[path_buckets[i]];
+		key = b->keys[path_slots[i]];
+		bucket_put(dictionary, path_buckets[i + 1], path_slots[i + 1], key, b->codes[path_slots[i]]);
+		b->keys[path_slots[i]] = BUCKET_HOLE;
+		b->codes[path_slots[i]] = BUCKET_FREE;
+	}
+	*moves += depth + 1;
 	
-	p = key;
-	h = 5381;
+	return path_slots[0];
+}
+
+void bucket_put (DICTIONARY* dictionary, uint32_t bucket, int slot, uint32_t key, CODE code)
+{
+	dictionary_bucket* b;
 	
-	for (i = 0; i < len; i++) {
-		h = ((h << 5) + h) ^ p[i];	// h = h*33^p[i]
+	b = &dictionary->buckets[bucket];
+	if (b->epoch != dictionary->epoch) {
+		b->epoch = dictionary->epoch;
+		b->count = 0;
 	}
+	b->keys[slot] = key;
+	b->codes[slot] = code;
+	if (slot >= b->count)
+		b->count = slot + 1;
+}
+
+uint32_t bucket_match_scalar (const dictionary_bucket* bucket, uint32_t key)
+{
+	uint32_t match;
+	int i;
+	
+	match = 0;
+	for (i = 0; i < BUCKET_SLOTS; i++)
+		match |= (uint32_t)(bucket->keys[i] == key) << i;
+	
+	return match;
+}
+
+#ifdef DICTIONARY_SIMD
+uint32_t bucket_match_sse2 (const dictionary_bucket* bucket, uint32_t key)
+{
+	__m128i k, low, high;
+	
+	k = _mm_set1_epi32((int)key);
+	low = _mm_cmpeq_epi32(_mm_load_si128((const __m128i*)bucket->keys), k);
+	high = _mm_cmpeq_epi32(_mm_load_si128((const __m128i*)(bucket->keys + 4)), k);
+	
+	return (uint32_t)(_mm_movemask_ps(_mm_castsi128_ps(low)) | (_mm_movemask_ps(_mm_castsi128_ps(high)) << 4));
+}
+
+uint32_t bucket_match_avx2 (const dictionary_bucket* bucket, uint32_t key)
+{
+	__m256i keys;
+	
+	keys = _mm256_cmpeq_epi32(_mm256_load_si256((const __m256i*)bucket->keys), _mm256_set1_epi32((int)key));
 	
-	return h;
+	return (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(keys));
+}
+#endif
+
+size_t dictionary_table_bytes (DICTIONARY* dictionary)
+{
+	if (dictionary->layout == DICTIONARY_BUCKETS)
+		return (size_t)(dictionary->size / 8) * sizeof(dictionary_bucket);
+	
+	return (size_t)dictionary->size * sizeof(dictionary_entry);
+}
+
+int probe_bucket (uint64_t probe)
+{
+	int bucket;
+	
+	if (probe < 4)
+		return (int)probe;
+	
+	// 4-7 is the bucket 4, 8-15 the bucket 5, and so on
+	bucket = 63 - __builtin_clzll(probe) + 2;
+	
+	return (bucket < PROBE_BUCKETS)?(bucket):(PROBE_BUCKETS - 1);
+}
+
+uint32_t hash (CODE parent, SYMBOL symbol, int shift)
+{
+	uint64_t key;
+	
+	// concatenation of parent and symbol --> parent | symbol
+	key = ((uint64_t)parent << (sizeof(symbol) * 8)) | symbol;
+	
+	return (uint32_t)((key * HASH_MULTIPLIER) >> shift);
 }
 
 int dictionary_insert(DICTIONARY* dictionary, uint32_t index, CODE parent, CODE code, SYMBOL symbol)
@@ -155,19 +999,167 @@ int dictionary_insert(DICTIONARY* dictionary, uint32_t index, CODE parent, CODE
 	if (dictionary == NULL)
 		return -1;
 	
-	dictionary->entries[index].parent = parent;
-	dictionary->entries[index].code = code;
-	dictionary->entries[index].symbol = symbol;
+	// a slot of the direct table only holds the code, and it is recorded to be cleared by the next reset
+	if (index >= dictionary->size) {
+		if (dictionary->direct[index - dictionary->size] == DIRECT_UNUSED)
+			dictionary->direct_used[dictionary->direct_count++] = index - dictionary->size;
+		dictionary->direct[index - dictionary->size] = code;
+	}
+	// an entry without room in the bucketized table is dropped (see dictionary.h)
+	else if (dictionary->buckets != NULL) {
+		if ((index & 7) != BUCKET_NONE)
+			bucket_put(dictionary, index >> 3, index & 7, ((uint32_t)parent << 8) | symbol, code);
+	}
+	else if (dictionary->layout == DICTIONARY_ROBIN_HOOD)
+		robin_put(dictionary, index, parent, code, symbol);
+	else {
+		dictionary->entries[index].parent = parent;
+		dictionary->entries[index].code = code;
+		dictionary->entries[index].symbol = symbol;
+		dictionary->entries[index].epoch = dictionary->epoch;
+	}
 	dictionary->counter++;
 	
+	// the new leaf follows its parent in the recency list, so that its parent stays more recent
+	if (dictionary->lru_next != NULL) {
+		dictionary->lru_index[code] = index;
+		lru_link(dictionary, code, (parent >= FIRST_CODE)?(parent):(LRU_NONE));
+	}
+	
 	return 0;
 }
 
+int dictionary_lru_alloc (DICTIONARY* dictionary, CODE codes, bool hashed)
+{
+	if (dictionary == NULL || dictionary->layout != DICTIONARY_LINEAR)
+		return -1;
+	
+	dictionary->lru_codes = codes;
+	dictionary->hashed = hashed;
+	dictionary->lru_next = dictionary_table_alloc((size_t)codes * sizeof(CODE));
+	dictionary->lru_prev = dictionary_table_alloc((size_t)codes * sizeof(CODE));
+	dictionary->lru_index = dictionary_table_alloc((size_t)codes * sizeof(uint32_t));
+	if (dictionary->lru_next == NULL || dictionary->lru_prev == NULL || dictionary->lru_index == NULL)
+		return -1;
+	
+	dictionary->lru_head = LRU_NONE;
+	dictionary->lru_tail = LRU_NONE;
+	
+	return 0;
+}
+
+void lru_unlink (DICTIONARY* dictionary, CODE code)
+{
+	CODE prev, next;
+	
+	prev = dictionary->lru_prev[code];
+	next = dictionary->lru_next[code];
+	
+	if (prev != LRU_NONE)
+		dictionary->lru_next[prev] = next;
+	else
+		dictionary->lru_head = next;
+	
+	if (next != LRU_NONE)
+		dictionary->lru_prev[next] = prev;
+	else
+		dictionary->lru_tail = prev;
+}
+
+void lru_link (DICTIONARY* dictionary, CODE code, CODE prev)
+{
+	CODE next;
+	
+	next = (prev != LRU_NONE)?(dictionary->lru_next[prev]):(dictionary->lru_head);
+	
+	dictionary->lru_prev[code] = prev;
+	dictionary->lru_next[code] = next;
+	
+	if (prev != LRU_NONE)
+		dictionary->lru_next[prev] = code;
+	else
+		dictionary->lru_head = code;
+	
+	if (next != LRU_NONE)
+		dictionary->lru_prev[next] = code;
+	else
+		dictionary->lru_tail = code;
+}
+
+void dictionary_touch (DICTIONARY* dictionary, CODE code)
+{
+	// moving every node of the path to the head, from the deepest one up, so that every node stays more recent than its descendants
+	while (code >= FIRST_CODE) {
+		if (dictionary->lru_head != code) {
+			lru_unlink(dictionary, code);
+			lru_link(dictionary, code, LRU_NONE);
+		}
+		code = dictionary_get_entry_parent(dictionary, dictionary->lru_index[code]);
+	}
+}
+
+CODE dictionary_lru_code (DICTIONARY* dictionary)
+{
+	return dictionary->lru_tail;
+}
+
+CODE dictionary_evict (DICTIONARY* dictionary)
+{
+	CODE code;
+	uint32_t index;
+	
+	code = dictionary->lru_tail;
+	if (code == LRU_NONE)
+		return code;
+	
+	lru_unlink(dictionary, code);
+	index = dictionary->lru_index[code];
+	
+	// a slot of the direct table is freed without being logged again, the entries of the hash table keep their probe sequences,
+	// while an entry indexed by code is simply overwritten by the next insertion
+	if (index >= dictionary->size)
+		dictionary->direct[index - dictionary->size] = DIRECT_FREED;
+	else if (dictionary->hashed == true)
+		dictionary_remove(dictionary, index);
+	else
+		dictionary->entries[index].epoch = 0;
+	
+	dictionary->counter--;
+	
+	return code;
+}
+
+void dictionary_remove (DICTIONARY* dictionary, uint32_t index)
+{
+	uint32_t next, home;
+	
+	dictionary->entries[index].epoch = 0;
+	
+	for (next = (index + 1) & dictionary->mask; dictionary->entries[next].epoch == dictionary->epoch; next = (next + 1) & dictionary->mask) {
+		home = hash(dictionary->entries[next].parent, dictionary->entries[next].symbol, dictionary->shift);
+		
+		// the entry can fill the hole only if the hole lies between its home and its slot
+		if (((next - home) & dictionary->mask) < ((next - index) & dictionary->mask))
+			continue;
+		
+		dictionary->entries[index] = dictionary->entries[next];
+		dictionary->entries[next].epoch = 0;
+		dictionary->lru_index[dictionary->entries[index].code] = index;
+		index = next;
+	}
+}
+
 CODE dictionary_get_entry_code(DICTIONARY* dictionary, uint32_t index)
 {
 	if (dictionary == NULL)
 		return -1;
 	
+	if (index >= dictionary->size)
+		return dictionary->direct[index - dictionary->size];
+	
+	if (dictionary->buckets != NULL)
+		return dictionary->buckets[index >> 3].codes[index & 7];
+	
 	return dictionary->entries[index].code;
 }
 
@@ -176,6 +1168,14 @@ CODE dictionary_get_entry_parent(DICTIONARY* dictionary, uint32_t index)
 	if (dictionary == NULL)
 		return -2;
 	
+	// the parent and the symbol of a direct table slot are given by its position
+	if (index >= dictionary->size)
+		return (index - dictionary->size) / DIRECT_FANOUT;
+	
+	// the key of a bucket's slot is the parent followed by the symbol
+	if (dictionary->buckets != NULL)
+		return dictionary->buckets[index >> 3].keys[index & 7] >> 8;
+	
 	return dictionary->entries[index].parent;
 }
 
@@ -184,6 +1184,12 @@ SYMBOL dictionary_get_entry_symbol(DICTIONARY* dictionary, uint32_t index)
 	if (dictionary == NULL)
 		return -1;
 	
+	if (index >= dictionary->size)
+		return (index - dictionary->size) % DIRECT_FANOUT;
+	
+	if (dictionary->buckets != NULL)
+		return dictionary->buckets[index >> 3].keys[index & 7] & 0xFF;
+	
 	return dictionary->entries[index].symbol;
 }
 
@@ -203,6 +1209,78 @@ int dictionary_count(DICTIONARY* dictionary)
 	return dictionary->counter;
 }
 
+uint64_t dictionary_lookups(DICTIONARY* dictionary)
+{
+	if (dictionary == NULL)
+		return 0;
+	
+	return dictionary->lookups;
+}
+
+uint64_t dictionary_collisions(DICTIONARY* dictionary)
+{
+	if (dictionary == NULL)
+		return 0;
+	
+	return dictionary->collisions;
+}
+
+uint64_t dictionary_direct_lookups(DICTIONARY* dictionary)
+{
+	if (dictionary == NULL)
+		return 0;
+	
+	return dictionary->direct_lookups;
+}
+
+uint64_t dictionary_max_probe(DICTIONARY* dictionary)
+{
+	if (dictionary == NULL)
+		return 0;
+	
+	return dictionary->max_probe;
+}
+
+void dictionary_probes(DICTIONARY* dictionary, uint64_t* probes)
+{
+	int i;
+	
+	if (dictionary == NULL)
+		return;
+	
+	for (i = 0; i < PROBE_BUCKETS; i++)
+		probes[i] += dictionary->probes[i];
+}
+
+void dictionary_stats_clear(DICTIONARY* dictionary)
+{
+	if (dictionary == NULL)
+		return;
+	
+	dictionary->lookups = 0;
+	dictionary->direct_lookups = 0;
+	dictionary->collisions = 0;
+	dictionary->max_probe = 0;
+	memset(dictionary->probes, 0, sizeof(dictionary->probes));
+}
+
+size_t dictionary_memory(DICTIONARY* dictionary)
+{
+	size_t memory;
+	
+	if (dictionary == NULL)
+		return 0;
+	
+	memory = sizeof(DICTIONARY) + dictionary_table_size(dictionary_table_bytes(dictionary));
+	if (dictionary->direct != NULL)
+		memory += DIRECT_FANOUT * DIRECT_FANOUT * (sizeof(CODE) + sizeof(uint32_t));
+	if (dictionary->lru_next != NULL)
+		memory += 2 * dictionary_table_size((size_t)dictionary->lru_codes * sizeof(CODE)) +
+				dictionary_table_size((size_t)dictionary->lru_codes * sizeof(uint32_t));
+	
+	return memory;
+}
+
 int dictionary_availables(DICTIONARY* dictionary)
 {
 	if (dictionary == NULL)
@@ -214,7 +1292,15 @@ int dictionary_availables(DICTIONARY* dictionary)
 bool dictionary_is_entry_unused(DICTIONARY* dictionary, uint32_t index)
 {
 	if (dictionary != NULL) {
-		if (dictionary->entries[index].code == UNUSED)
+		if (index >= dictionary->size)
+			return (dictionary->direct[index - dictionary->size] < FIRST_CODE);
+		if (dictionary->buckets != NULL)
+			return (dictionary->buckets[index >> 3].codes[index & 7] < FIRST_CODE);
+		if (dictionary->entries[index].epoch != dictionary->epoch)
+			return true;
+		
+		// the slot of a missing key in the Robin Hood table can still hold the entry which is moved by the insertion
+		if (index == dictionary->pending)
 			return true;
 	}
 	
@@ -235,10 +1321,21 @@ void dictionary_print (DICTIONARY* dictionary)
 	fprintf(fp,"ENTRY\tCODE\tPARENT\tSYMBOL\n");
 	
 	for(i = 0; i < dictionary->size; i++) {
+		if (dictionary_is_entry_unused(dictionary, i))
+			continue;
 		fprintf(fp,"%d\t%d\t%d\t0x%02X\n", i,
-				dictionary->entries[i].code,
-		  dictionary->entries[i].parent,
-		  dictionary->entries[i].symbol);
+				dictionary_get_entry_code(dictionary, i),
+		  dictionary_get_entry_parent(dictionary, i),
+		  dictionary_get_entry_symbol(dictionary, i));
+	}
+	
+	if (dictionary->direct != NULL) {
+		for(i = 0; i < DIRECT_FANOUT * DIRECT_FANOUT; i++) {
+			if (dictionary_is_entry_unused(dictionary, dictionary->size + i))
+				continue;
+			fprintf(fp,"%d\t%d\t%d\t0x%02X\n", dictionary->size + i,
+					dictionary->direct[i], i / DIRECT_FANOUT, i % DIRECT_FANOUT);
+		}
 	}
 	
 	if (fclose(fp) != 0)
@@ -9,12 +9,76 @@
 
 #include "definitions.h"
 
+#include <sys/types.h>
+
+#define DICTIONARY_LOAD_FACTOR		50		// default maximum percentage of used entries of the compressor's table
+#define DICTIONARY_ROBIN_LOAD_FACTOR	90		// default maximum percentage of used entries of the Robin Hood table
+#define DICTIONARY_MIN_LOAD_FACTOR	10		// minimum percentage of used entries which can be requested
+#define DICTIONARY_MAX_LOAD_FACTOR	90		// maximum percentage of used entries which can be requested
+
+#define DICTIONARY_HUGE_PAGE		(2 * 1024 * 1024)	// size (in bytes) of a huge page, from which the tables are backed by huge pages
+
+#define DICTIONARY_LINEAR			0		// layout of the compressor's table: entries placed by linear probing
+#define DICTIONARY_BUCKETS			1		// layout of the compressor's table: cache line buckets, with two choices for every entry
+#define DICTIONARY_ROBIN_HOOD		2		// layout of the compressor's table: entries placed by Robin Hood linear probing
+
+#define DICTIONARY_IMAGE_ALIGN		4096	// alignment (in bytes) of the sections of a dictionary image in its file
+#define DICTIONARY_IMAGE_VERSION	2		// current version of the dictionary image
+
+/**
+ * NOTE ON THE BUCKETIZED TABLE
+ *
+ * With DICTIONARY_BUCKETS the hash table of a compressor is made of 64 bytes buckets (a cache line each), holding
+ * the keys (parent << 8 | symbol) of 7 entries side by side, so that a bucket is searched by a single comparison
+ * of its keys (AVX2, or two SSE2 ones, chosen at run time; a loop on the other processors). Every key has two
+ * buckets, given by two hash functions: it is placed in the first one while it has room, then in the second one
+ * (so that most lookups read a single cache line), and when both are full the entries
+ * of a short path of buckets are moved to their other bucket to make room (cuckoo placement). A lookup reads at
+ * most two cache lines, whose loads are issued together, instead of walking a cluster of entries.
+ * The indexes of the entries are bucket * 8 + slot. If no path is found (which needs both buckets and all the
+ * buckets around them to be full, far beyond DICTIONARY_MAX_LOAD_FACTOR) the new entry is dropped: the
+ * compressor doesn't find that phrase again, which costs some ratio but keeps the stream decodable.
+ */
+
+/**
+ * NOTE ON THE ROBIN HOOD TABLE
+ *
+ * With DICTIONARY_ROBIN_HOOD the entries are placed by linear probing, but a new entry takes the slot of any entry
+ * which is closer to its home slot (the one given by the hash function) than the new one would be, and the evicted
+ * entry goes on probing from there. The entries of a cluster stay sorted by home slot, so every entry records its
+ * distance from home and a lookup stops as soon as it meets an entry with a lower distance than its probe length:
+ * a missing key costs about as much as a found one, and the variance of the probe lengths is low enough to fill the
+ * table up to DICTIONARY_ROBIN_LOAD_FACTOR (its default load factor). The distances are bounded by 255 (a byte of
+ * the entry): an entry which would be pushed farther is dropped, as the bucketized table does, which never happens
+ * below DICTIONARY_MAX_LOAD_FACTOR in practice. The dropped entry is not necessarily the new one: it can be an entry
+ * inserted earlier and displaced by the insertion, so an older phrase is the one the compressor doesn't find again
+ * (the stream stays decodable, but the compressed data differs from the other layouts').
+ */
+
+/**
+ * NOTE ON THE DICTIONARY IMAGE
+ *
+ * A dictionary image is the binary counterpart of what dictionary_print dumps: the tables of a compressor's dictionary
+ * as they are in memory, so that a file holding it can be mapped as the starting state of any number of dictionaries
+ * with the same size. Every section starts at a multiple of DICTIONARY_IMAGE_ALIGN from the start of the file:
+ *
+ * 			+-----------+-------------------+-------------------+---------------------------+
+ * 			|  header	|	entries table	|	direct table	|	used slots of the direct	|
+ * 			+-----------+-------------------+-------------------+---------------------------+
+ *
+ * The header holds the magic 'L' '7' '8' 'T', the version, the layout of the table, the scalar state of the
+ * dictionary (its epoch and counters) and the CRC32C of the three tables. The fields are in the byte order of the
+ * machine which wrote them: an image written by a different one doesn't match, and the dictionary is built again by
+ * insertions. So it is when the CRC32C differs, or when a code or a used slot is out of the bounds given by the header.
+ */
+
 // dictionary structure
 typedef struct dictionary_struct dictionary;
 
 // dictionary functions
 /**
- * @brief It initializes the dictionary of the compressor. It uses the dictionary_lookup to insert the entries
+ * @brief It initializes (or resets) the dictionary of the compressor in constant time. The children of the root are implicit:
+ * 		the code of a symbol is the symbol itself, so they are neither stored nor looked up
  * 
  * @param dictionary The pointer to the dictionary
  * @return void
@@ -22,7 +86,8 @@ typedef struct dictionary_struct dictionary;
 void dictionary_compressor_init (dictionary* dictionary);
 
 /**
- * @brief It initializes the dictionary of the decompressor. It inserts entries in a sorted manner
+ * @brief It initializes (or resets) the dictionary of the decompressor in constant time. The entries are indexed by code,
+ * 		and the children of the root (the codes below FIRST_CODE) are implicit, so they have no entry
  * 
  * @param dictionary The pointer to the dictionary
  * @return void
@@ -32,10 +97,32 @@ void dictionary_decompressor_init (dictionary* dictionary);
 /**
  * @brief It allocates the dictionary's structures in dynamic memory
  * 
- * @param size the size of the dictionary entries table
+ * @param size the size of the dictionary entries table, rounded up to a power of two
+ * @param direct flag telling to add a direct table for the children of the first 256 symbols, whose lookups
+ * 		skip the hash function (compressor only: the indexes of its slots follow the ones of the entries table)
+ * @param layout the layout of the hash table of a compressor (DICTIONARY_LINEAR, DICTIONARY_BUCKETS, which
+ * 		needs the direct table, or DICTIONARY_ROBIN_HOOD)
  * @return dictionary_entry* The pointer to the allocated dictionary
  */
-dictionary* dictionary_alloc (int size);
+dictionary* dictionary_alloc (int size, bool direct, int layout);
+
+/**
+ * @brief It allocates a zeroed table of the dictionary (or of the decompressor's per code data): a large one is mapped
+ * 		on huge pages, falling back to transparent huge pages when none is reserved, to keep TLB misses down
+ * 
+ * @param size the size (in bytes) of the table
+ * @return void* The pointer to the table, or NULL if an error occurs
+ */
+void* dictionary_table_alloc (size_t size);
+
+/**
+ * @brief It deallocates a table allocated by dictionary_table_alloc
+ * 
+ * @param table The pointer to the table, or NULL
+ * @param size the size (in bytes) of the table, the same given to dictionary_table_alloc
+ * @return void
+ */
+void dictionary_table_free (void* table, size_t size);
 
 /**
  * @brief It deallocates the dictionary's structures which are allocated in dynamic memory
@@ -45,6 +132,66 @@ dictionary* dictionary_alloc (int size);
  */
 void dictionary_free (dictionary* dictionary);
 
+/**
+ * @brief It writes the image of a compressor's dictionary at the end of a file, after the padding
+ * 		which aligns it. The dictionary has to have the direct table, and no LRU replacement
+ * 
+ * @param dictionary The pointer to the dictionary
+ * @param fp the file, open for writing
+ * @return int a flag indicating if the image has been written (0) or if an error occurs (-1)
+ */
+int dictionary_image_save (dictionary* dictionary, FILE* fp);
+
+/**
+ * @brief It makes an image the starting state of a compressor's dictionary, without any insertion. The tables are
+ * 		mapped privately from the file, so they share the page cache with the other dictionaries mapping it until
+ * 		an insertion copies a page. A dictionary is mapped only once: its following resets are up to the caller
+ * 
+ * @param dictionary The pointer to the dictionary
+ * @param fd the descriptor of the file, which can be closed once the image is mapped
+ * @param offset the position of the image in the file, a multiple of DICTIONARY_IMAGE_ALIGN
+ * @return int 0 if the image is the state of the dictionary, or 1 if it doesn't fit the dictionary or it is damaged
+ * 		(the dictionary is unchanged)
+ */
+int dictionary_image_map (dictionary* dictionary, int fd, off_t offset);
+
+/**
+ * @brief It enables the LRU replacement policy: the codes are kept in a recency list, where every node is more recent
+ * 		than all its descendants, so that the least recently used code is always a leaf, which can be reused.
+ * 		The bucketized and the Robin Hood tables don't support it, since they can drop or move an entry which the recency list needs
+ * 
+ * @param dictionary The pointer to the dictionary
+ * @param codes the number of codes (the highest code plus one)
+ * @param hashed flag telling that the entries are placed by the hash function (compressor), and not by code (decompressor)
+ * @return int a flag indicating if the allocation has been completed successfully (0) or if an error occurs (-1)
+ */
+int dictionary_lru_alloc (dictionary* dictionary, CODE codes, bool hashed);
+
+/**
+ * @brief It marks a code as the most recently used one, together with all its ancestors, which become more recent than it
+ * 
+ * @param dictionary The pointer to the dictionary
+ * @param code the code which has been written or read
+ * @return void
+ */
+void dictionary_touch (dictionary* dictionary, CODE code);
+
+/**
+ * @brief It returns the least recently used code, which is a leaf
+ * 
+ * @param dictionary The pointer to the dictionary
+ * @return CODE the least recently used code, or a code below FIRST_CODE if there is no code in the dictionary
+ */
+CODE dictionary_lru_code (dictionary* dictionary);
+
+/**
+ * @brief It removes the least recently used code from the dictionary, so that it can be assigned again
+ * 
+ * @param dictionary The pointer to the dictionary
+ * @return CODE the removed code, or a code below FIRST_CODE if there is no code in the dictionary
+ */
+CODE dictionary_evict (dictionary* dictionary);
+
 /**
  * @brief It looks for a node containing "symbol", which is child of to the node having code "parent"
  * 
@@ -56,7 +203,8 @@ void dictionary_free (dictionary* dictionary);
 uint32_t dictionary_lookup (dictionary* dictionary, CODE parent, SYMBOL symbol);
 
 /**
- * @brief It inserts an entry in the dictionary. In case of an already used entry, the fields will be overwritten
+ * @brief It inserts an entry in the dictionary. In case of an already used entry, the fields will be overwritten.
+ * 		With the LRU replacement policy, the new leaf becomes a bit less recent than its parent
  * 
  * @param dictionary The pointer to the dictionary
  * @param index the index where to put the new entry
@@ -110,6 +258,64 @@ int dictionary_size (dictionary* dictionary);
  */
 int dictionary_count (dictionary* dictionary);
 
+/**
+ * @brief It returns the number of lookups performed on the dictionary
+ * 
+ * @param dictionary The pointer to the dictionary
+ * @return uint64_t the number of lookups, or 0 in case of error
+ */
+uint64_t dictionary_lookups (dictionary* dictionary);
+
+/**
+ * @brief It returns the number of collisions (linear or Robin Hood probing steps, or buckets read after the first one
+ * 		and entries moved by the bucketized table) of the lookups performed on the dictionary
+ * 
+ * @param dictionary The pointer to the dictionary
+ * @return uint64_t the number of collisions, or 0 in case of error
+ */
+uint64_t dictionary_collisions (dictionary* dictionary);
+
+/**
+ * @brief It returns the number of lookups served by the direct table, without hashing
+ * 
+ * @param dictionary The pointer to the dictionary
+ * @return uint64_t the number of lookups, or 0 in case of error
+ */
+uint64_t dictionary_direct_lookups (dictionary* dictionary);
+
+/**
+ * @brief It returns the length of the longest sequence of collisions of a lookup performed on the dictionary
+ * 
+ * @param dictionary The pointer to the dictionary
+ * @return uint64_t the number of collisions, or 0 in case of error
+ */
+uint64_t dictionary_max_probe (dictionary* dictionary);
+
+/**
+ * @brief It adds the histogram of the probe lengths of the hashed lookups performed on the dictionary to another one
+ * 
+ * @param dictionary The pointer to the dictionary
+ * @param probes the histogram, of PROBE_BUCKETS elements
+ * @return void
+ */
+void dictionary_probes (dictionary* dictionary, uint64_t* probes);
+
+/**
+ * @brief It sets the lookup counters of the dictionary (lookups, collisions, longest probe and histogram) back to 0
+ * 
+ * @param dictionary The pointer to the dictionary
+ * @return void
+ */
+void dictionary_stats_clear (dictionary* dictionary);
+
+/**
+ * @brief It returns the memory used by the dictionary, its tables included
+ * 
+ * @param dictionary The pointer to the dictionary
+ * @return size_t the size (in bytes) of the memory, or 0 in case of error
+ */
+size_t dictionary_memory (dictionary* dictionary);
+
 /**
  * @brief It returns the number of available entries in the dictionary
  * 
@@ -128,7 +334,7 @@ int dictionary_availables (dictionary* dictionary);
 bool dictionary_is_entry_unused (dictionary* dictionary, uint32_t index);
 
 /**
- * @brief It prints the entire dictionary content on a file
+ * @brief It prints the used entries of the dictionary on a file
  * 
  * @param dictionary The pointer to the dictionary
  * @return void
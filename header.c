@@ -0,0 +1,241 @@
+/*
+ * header.c
+ * Francesco Piras - Dario Varano
+ * June 2015
+ */
+
+#include "header.h"
+#include "preset.h"
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/**
+ * @brief The first bytes of a stream with a header
+ * 
+ */
+static const uint8_t magic[3] = { 'L', '7', '8' };
+
+void header_init (HEADER* header, OPTIONS* options, uint8_t flags, uint32_t block_size)
+{
+	header->version = HEADER_VERSION;
+	header->flags = flags;
+	if (options->variable == true)
+		header->flags |= HEADER_FLAG_VARIABLE;
+	if (options->adaptive == true)
+		header->flags |= HEADER_FLAG_ADAPTIVE;
+	if (options->lru == true)
+		header->flags |= HEADER_FLAG_LRU;
+	if (options->standby > 0)
+		header->flags |= HEADER_FLAG_STANDBY;
+	if (options->checksum == true)
+		header->flags |= HEADER_FLAG_CHECKSUM;
+	if (options->preset != NULL)
+		header->flags |= HEADER_FLAG_PRESET;
+	header->preset_id = (options->preset != NULL)?(options->preset->id):(0);
+	header->extra = (options->index == true && flags == 0)?(HEADER_EXTRA_INDEX):(0);
+	header->bits = options->bits;
+	header->standby = options->standby;
+	header->dict_size = options->dict_size;
+	header->block_size = block_size;
+}
+
+void header_options (HEADER* header, OPTIONS* options)
+{
+	options->bits = header->bits;
+	options->dict_size = header->dict_size;
+	options->variable = ((header->flags & HEADER_FLAG_VARIABLE) != 0)?(true):(false);
+	options->adaptive = ((header->flags & HEADER_FLAG_ADAPTIVE) != 0)?(true):(false);
+	options->lru = ((header->flags & HEADER_FLAG_LRU) != 0)?(true):(false);
+	options->standby = ((header->flags & HEADER_FLAG_STANDBY) != 0)?(header->standby):(0);
+	options->checksum = ((header->flags & HEADER_FLAG_CHECKSUM) != 0)?(true):(false);
+	if ((header->flags & HEADER_FLAG_PRESET) == 0)
+		options->preset = NULL;
+}
+
+void header_encode (HEADER* header, uint8_t* buf)
+{
+	memcpy(buf, magic, sizeof(magic));
+	buf[3] = header->version;
+	buf[4] = header->flags;
+	buf[5] = header->bits;
+	buf[6] = header->standby;
+	buf[7] = header->extra;
+	put_le32(buf + 8, header->dict_size);
+	put_le32(buf + 12, header->block_size);
+}
+
+int header_decode (uint8_t* buf, HEADER* header)
+{
+	// check the magic
+	if (memcmp(buf, magic, sizeof(magic)) != 0)
+		return 1;
+	
+	header->version = buf[3];
+	header->flags = buf[4];
+	header->bits = buf[5];
+	header->standby = buf[6];
+	header->extra = buf[7];
+	header->dict_size = get_le32(buf + 8);
+	header->block_size = get_le32(buf + 12);
+	
+	// check that we are able to handle the stream
+	if (header->version != HEADER_VERSION || (header->flags & ~HEADER_FLAGS) != 0 || (header->extra & ~HEADER_EXTRAS) != 0)
+		return -1;
+	
+	if (header->bits < MIN_BITS || header->bits > MAX_BITS || header->dict_size < MIN_DICT_SIZE || header->dict_size > MAX_DICT_SIZE)
+		return -1;
+	
+	if ((header->flags & HEADER_FLAG_STANDBY) != 0 && (header->standby == 0 || header->standby >= 100))
+		return -1;
+	
+	// a stream is either a block container or an archive
+	if ((header->flags & HEADER_FLAG_BLOCKS) != 0 && (header->flags & HEADER_FLAG_ARCHIVE) != 0)
+		return -1;
+	
+	// only a single stream has a seek index
+	if ((header->extra & HEADER_EXTRA_INDEX) != 0 && (header->flags & (HEADER_FLAG_BLOCKS | HEADER_FLAG_ARCHIVE)) != 0)
+		return -1;
+	
+	return 0;
+}
+
+size_t header_size (HEADER* header)
+{
+	return ((header->flags & HEADER_FLAG_PRESET) != 0)?(HEADER_SIZE + HEADER_PRESET_SIZE):(HEADER_SIZE);
+}
+
+int header_read_preset (int fd, HEADER* header)
+{
+	uint8_t buf[HEADER_PRESET_SIZE];
+	
+	header->preset_id = 0;
+	if ((header->flags & HEADER_FLAG_PRESET) == 0)
+		return 0;
+	
+	if (read_full(fd, buf, HEADER_PRESET_SIZE) != HEADER_PRESET_SIZE)
+		return -1;
+	header->preset_id = get_le32(buf);
+	
+	return 0;
+}
+
+int header_write (int fd, HEADER* header)
+{
+	uint8_t buf[HEADER_SIZE + HEADER_PRESET_SIZE];
+	
+	header_encode(header, buf);
+	put_le32(buf + HEADER_SIZE, header->preset_id);
+	
+	return write_full(fd, buf, header_size(header));
+}
+
+int header_read (int fd, HEADER* header)
+{
+	uint8_t buf[HEADER_SIZE];
+	ssize_t result;
+	int ret;
+	
+	result = read_full(fd, buf, HEADER_SIZE);
+	if (result < 0)
+		return -1;
+	
+	// a file shorter than a header is a headerless stream
+	if (result < HEADER_SIZE)
+		return 1;
+	
+	ret = header_decode(buf, header);
+	if (ret != 0)
+		return ret;
+	
+	return header_read_preset(fd, header);
+}
+
+ssize_t read_full (int fd, void* buf, size_t len)
+{
+	size_t done;
+	ssize_t result;
+	
+	done = 0;
+	while (done < len) {
+		result = read(fd, (uint8_t*)buf + done, len - done);
+		if (result < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		
+		// end of file
+		if (result == 0)
+			break;
+		
+		done += result;
+	}
+	
+	return done;
+}
+
+int write_full (int fd, void* buf, size_t len)
+{
+	size_t done;
+	ssize_t result;
+	
+	done = 0;
+	while (done < len) {
+		result = write(fd, (uint8_t*)buf + done, len - done);
+		if (result < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		done += result;
+	}
+	
+	return 0;
+}
+
+int open_input (char* path)
+{
+	if (strcmp(path, "-") == 0)
+		return dup(STDIN_FILENO);
+	
+	return open(path, O_RDONLY);
+}
+
+int open_output (char* path)
+{
+	if (path == NULL)
+		return open("/dev/null", O_WRONLY);
+	
+	if (strcmp(path, "-") == 0)
+		return dup(STDOUT_FILENO);
+	
+	return open(path, O_WRONLY | O_CREAT | O_TRUNC, S_IRWXU);
+}
+
+void put_le32 (uint8_t* buf, uint32_t value)
+{
+	buf[0] = value & 0xFF;
+	buf[1] = (value >> 8) & 0xFF;
+	buf[2] = (value >> 16) & 0xFF;
+	buf[3] = (value >> 24) & 0xFF;
+}
+
+uint32_t get_le32 (uint8_t* buf)
+{
+	return (uint32_t)buf[0] | ((uint32_t)buf[1] << 8) | ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24);
+}
+
+void put_le64 (uint8_t* buf, uint64_t value)
+{
+	put_le32(buf, (uint32_t)value);
+	put_le32(buf + 4, (uint32_t)(value >> 32));
+}
+
+uint64_t get_le64 (uint8_t* buf)
+{
+	return (uint64_t)get_le32(buf) | ((uint64_t)get_le32(buf + 4) << 32);
+}
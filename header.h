@@ -0,0 +1,211 @@
+/*
+ * header.h
+ * Francesco Piras - Dario Varano
+ * June 2015
+ */
+
+#ifndef _HEADER_H
+#define _HEADER_H
+
+#include "definitions.h"
+
+#include <sys/types.h>
+
+/**
+ * NOTE ON THE STREAM HEADER
+ * 
+ * The original format has no header: the decompressor has to be told the number of bits and the dictionary size.
+ * The newer formats start with a fixed size header, whose magic can never be the beginning of a headerless stream:
+ * 		the second byte of a headerless stream has its least significant bit set only if the first code is EOS,
+ * 		and in that case the first byte is 0.
+ * 
+ * 		byte	0		1		2		3			4		5		6		7		8 - 11		12 - 15
+ * 			+-------+-------+-------+-----------+-------+-------+-------+-------+-----------+------------+
+ * 			|  'L'	|  '7'	|  '8'	|  version	| flags	| bits	|standby| extra	| dict_size	| block_size |
+ * 			+-------+-------+-------+-----------+-------+-------+-------+-------+-----------+------------+
+ * 
+ * 		Multi-byte fields are little endian. Without HEADER_FLAG_BLOCKS the header is followed by a single stream,
+ * 		as in the headerless format. With HEADER_FLAG_ARCHIVE it is followed by the members of an archive (see archive.h).
+ * 		The standby byte is the fill percentage of HEADER_FLAG_STANDBY, and 0 without it. With HEADER_FLAG_PRESET
+ * 		the header is followed by the 32 bits id of the preset dictionary of the streams (see preset.h).
+ * 		The extra byte holds the flags which don't fit in the first one (HEADER_EXTRA_*), and it is 0 without them:
+ * 		the decoders older than it ignore it.
+ */
+
+#define HEADER_SIZE			16				// size (in bytes) of the header
+#define HEADER_VERSION		1				// current version of the header
+#define HEADER_PRESET_SIZE	4				// size (in bytes) of the id of the preset dictionary following the header
+
+#define HEADER_FLAG_BLOCKS		0x01		// the stream is a sequence of independent blocks
+#define HEADER_FLAG_VARIABLE	0x02		// the width of the codes grows from 9 bits up to bits, following the dictionary
+#define HEADER_FLAG_ADAPTIVE	0x04		// a full dictionary is kept until a CLEAR code, instead of being reset
+#define HEADER_FLAG_LRU			0x08		// a full dictionary reuses the codes of its least recently used leaves
+#define HEADER_FLAG_STANDBY		0x10		// a standby dictionary is populated from the standby fill percentage, and replaces the full one
+#define HEADER_FLAG_ARCHIVE		0x20		// the stream is an archive of many files, each one compressed on its own
+#define HEADER_FLAG_CHECKSUM	0x40		// every stream is followed by the CRC32C of its uncompressed data (see checksum.h)
+#define HEADER_FLAG_PRESET		0x80		// the dictionary starts from the entries of a preset dictionary, whose id follows the header
+#define HEADER_EXTRA_INDEX		0x01		// the single stream is followed by a seek index (see seek.h)
+#define HEADER_EXTRAS			(HEADER_EXTRA_INDEX)		// the extra flags known by this version
+#define HEADER_FLAGS			(HEADER_FLAG_BLOCKS | HEADER_FLAG_VARIABLE | HEADER_FLAG_ADAPTIVE | HEADER_FLAG_LRU | HEADER_FLAG_STANDBY | HEADER_FLAG_ARCHIVE | HEADER_FLAG_CHECKSUM | HEADER_FLAG_PRESET)		// the flags known by this version
+
+/**
+ * @brief The content of a stream header
+ * 
+ */
+typedef struct header_struct {
+	uint8_t version;			// version of the format
+	uint8_t flags;				// features of the stream (HEADER_FLAG_*)
+	uint8_t bits;				// number of bits used for encoding the symbols
+	uint8_t standby;			// fill percentage of the active dictionary from which the standby one is populated (HEADER_FLAG_STANDBY)
+	uint8_t extra;				// more features of the stream (HEADER_EXTRA_*)
+	uint32_t dict_size;			// number of dictionary entries
+	uint32_t block_size;		// maximum size (in bytes) of an uncompressed block
+	uint32_t preset_id;			// id of the preset dictionary (HEADER_FLAG_PRESET)
+} HEADER;
+
+/**
+ * @brief It fills a header with the parameters of a compression
+ * 
+ * @param header the pointer to the header to be filled
+ * @param options the compression parameters
+ * @param flags the layout of the stream (HEADER_FLAG_BLOCKS, HEADER_FLAG_ARCHIVE or 0): the flags of the parameters are added
+ * @param block_size the maximum size (in bytes) of an uncompressed block, or 0
+ * @return void
+ */
+void header_init (HEADER* header, OPTIONS* options, uint8_t flags, uint32_t block_size);
+
+/**
+ * @brief It copies the parameters of the stream described by a header, leaving the other ones untouched
+ * 		(the preset dictionary is kept only if the stream has one, and the caller checks its id)
+ * 
+ * @param header the pointer to the header
+ * @param options the parameters to be updated
+ * @return void
+ */
+void header_options (HEADER* header, OPTIONS* options);
+
+/**
+ * @brief It serializes a header
+ * 
+ * @param header the pointer to the header
+ * @param buf the destination area, at least HEADER_SIZE bytes long
+ * @return void
+ */
+void header_encode (HEADER* header, uint8_t* buf);
+
+/**
+ * @brief It parses a header
+ * 
+ * @param buf the source area, at least HEADER_SIZE bytes long
+ * @param header the pointer to the header to be filled
+ * @return int a flag indicating if the header has been parsed (0), if the area doesn't start with a header (1) or if the header is not valid (-1)
+ */
+int header_decode (uint8_t* buf, HEADER* header);
+
+/**
+ * @brief It returns the size of a header, with the id of the preset dictionary if the stream has one
+ * 
+ * @param header the pointer to the header
+ * @return size_t the size (in bytes)
+ */
+size_t header_size (HEADER* header);
+
+/**
+ * @brief It reads the id of the preset dictionary which follows a decoded header, if the stream has one
+ * 
+ * @param fd the file descriptor, placed right after the first HEADER_SIZE bytes
+ * @param header the pointer to the header to be completed
+ * @return int a flag indicating if the header is complete (0) or if an error occurs (-1)
+ */
+int header_read_preset (int fd, HEADER* header);
+
+/**
+ * @brief It writes a header on a file
+ * 
+ * @param fd the file descriptor
+ * @param header the pointer to the header
+ * @return int a flag indicating if the write operation has been completed successfully (0) or if an error occurs (-1)
+ */
+int header_write (int fd, HEADER* header);
+
+/**
+ * @brief It reads a header from a file
+ * 
+ * @param fd the file descriptor
+ * @param header the pointer to the header to be filled
+ * @return int a flag indicating if the header has been read (0), if the file doesn't start with a header (1) or if an error occurs (-1)
+ */
+int header_read (int fd, HEADER* header);
+
+/**
+ * @brief It reads exactly len bytes from a file, unless the end of the file is reached before
+ * 
+ * @param fd the file descriptor
+ * @param buf the destination area
+ * @param len the number of bytes to be read
+ * @return ssize_t the number of bytes read or -1 if an error occurs
+ */
+ssize_t read_full (int fd, void* buf, size_t len);
+
+/**
+ * @brief It writes exactly len bytes on a file
+ * 
+ * @param fd the file descriptor
+ * @param buf the source area
+ * @param len the number of bytes to be written
+ * @return int a flag indicating if the write operation has been completed successfully (0) or if an error occurs (-1)
+ */
+int write_full (int fd, void* buf, size_t len);
+
+/**
+ * @brief It opens a file in reading mode: the name "-" selects the standard input
+ * 
+ * @param path the file name
+ * @return int the file descriptor (a duplicate of the standard one, so that it can be closed as any other) or -1 if an error occurs
+ */
+int open_input (char* path);
+
+/**
+ * @brief It creates or truncates a file in writing mode: the name "-" selects the standard output,
+ * 		and NULL a sink discarding the data (the test mode)
+ * 
+ * @param path the file name, or NULL
+ * @return int the file descriptor (a duplicate of the standard one, so that it can be closed as any other) or -1 if an error occurs
+ */
+int open_output (char* path);
+
+/**
+ * @brief It stores a 32 bits value in little endian format
+ * 
+ * @param buf the destination area
+ * @param value the value to be stored
+ * @return void
+ */
+void put_le32 (uint8_t* buf, uint32_t value);
+
+/**
+ * @brief It loads a 32 bits value stored in little endian format
+ * 
+ * @param buf the source area
+ * @return uint32_t the loaded value
+ */
+uint32_t get_le32 (uint8_t* buf);
+
+/**
+ * @brief It stores a 64 bits value in little endian format
+ * 
+ * @param buf the destination area
+ * @param value the value to be stored
+ * @return void
+ */
+void put_le64 (uint8_t* buf, uint64_t value);
+
+/**
+ * @brief It loads a 64 bits value stored in little endian format
+ * 
+ * @param buf the source area
+ * @return uint64_t the value
+ */
+uint64_t get_le64 (uint8_t* buf);
+
+#endif
@@ -0,0 +1,148 @@
+/*
+ * input.c
+ * Francesco Piras - Dario Varano
+ * June 2015
+ */
+
+#include "input.h"
+#include "header.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/**
+ * @brief It maps a regular file in memory, hinting the kernel that it will be read sequentially
+ *
+ * @param input the pointer to the data structure of the input file
+ * @param size the size (in bytes) of the file
+ * @return int a flag indicating if the file has been mapped (0) or if it has to be read by blocks (-1)
+ */
+int input_map (INPUT* input, size_t size);
+
+INPUT* input_open (char* path, size_t block_size)
+{
+	INPUT* input;
+	struct stat info;
+
+	input = calloc(1, sizeof(INPUT));
+	if (input == NULL)
+		return NULL;
+
+	input->fd = open_input(path);
+	if (input->fd < 0) {
+		free(input);
+		return NULL;
+	}
+
+	// non empty regular files are mapped, everything else is read by blocks
+	if (fstat(input->fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0 &&
+		(uint64_t)info.st_size <= (uint64_t)SIZE_MAX && input_map(input, (size_t)info.st_size) == 0)
+		return input;
+
+	input->block_size = (block_size > 0)?(block_size):(INPUT_BLOCK);
+	input->block = malloc(input->block_size);
+	if (input->block == NULL) {
+		close(input->fd);
+		free(input);
+		return NULL;
+	}
+
+	return input;
+}
+
+INPUT* input_open_pipelined (char* path, size_t block_size)
+{
+	INPUT* input;
+
+	input = calloc(1, sizeof(INPUT));
+	if (input == NULL)
+		return NULL;
+
+	input->fd = open_input(path);
+	if (input->fd < 0) {
+		free(input);
+		return NULL;
+	}
+
+	input->reader = pipeline_reader(input->fd, block_size);
+	if (input->reader == NULL) {
+		close(input->fd);
+		free(input);
+		return NULL;
+	}
+
+	return input;
+}
+
+int input_map (INPUT* input, size_t size)
+{
+	void* map;
+
+	map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, input->fd, 0);
+	if (map == MAP_FAILED)
+		return -1;
+
+	// the hints are only advisory, so their failure is ignored
+	madvise(map, size, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+	madvise(map, size, MADV_HUGEPAGE);
+#endif
+
+	input->map = map;
+	input->map_size = size;
+
+	return 0;
+}
+
+int input_next (INPUT* input, const uint8_t** data, size_t* len)
+{
+	ssize_t result;
+
+	*data = NULL;
+	*len = 0;
+
+	// the blocks of a reader thread are taken from its ring
+	if (input->reader != NULL)
+		return pipeline_next(input->reader, data, len);
+
+	// the mapped file is returned as a single area
+	if (input->map != NULL) {
+		if (input->delivered)
+			return 1;
+		input->delivered = true;
+		*data = input->map;
+		*len = input->map_size;
+		return 0;
+	}
+
+	do {
+		result = read(input->fd, input->block, input->block_size);
+	} while (result < 0 && errno == EINTR);
+
+	if (result < 0)
+		return -1;
+	if (result == 0)
+		return 1;
+
+	*data = input->block;
+	*len = (size_t)result;
+
+	return 0;
+}
+
+void input_close (INPUT* input)
+{
+	if (input == NULL)
+		return;
+
+	if (input->reader != NULL)
+		pipeline_close(input->reader);
+	if (input->map != NULL)
+		munmap(input->map, input->map_size);
+	free(input->block);
+	close(input->fd);
+	free(input);
+}
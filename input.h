@@ -0,0 +1,67 @@
+/*
+ * input.h
+ * Francesco Piras - Dario Varano
+ * June 2015
+ */
+
+#ifndef _INPUT_H
+#define _INPUT_H
+
+#include "definitions.h"
+#include "pipeline.h"
+
+#define INPUT_BLOCK		(1024 * 1024)		// default size (in bytes) of the blocks read from pipes and other unmappable files
+
+/**
+ * @brief A file read sequentially by contiguous areas: regular files are mapped in memory,
+ * the other ones are read by large blocks
+ *
+ */
+typedef struct input_struct {
+	int fd;						// the file descriptor
+	uint8_t* map;				// the mapped file, or NULL if the file is read by blocks
+	size_t map_size;			// size (in bytes) of the mapped file
+	bool delivered;				// the mapped file has already been returned
+	uint8_t* block;				// the buffer of the blocks read from the file
+	size_t block_size;			// size (in bytes) of the buffer
+	PIPELINE* reader;			// the reader thread filling the blocks, or NULL if they are read by the caller
+} INPUT;
+
+/**
+ * @brief It opens a file for sequential reading
+ *
+ * @param path the file name, or "-" for the standard input
+ * @param block_size the size (in bytes) of the blocks read from a file which can't be mapped (0 selects INPUT_BLOCK)
+ * @return INPUT* the pointer to the data structure of the input file or NULL if an error occurs
+ */
+INPUT* input_open (char* path, size_t block_size);
+
+/**
+ * @brief It opens a file which is read by blocks in a reader thread, ahead of the caller (even a regular file,
+ * 		whose page faults would stall the caller on a slow file system)
+ *
+ * @param path the file name, or "-" for the standard input
+ * @param block_size the size (in bytes) of the blocks (0 selects PIPELINE_BLOCK)
+ * @return INPUT* the pointer to the data structure of the input file or NULL if an error occurs
+ */
+INPUT* input_open_pipelined (char* path, size_t block_size);
+
+/**
+ * @brief It returns the next area of the file: the area is valid until the next call or until the file is closed
+ *
+ * @param input the pointer to the data structure of the input file
+ * @param data the pointer to be set to the first byte of the area
+ * @param len the pointer to be set to the size (in bytes) of the area
+ * @return int a flag indicating if an area has been returned (0), if the end of the file has been reached (1) or if an error occurs (-1)
+ */
+int input_next (INPUT* input, const uint8_t** data, size_t* len);
+
+/**
+ * @brief It closes the file and deallocates the data structure
+ *
+ * @param input the pointer to the data structure of the input file
+ * @return void
+ */
+void input_close (INPUT* input);
+
+#endif
@@ -0,0 +1,1394 @@
+/*
+ * lz78.c
+ * Francesco Piras - Dario Varano
+ * June 2015
+ */
+
+#include "lz78.h"
+#include "dictionary.h"
+#include "preset.h"
+
+#include <string.h>
+#include <time.h>
+
+#define LZ78_WINDOW_SIZE	(1024 * 1024)		// minimum size (in bytes) of the window of the decoded data
+#define LZ78_MIN_WIDTH		MIN_BITS				// width (in bits) of the codes right after a reset, when they are variable
+#define LZ78_CHECK_GAP		(16 * 1024)			// number of input bytes between two checks of the ratio of a frozen dictionary
+#define LZ78_RESTART_GAP	(4 * 1024)			// minimum number of input bytes between two restart points of the seek index
+
+typedef struct lz78_stream {
+	OPTIONS options;			// the parameters of the stream
+	bool compressing;			// flag indicating a compression stream (decompression if false)
+	BIT_FILE* bf;				// the bit file of the codes
+	bool own_bf;				// flag indicating a bit file opened (and closed) by the stream
+	dictionary* dictionary;		// the dictionary
+	CODE next_code;				// next code to be added to the dictionary
+	CODE first_code;			// next code right after a reset: the one following the entries of the preset dictionary
+	CODE max_code;				// maximum rapresentable code
+	int width;					// width (in bits) of the next code to be written or read
+	bool frozen;				// flag indicating a full dictionary kept until a CLEAR code (adaptive reset policy)
+	bool full;					// flag indicating a full dictionary whose least recently used leaves are reused (LRU replacement policy)
+	LZ78_STATS stats;			// statistics
+	
+	// warm standby
+	dictionary* standby;		// the standby dictionary, looked up by the shadow parse which populates it (a hash table on both sides)
+	dictionary* standby_codes;	// decompressor: the standby dictionary indexed by code, which replaces the active one
+	uint64_t* standby_offsets;	// decompressor: the offsets of the codes of the standby dictionary
+	uint32_t* standby_lengths;	// decompressor: the lengths of the codes of the standby dictionary
+	CODE standby_next;			// next code to be added to the standby dictionary
+	CODE standby_from;			// next code of the active dictionary from which the standby one is populated
+	bool standby_on;			// flag indicating that the shadow parse is populating the standby dictionary
+	uint64_t shadow_pos;		// position of the next byte of the shadow parse
+	CODE shadow_code;			// current node of the shadow parse
+	uint32_t shadow_length;		// length of the string of the current node of the shadow parse (0 before its first byte)
+	bool swapping;				// decompressor: the next insertion fills the active dictionary, so the next code is a standby one
+	
+	// compressor
+	bool started;				// flag indicating that the first symbol has been read
+	CODE current_code;			// current node
+	int tail;					// number of final codes written (the last code, then EOS)
+	uint64_t taken;				// number of bytes taken from a stream bit file
+	bool clear_pending;			// flag indicating a CLEAR code which didn't fit in the buffer of a stream bit file
+	uint64_t check_in;			// position of the input where the current window of the ratio monitor starts
+	uint64_t check_bits;		// number of bits written in the current window of the ratio monitor
+	uint64_t best_ratio;		// best ratio of a window since the dictionary has been frozen (per mille)
+	LZ78_RESTART* restarts;		// restart points of the seek index (options.index), or NULL
+	size_t restart_count;		// number of restart points
+	size_t restart_size;		// capacity of the array of the restart points
+	
+	// decompressor
+	CODE old_code;				// previous code read
+	uint64_t old_offset;		// position of the string of the previous code
+	uint32_t old_length;		// length of the string of the previous code
+	uint64_t* offsets;			// for every code, position of the last occurrence of its string in the decoded data
+	uint32_t* lengths;			// for every code, length of its string
+	CODE entries;				// number of codes of offsets and lengths
+	uint8_t* window;			// the last decoded data, from which the strings are copied
+	size_t window_size;			// size (in bytes) of the window
+	uint64_t window_base;		// position of the first byte of the window
+	uint64_t window_end;		// position of the byte following the last decoded one
+	size_t pending;				// number of bytes at the end of the window still to be produced
+	uint64_t max_codes;			// number of codes after which the stream ends (0 for no limit)
+	bool ended;					// flag indicating that EOS has been read
+} LZ78_STREAM;
+
+/**
+ * @brief It allocates a stream and its dictionary
+ * 
+ * @param options the parameters of the stream
+ * @param compressing flag indicating a compression stream
+ * @return LZ78_STREAM* pointer to the stream allocated in the dynamic memory, or NULL if an error occurs
+ */
+LZ78_STREAM* lz78_alloc (OPTIONS* options, bool compressing);
+
+/**
+ * @brief It encodes an input area, as lz78_encode does without timing it
+ *
+ * @param stream the pointer to the compression stream
+ * @param in the input area
+ * @param len the number of input bytes
+ * @param used the number of input bytes consumed (set by the function)
+ * @return int LZ78_OK or LZ78_ERROR
+ */
+int encode_data (LZ78_STREAM* stream, const uint8_t* in, size_t len, size_t* used);
+
+/**
+ * @brief It decodes into an output area, as lz78_decode does without timing it
+ *
+ * @param stream the pointer to the decompression stream
+ * @param out the output area
+ * @param len the size (in bytes) of the output area
+ * @param produced the number of bytes produced (set by the function)
+ * @return int LZ78_OK, LZ78_END or LZ78_ERROR
+ */
+int decode_data (LZ78_STREAM* stream, uint8_t* out, size_t len, size_t* produced);
+
+/**
+ * @brief It returns the time elapsed from an arbitrary point of the past, for the timings of the statistics
+ *
+ * @return uint64_t the time (in nanoseconds)
+ */
+uint64_t stats_clock (void);
+
+/**
+ * @brief It monitors the compression ratio of a frozen dictionary, after a code has been written: the ratio of every window
+ * 		of LZ78_CHECK_GAP input bytes is compared to the best one, and the dictionary is cleared if it is worse than the threshold
+ *
+ * @param stream the pointer to the compression stream
+ * @param position the position of the input byte following the string of the code
+ * @return int a flag indicating if the code has been accounted (0), if the CLEAR code didn't fit in the buffer of a stream
+ * 		bit file (1) or if an error occurs (-1)
+ */
+int monitor_ratio (LZ78_STREAM* stream, uint64_t position);
+
+/**
+ * @brief It writes the CLEAR code of a frozen dictionary, which is the next code, and then resets the dictionary
+ *
+ * @param stream the pointer to the compression stream
+ * @param position the position of the input byte of the current node, which is a symbol
+ * @return int a flag indicating if the dictionary has been cleared (0), if the CLEAR code didn't fit in the buffer of a stream
+ * 		bit file (1) or if an error occurs (-1)
+ */
+int encode_clear (LZ78_STREAM* stream, uint64_t position);
+
+/**
+ * @brief It records a restart point of the seek index, when the stream has options.index: the current node is a symbol,
+ * 		and the next code is written for an empty dictionary
+ *
+ * @param stream the pointer to the compression stream
+ * @param position the position of the input byte of the current node
+ * @return int a flag indicating if the restart point has been recorded (0) or if an error occurs (-1)
+ */
+int restart_record (LZ78_STREAM* stream, uint64_t position);
+
+/**
+ * @brief It feeds the shadow parse, which populates the standby dictionary as a compressor would do, without writing codes.
+ * 		The standby dictionary stops growing one code before the limit which would reset it
+ *
+ * @param stream the pointer to the stream
+ * @param data the bytes following the last ones fed
+ * @param len the number of bytes
+ * @return void
+ */
+void standby_feed (LZ78_STREAM* stream, const uint8_t* data, size_t len);
+
+/**
+ * @brief It replaces the full active dictionary with the standby one, and starts a new empty standby dictionary
+ *
+ * @param stream the pointer to the stream
+ * @return void
+ */
+void standby_swap (LZ78_STREAM* stream);
+
+/**
+ * @brief It tells if the next insertion fills the active dictionary: it is reset (or replaced) right after it
+ *
+ * @param stream the pointer to the stream
+ * @return bool true if the dictionary is reset after the next insertion
+ */
+bool dictionary_limit (LZ78_STREAM* stream);
+
+/**
+ * @brief It writes the string of a code: as a copy of its last occurrence in the window or, if it isn't there anymore,
+ * 		by moving up in the tree from the code node to the root node, storing the encountered symbols backwards
+ *
+ * @param stream the pointer to the decompression stream
+ * @param code the code of the string, which has to be in the dictionary
+ * @param dest the destination area, in the window after the last decoded byte
+ * @return uint32_t the length of the string
+ */
+uint32_t decode_string (LZ78_STREAM* stream, CODE code, uint8_t* dest);
+
+/**
+ * @brief It makes room at the end of the window, discarding the oldest half of the decoded data if needed
+ * 		(the bytes still to be produced are less than a quarter of the window, so they are kept)
+ *
+ * @param stream the pointer to the decompression stream
+ * @param len the number of bytes to be decoded
+ * @return uint8_t* the pointer to the byte following the last decoded one
+ */
+uint8_t* window_reserve (LZ78_STREAM* stream, uint32_t len);
+
+/**
+ * @brief It returns the width of the codes when they are variable: the least number of bits representing the highest code
+ * 		the decompressor can accept, which is the next code of its dictionary
+ *
+ * @param width the current width (or LZ78_MIN_WIDTH, to compute it from scratch)
+ * @param next the next code of the dictionary of the decompressor, which grows by one or goes back to first
+ * @param first the next code right after a reset
+ * @return int the width (in bits)
+ */
+int code_width (int width, CODE next, CODE first);
+
+/**
+ * @brief It empties the active dictionary after a reset, and loads the entries of the preset dictionary, if any:
+ * 		the decompressor's strings of the preset entries precede the window, so they are first decoded from the tree
+ *
+ * @param stream the pointer to the stream
+ * @return void
+ */
+void dictionary_restart (LZ78_STREAM* stream);
+
+LZ78_STREAM* lz78_compress_init (OPTIONS* options)
+{
+	LZ78_STREAM* stream;
+	
+	stream = lz78_alloc(options, true);
+	if (stream == NULL)
+		return NULL;
+	
+	// the codes are taken from the bit file by lz78_compress_chunk
+	stream->bf = bit_open_stream("w");
+	if (stream->bf == NULL) {
+		lz78_free(stream);
+		return NULL;
+	}
+	stream->own_bf = true;
+	
+	return stream;
+}
+
+int lz78_compress_chunk (LZ78_STREAM* stream, const uint8_t* in, size_t in_len, size_t* in_used, uint8_t* out, size_t out_len, size_t* out_used)
+{
+	size_t used, taken;
+	
+	*in_used = 0;
+	*out_used = 0;
+	
+	if (stream == NULL || stream->compressing == false || stream->own_bf == false)
+		return LZ78_ERROR;
+	
+	while (1) {
+		// moving the complete bytes to the output area
+		taken = bit_take(stream->bf, out + *out_used, out_len - *out_used, false);
+		*out_used += taken;
+		stream->taken += taken;
+		
+		if (*in_used == in_len)
+			break;
+		
+		// compressing until the buffer of the bit file is full
+		if (lz78_encode(stream, in + *in_used, in_len - *in_used, &used) < 0)
+			return LZ78_ERROR;
+		*in_used += used;
+		
+		// neither input has been consumed nor output produced: the output area is full
+		if (used == 0 && taken == 0)
+			break;
+	}
+	
+	return LZ78_OK;
+}
+
+int lz78_compress_finish (LZ78_STREAM* stream, uint8_t* out, size_t out_len, size_t* out_used)
+{
+	int ret;
+	size_t taken;
+	
+	*out_used = 0;
+	
+	if (stream == NULL || stream->compressing == false || stream->own_bf == false)
+		return LZ78_ERROR;
+	
+	while ((ret = lz78_encode_end(stream)) == LZ78_OK) {
+		// the buffer of the bit file is full
+		taken = bit_take(stream->bf, out + *out_used, out_len - *out_used, false);
+		*out_used += taken;
+		stream->taken += taken;
+		if (taken == 0)
+			return LZ78_OK;
+	}
+	if (ret < 0)
+		return LZ78_ERROR;
+	
+	// all the codes have been written: taking also the last incomplete byte
+	taken = bit_take(stream->bf, out + *out_used, out_len - *out_used, true);
+	*out_used += taken;
+	stream->taken += taken;
+	
+	return (bit_length(stream->bf) == stream->taken)?(LZ78_END):(LZ78_OK);
+}
+
+LZ78_STREAM* lz78_decompress_init (OPTIONS* options)
+{
+	LZ78_STREAM* stream;
+	
+	stream = lz78_alloc(options, false);
+	if (stream == NULL)
+		return NULL;
+	
+	// the codes are fed to the bit file by lz78_decompress_chunk
+	stream->bf = bit_open_stream("r");
+	if (stream->bf == NULL) {
+		lz78_free(stream);
+		return NULL;
+	}
+	stream->own_bf = true;
+	
+	return stream;
+}
+
+int lz78_decompress_chunk (LZ78_STREAM* stream, const uint8_t* in, size_t in_len, size_t* in_used, uint8_t* out, size_t out_len, size_t* out_used)
+{
+	int ret;
+	size_t produced;
+	
+	*in_used = 0;
+	*out_used = 0;
+	
+	if (stream == NULL || stream->compressing == true || stream->own_bf == false)
+		return LZ78_ERROR;
+	
+	while (1) {
+		// feeding the bit file with as many bytes as possible
+		*in_used += bit_feed(stream->bf, in + *in_used, in_len - *in_used);
+		
+		ret = lz78_decode(stream, out + *out_used, out_len - *out_used, &produced);
+		*out_used += produced;
+		if (ret != LZ78_OK)
+			return ret;
+		
+		// the output area is full, or all the input has been fed and more is needed
+		if (*out_used == out_len || *in_used == in_len)
+			break;
+	}
+	
+	return LZ78_OK;
+}
+
+void lz78_stats (LZ78_STREAM* stream, LZ78_STATS* stats)
+{
+	if (stream == NULL || stats == NULL)
+		return;
+	
+	*stats = stream->stats;
+	
+	// the bit file counts the bytes of the codes
+	if (stream->compressing == true)
+		stats->bytes_out = bit_length(stream->bf);
+	else
+		stats->bytes_in = bit_length(stream->bf);
+	
+	stats->lookups = dictionary_lookups(stream->dictionary);
+	stats->collisions = dictionary_collisions(stream->dictionary);
+	stats->max_probe = dictionary_max_probe(stream->dictionary);
+	stats->direct_lookups = dictionary_direct_lookups(stream->dictionary);
+	memset(stats->probes, 0, sizeof(stats->probes));
+	dictionary_probes(stream->dictionary, stats->probes);
+	stats->resets = stats->resets_full + stats->resets_clear + stats->resets_swap;
+	
+	// the lookups of the shadow parse
+	if (stream->standby != NULL) {
+		dictionary_probes(stream->standby, stats->probes);
+		stats->lookups += dictionary_lookups(stream->standby);
+		stats->collisions += dictionary_collisions(stream->standby);
+		stats->direct_lookups += dictionary_direct_lookups(stream->standby);
+		if (dictionary_max_probe(stream->standby) > stats->max_probe)
+			stats->max_probe = dictionary_max_probe(stream->standby);
+	}
+}
+
+void lz78_stats_add (LZ78_STATS* total, LZ78_STATS* stats)
+{
+	int i;
+	
+	if (total == NULL || stats == NULL)
+		return;
+	
+	total->bytes_in += stats->bytes_in;
+	total->bytes_out += stats->bytes_out;
+	total->codes += stats->codes;
+	total->resets += stats->resets;
+	total->resets_full += stats->resets_full;
+	total->resets_clear += stats->resets_clear;
+	total->resets_swap += stats->resets_swap;
+	total->evictions += stats->evictions;
+	total->lookups += stats->lookups;
+	total->collisions += stats->collisions;
+	total->direct_lookups += stats->direct_lookups;
+	if (stats->max_probe > total->max_probe)
+		total->max_probe = stats->max_probe;
+	for (i = 0; i < PROBE_BUCKETS; i++)
+		total->probes[i] += stats->probes[i];
+	total->setup_time += stats->setup_time;
+	total->codec_time += stats->codec_time;
+	if (stats->memory > total->memory)
+		total->memory = stats->memory;
+}
+
+uint64_t stats_clock (void)
+{
+	struct timespec now;
+	
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	
+	return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+int lz78_reset (LZ78_STREAM* stream, BIT_FILE* bf)
+{
+	uint64_t memory;
+	
+	if (stream == NULL || (bf == NULL) != (stream->own_bf == true))
+		return LZ78_ERROR;
+	
+	// the in-memory interface gets a new stream bit file
+	if (stream->own_bf == true) {
+		bf = bit_open_stream((stream->compressing == true)?("w"):("r"));
+		if (bf == NULL)
+			return LZ78_ERROR;
+		bit_close(stream->bf);
+	}
+	stream->bf = bf;
+	
+	// the dictionaries are emptied by starting a new epoch, the tables indexed by code are written before being read
+	dictionary_restart(stream);
+	if (stream->standby != NULL)
+		dictionary_compressor_init(stream->standby);
+	if (stream->standby_codes != NULL)
+		dictionary_decompressor_init(stream->standby_codes);
+	
+	stream->width = (stream->options.variable == true)?(code_width(LZ78_MIN_WIDTH, stream->next_code, stream->first_code)):(stream->options.bits);
+	stream->frozen = false;
+	stream->full = false;
+	
+	memory = stream->stats.memory;
+	memset(&stream->stats, 0, sizeof(LZ78_STATS));
+	stream->stats.memory = memory;
+	dictionary_stats_clear(stream->dictionary);
+	dictionary_stats_clear(stream->standby);
+	
+	// warm standby
+	stream->standby_next = FIRST_CODE;
+	stream->standby_on = false;
+	stream->shadow_pos = 0;
+	stream->shadow_code = 0;
+	stream->shadow_length = 0;
+	stream->swapping = false;
+	
+	// compressor
+	stream->started = false;
+	stream->current_code = 0;
+	stream->tail = 0;
+	stream->taken = 0;
+	stream->clear_pending = false;
+	stream->check_in = 0;
+	stream->check_bits = 0;
+	stream->best_ratio = 0;
+	stream->restart_count = 0;
+	if (stream->compressing == true && restart_record(stream, 0) < 0)
+		return LZ78_ERROR;
+	
+	// decompressor
+	stream->old_code = 0;
+	stream->old_offset = 0;
+	stream->old_length = 0;
+	stream->window_base = (stream->options.preset != NULL)?(1):(0);
+	stream->window_end = stream->window_base;
+	stream->pending = 0;
+	stream->max_codes = 0;
+	stream->ended = false;
+	
+	return LZ78_OK;
+}
+
+int lz78_image_save (OPTIONS* options, FILE* fp)
+{
+	LZ78_STREAM* stream;
+	int ret;
+	
+	if (options == NULL || options->preset == NULL || options->lru == true)
+		return -1;
+	
+	stream = lz78_alloc(options, true);
+	if (stream == NULL)
+		return -1;
+	
+	ret = dictionary_image_save(stream->dictionary, fp);
+	lz78_free(stream);
+	
+	return ret;
+}
+
+void lz78_free (LZ78_STREAM* stream)
+{
+	if (stream == NULL)
+		return;
+	
+	if (stream->own_bf == true)
+		bit_close(stream->bf);
+	
+	dictionary_free(stream->dictionary);
+	dictionary_table_free(stream->offsets, (size_t)stream->entries * sizeof(uint64_t));
+	dictionary_table_free(stream->lengths, (size_t)stream->entries * sizeof(uint32_t));
+	dictionary_free(stream->standby);
+	dictionary_free(stream->standby_codes);
+	dictionary_table_free(stream->standby_offsets, (size_t)stream->entries * sizeof(uint64_t));
+	dictionary_table_free(stream->standby_lengths, (size_t)stream->entries * sizeof(uint32_t));
+	free(stream->window);
+	free(stream->restarts);
+	free(stream);
+}
+
+LZ78_STREAM* lz78_open (OPTIONS* options, BIT_FILE* bf, bool compressing)
+{
+	LZ78_STREAM* stream;
+	
+	if (bf == NULL)
+		return NULL;
+	
+	stream = lz78_alloc(options, compressing);
+	if (stream == NULL)
+		return NULL;
+	
+	stream->bf = bf;
+	stream->own_bf = false;
+	
+	return stream;
+}
+
+LZ78_STREAM* lz78_alloc (OPTIONS* options, bool compressing)
+{
+	LZ78_STREAM* stream;
+	int entries, load_factor, layout;
+	STATS(uint64_t start = stats_clock());
+	
+	// checking parameters
+	if (options == NULL || options->bits < MIN_BITS || options->bits > MAX_BITS || options->dict_size < MIN_DICT_SIZE)
+		return NULL;
+	
+	// the recency list of the LRU replacement needs every entry to stay in its slot, which the other layouts don't guarantee;
+	// the Robin Hood table keeps its probes short at a higher load
+	layout = (options->lru == true)?(DICTIONARY_LINEAR):(options->table);
+	load_factor = (layout == DICTIONARY_ROBIN_HOOD)?(DICTIONARY_ROBIN_LOAD_FACTOR):(DICTIONARY_LOAD_FACTOR);
+	if (options->load_factor > 0)
+		load_factor = options->load_factor;
+	if (load_factor < DICTIONARY_MIN_LOAD_FACTOR || load_factor > DICTIONARY_MAX_LOAD_FACTOR ||
+		(options->table != DICTIONARY_LINEAR && options->table != DICTIONARY_BUCKETS && options->table != DICTIONARY_ROBIN_HOOD))
+		return NULL;
+	
+	stream = calloc(1, sizeof(LZ78_STREAM));
+	if (stream == NULL)
+		return NULL;
+	
+	stream->options = *options;
+	stream->compressing = compressing;
+	if (stream->options.reset_threshold == 0)
+		stream->options.reset_threshold = LZ78_RESET_THRESHOLD;
+	if (stream->options.reset_threshold < 0 || stream->options.reset_threshold >= 100)
+		goto error;
+	
+	// the LRU replacement and the warm standby replace the reset policies
+	if ((options->lru == true && options->adaptive == true) || options->standby < 0 || options->standby >= 100 ||
+		(options->standby > 0 && (options->lru == true || options->adaptive == true)))
+		goto error;
+	
+	// the preset dictionary leaves room for the codes learned from the data, and the standby dictionary is built without it
+	if (options->preset != NULL && (options->preset->count > preset_capacity(options) || options->standby > 0))
+		goto error;
+	
+	// computing the values for the maximum rapresentable code: the adaptive policy keeps the last one free for CLEAR,
+	// which is the next code of the frozen dictionary
+	stream->max_code = (1 << options->bits) - 1;
+	if (options->adaptive == true)
+		stream->max_code--;
+	stream->next_code = FIRST_CODE;
+	stream->first_code = FIRST_CODE;
+	
+	// the dictionary is reset as soon as next_code exceeds max_code or half of dict_size,
+	// so the entries used at the same time are at most the first symbols and the codes up to that limit
+	entries = (stream->max_code < options->dict_size / 2)?(stream->max_code):(options->dict_size / 2);
+	if (entries < SYMBOLS)
+		entries = SYMBOLS;
+	entries++;
+	
+	// dictionary allocation: the decompressor's one is indexed by code, the compressor's one is a hash table
+	// filled at most up to the load factor, plus a direct table for the children of the first symbols
+	if (compressing == true)
+		stream->dictionary = dictionary_alloc((int)(((int64_t)entries * 100 + load_factor - 1) / load_factor), true, layout);
+	else
+		stream->dictionary = dictionary_alloc(entries, false, DICTIONARY_LINEAR);
+	if (stream->dictionary == NULL)
+		goto error;
+	
+	// the recency list of the LRU replacement, indexed by code
+	if (options->lru == true && dictionary_lru_alloc(stream->dictionary, entries, compressing) < 0)
+		goto error;
+	
+	if (compressing == true) {
+		// initialization of the compressor's dictionary
+		dictionary_compressor_init(stream->dictionary);
+	}
+	else {
+		// initialization of the decompressor's dictionary
+		dictionary_decompressor_init(stream->dictionary);
+		
+		// the position and the length of the string of every code
+		stream->entries = entries;
+		stream->offsets = dictionary_table_alloc((size_t)entries * sizeof(uint64_t));
+		stream->lengths = dictionary_table_alloc((size_t)entries * sizeof(uint32_t));
+		
+		// a string is at most as long as the number of entries, plus the symbol of the special case:
+		// the window keeps at least two of the longest strings when it discards its oldest half
+		stream->window_size = (entries + 1) * 4;
+		if (stream->window_size < LZ78_WINDOW_SIZE)
+			stream->window_size = LZ78_WINDOW_SIZE;
+		stream->window = malloc(stream->window_size);
+		
+		if (stream->offsets == NULL || stream->lengths == NULL || stream->window == NULL)
+			goto error;
+	}
+	
+	// the standby dictionary is a hash table for the shadow parse on both sides, and the decompressor also builds
+	// the tables indexed by code which replace its active ones
+	if (options->standby > 0) {
+		stream->standby = dictionary_alloc((int)(((int64_t)entries * 100 + load_factor - 1) / load_factor), true, layout);
+		if (stream->standby == NULL)
+			goto error;
+		dictionary_compressor_init(stream->standby);
+		
+		if (compressing == false) {
+			stream->standby_codes = dictionary_alloc(entries, false, DICTIONARY_LINEAR);
+			stream->standby_offsets = dictionary_table_alloc((size_t)entries * sizeof(uint64_t));
+			stream->standby_lengths = dictionary_table_alloc((size_t)entries * sizeof(uint32_t));
+			if (stream->standby_codes == NULL || stream->standby_offsets == NULL || stream->standby_lengths == NULL)
+				goto error;
+			dictionary_decompressor_init(stream->standby_codes);
+		}
+		
+		stream->standby_next = FIRST_CODE;
+		stream->standby_from = FIRST_CODE + (CODE)(((uint64_t)(entries - FIRST_CODE) * options->standby) / 100);
+	}
+	
+	// the dictionary starts from the preset entries, whose strings precede the first position of the window
+	dictionary_restart(stream);
+	stream->width = (options->variable == true)?(code_width(LZ78_MIN_WIDTH, stream->next_code, stream->first_code)):(options->bits);
+	stream->window_base = (options->preset != NULL)?(1):(0);
+	stream->window_end = stream->window_base;
+	
+	// the beginning of the stream is the first restart point
+	if (compressing == true && restart_record(stream, 0) < 0)
+		goto error;
+	
+	// the tables of the dictionaries, and the ones of the strings of the decompressor
+	stream->stats.memory = sizeof(LZ78_STREAM) + dictionary_memory(stream->dictionary) + dictionary_memory(stream->standby) +
+			dictionary_memory(stream->standby_codes) + stream->window_size;
+	if (compressing == false)
+		stream->stats.memory += (uint64_t)entries * (sizeof(uint64_t) + sizeof(uint32_t)) * ((options->standby > 0)?(2):(1));
+	STATS(stream->stats.setup_time = stats_clock() - start);
+	
+	return stream;
+	
+error:
+	lz78_free(stream);
+	return NULL;
+}
+
+int lz78_encode (LZ78_STREAM* stream, const uint8_t* in, size_t len, size_t* used)
+{
+	int ret;
+	STATS(uint64_t start = stats_clock());
+	
+	ret = encode_data(stream, in, len, used);
+	STATS(if (stream != NULL) stream->stats.codec_time += stats_clock() - start);
+	
+	return ret;
+}
+
+int encode_data (LZ78_STREAM* stream, const uint8_t* in, size_t len, size_t* used)
+{
+	CODE index;				// node of the found character
+	CODE victim;			// code reused by a full dictionary
+	uint64_t data;
+	size_t i;
+	int ret, dictionary_counter;
+	
+	*used = 0;
+	
+	if (stream == NULL || stream->compressing == false || stream->tail > 0)
+		return LZ78_ERROR;
+	
+	// a CLEAR code is written before the following ones
+	if (stream->clear_pending == true) {
+		ret = encode_clear(stream, stream->stats.bytes_in - 1);
+		if (ret < 0)
+			return LZ78_ERROR;
+		if (ret == 1)
+			return LZ78_OK;
+	}
+	
+	i = 0;
+	
+	// the first symbol is the current node
+	if (stream->started == false && len > 0) {
+		stream->current_code = in[i++];
+		stream->started = true;
+	}
+	
+	for (; i < len; i++) {
+		
+		// performing a look up of the extracted character
+		index = dictionary_lookup(stream->dictionary, stream->current_code, (SYMBOL)in[i]);
+		
+		// if it's already in the dictionary, set current code as the code of the entry found using the dictionary_lookup
+		if (dictionary_is_entry_unused(stream->dictionary, index) == false) {
+			stream->current_code = dictionary_get_entry_code(stream->dictionary, index);
+			continue;
+		}
+		
+		// the code is not in the dictionary: emit code
+		data = (uint64_t)stream->current_code;
+		ret = bit_write(stream->bf, &data, stream->width);
+		if (ret < 0)
+			return LZ78_ERROR;
+		
+		// the buffer of a stream bit file is full: the character will be looked up again
+		if (ret == 1)
+			break;
+		
+		stream->stats.codes++;
+		
+		// the decompressor marks the code as used right after reading it
+		if (stream->options.lru == true)
+			dictionary_touch(stream->dictionary, stream->current_code);
+		
+		// a full dictionary reuses the code of its least recently used leaf, unless it is the node being extended
+		if (stream->full == true) {
+			victim = dictionary_lru_code(stream->dictionary);
+			if (victim != stream->current_code) {
+				dictionary_evict(stream->dictionary);
+				STATS(stream->stats.evictions++);
+				
+				// the removal can move the entries of the hash table, so the free slot is looked up again
+				index = dictionary_lookup(stream->dictionary, stream->current_code, (SYMBOL)in[i]);
+				dictionary_insert(stream->dictionary, index, stream->current_code, victim, (SYMBOL)in[i]);
+			}
+			stream->current_code = (CODE)in[i];
+			continue;
+		}
+		
+		// a frozen dictionary is not updated anymore: the compression ratio is monitored instead
+		if (stream->frozen == true) {
+			stream->current_code = (CODE)in[i];
+			ret = monitor_ratio(stream, stream->stats.bytes_in + i);
+			if (ret < 0)
+				return LZ78_ERROR;
+			if (ret == 1) {
+				i++;
+				break;
+			}
+			continue;
+		}
+		
+		// init dictonary entry
+		dictionary_insert(stream->dictionary, index, stream->current_code, stream->next_code, (SYMBOL)in[i]);
+		
+		// the decompressor adds this entry after reading the next code, so its next code is this one
+		if (stream->options.variable == true)
+			stream->width = code_width(stream->width, stream->next_code, stream->first_code);
+		
+		stream->next_code++;
+		
+		// set current_code as code of node child of the root with symbol == character
+		stream->current_code = (CODE)in[i];
+		
+		// getting the number of used entries in the dictionary
+		dictionary_counter = dictionary_count(stream->dictionary);
+		
+		// check if next_code has reached max admissible value, or half of the table is filled (optimization)
+		if ((stream->next_code > stream->max_code) || (dictionary_counter > stream->options.dict_size/2)) {
+			
+			// the LRU replacement keeps the full dictionary, and reuses its codes
+			if (stream->options.lru == true)
+				stream->full = true;
+			// the adaptive policy keeps the full dictionary, until its compression ratio gets worse
+			else if (stream->options.adaptive == true) {
+				stream->frozen = true;
+				stream->check_in = stream->stats.bytes_in + i;
+				stream->check_bits = 0;
+				stream->best_ratio = 0;
+			}
+			// the warm standby replaces the full dictionary: the shadow parse stops before the current symbol
+			else if (stream->options.standby > 0) {
+				if (stream->standby_on == true)
+					standby_feed(stream, in + (stream->shadow_pos - stream->stats.bytes_in), stream->stats.bytes_in + i - stream->shadow_pos);
+				standby_swap(stream);
+			}
+			else {
+				// reinit the dictionary
+				dictionary_restart(stream);
+				STATS(stream->stats.resets_full++);
+				if (restart_record(stream, stream->stats.bytes_in + i) < 0)
+					return LZ78_ERROR;
+			}
+		}
+		// the shadow parse starts from the current symbol, once the active dictionary is filled enough
+		else if (stream->options.standby > 0 && stream->standby_on == false && stream->next_code >= stream->standby_from) {
+			stream->standby_on = true;
+			stream->shadow_pos = stream->stats.bytes_in + i;
+			stream->shadow_length = 0;
+		}
+	}
+	
+	// the consumed bytes are fed to the shadow parse, since they are not available to the next call
+	if (stream->standby_on == true)
+		standby_feed(stream, in + (stream->shadow_pos - stream->stats.bytes_in), stream->stats.bytes_in + i - stream->shadow_pos);
+	
+	*used = i;
+	stream->stats.bytes_in += i;
+	
+	return LZ78_OK;
+}
+
+int lz78_encode_end (LZ78_STREAM* stream)
+{
+	uint64_t data;
+	int ret, width;
+	
+	if (stream == NULL || stream->compressing == false)
+		return LZ78_ERROR;
+	
+	// a CLEAR code is written before the last code
+	if (stream->clear_pending == true) {
+		ret = encode_clear(stream, stream->stats.bytes_in - 1);
+		if (ret < 0)
+			return LZ78_ERROR;
+		if (ret == 1)
+			return LZ78_OK;
+	}
+	
+	// writing the last code extracted (if the input is not empty), then EOS
+	while (stream->tail < 2) {
+		if (stream->tail == 0 && stream->started == false) {
+			stream->tail++;
+			continue;
+		}
+		
+		// the decompressor reads EOS after adding the entry of the last code, so its next code is the current one
+		data = (stream->tail == 0)?((uint64_t)stream->current_code):(EOS);
+		width = stream->width;
+		if (stream->tail == 1 && stream->options.variable == true)
+			width = code_width(stream->width, stream->next_code, stream->first_code);
+		ret = bit_write(stream->bf, &data, width);
+		if (ret < 0)
+			return LZ78_ERROR;
+		if (ret == 1)
+			return LZ78_OK;
+		
+		if (stream->tail == 0)
+			stream->stats.codes++;
+		stream->tail++;
+	}
+	
+	return LZ78_END;
+}
+
+int lz78_decode (LZ78_STREAM* stream, uint8_t* out, size_t len, size_t* produced)
+{
+	int ret;
+	STATS(uint64_t start = stats_clock());
+	
+	ret = decode_data(stream, out, len, produced);
+	STATS(if (stream != NULL) stream->stats.codec_time += stats_clock() - start);
+	
+	return ret;
+}
+
+int decode_data (LZ78_STREAM* stream, uint8_t* out, size_t len, size_t* produced)
+{
+	CODE new_code, target;
+	uint64_t data, offset;
+	uint8_t* dest;
+	uint32_t length;
+	int res, dictionary_counter;
+	size_t done, count;
+	bool first, insert;
+	
+	*produced = 0;
+	
+	if (stream == NULL || stream->compressing == true)
+		return LZ78_ERROR;
+	
+	done = 0;
+	
+	while (1) {
+		
+		// the decoded bytes are copied to the output area in bulk, when they fill it or a quarter of the window
+		if (stream->pending > 0 && (stream->pending >= len - done || stream->pending >= stream->window_size / 4)) {
+			count = (stream->pending < len - done)?(stream->pending):(len - done);
+			memcpy(out + done, stream->window + (stream->window_end - stream->window_base - stream->pending), count);
+			stream->pending -= count;
+			done += count;
+			
+			if (stream->pending > 0)
+				break;
+			continue;
+		}
+		
+		if (stream->ended == true || (stream->max_codes > 0 && stream->stats.codes == stream->max_codes)) {
+			stream->ended = true;
+			break;
+		}
+		
+		// reading the next code
+		res = bit_read(stream->bf, &data, stream->width);
+		if (res < 0)
+			goto error;
+		
+		// a stream bit file needs more bytes
+		if (res == 1)
+			break;
+		
+		// EOS is reached (2 is an internal code for EOS)
+		if (res == 2) {
+			stream->ended = true;
+			break;
+		}
+		
+		new_code = (CODE)data;
+		stream->stats.codes++;
+		
+		// the next code of a frozen dictionary is CLEAR: the dictionary is reset, and the next code is a symbol again
+		if (stream->frozen == true && new_code == stream->next_code) {
+			dictionary_restart(stream);
+			stream->frozen = false;
+			stream->started = false;
+			STATS(stream->stats.resets_clear++);
+			if (stream->options.variable == true)
+				stream->width = code_width(stream->width, stream->next_code, stream->first_code);
+			continue;
+		}
+		
+		offset = stream->window_end;
+		first = (stream->started == false);
+		
+		// the code of the entry added by this step: the next one or, if the dictionary is full, the one of its least recently
+		// used leaf, unless it is the node being extended (the compressor chose it before writing the current code)
+		target = stream->next_code;
+		insert = true;
+		
+		// the insertion would fill the active dictionary: the compressor has already replaced it with the standby one,
+		// which the current code belongs to, and the entry of the previous code has been discarded
+		if (stream->swapping == true) {
+			standby_swap(stream);
+			stream->swapping = false;
+			target = stream->next_code;
+			insert = false;
+		}
+		else if (stream->full == true) {
+			target = dictionary_lru_code(stream->dictionary);
+			insert = (target != stream->old_code);
+		}
+		
+		// the first code is a symbol, or an entry of the preset dictionary
+		if (first == true) {
+			if (new_code == EOS || new_code >= stream->next_code)
+				goto error;
+			
+			stream->started = true;
+			dest = window_reserve(stream, (new_code < SYMBOLS)?(1):(stream->lengths[new_code]));
+			length = decode_string(stream, new_code, dest);
+		}
+		// special case:
+		// the node labeled with the code of the new entry is not still in the dictionary
+		else if (insert == true && new_code == target) {
+			
+			// the string is the previous one, followed by its first symbol
+			dest = window_reserve(stream, stream->old_length + 1);
+			length = decode_string(stream, stream->old_code, dest);
+			dest[length++] = dest[0];
+		}
+		// regular case:
+		// checking that the node labeled with the next code is still in the dicitonary
+		else if (new_code < stream->next_code) {
+			
+			// copying the string of the code at the end of the window
+			dest = window_reserve(stream, (new_code < SYMBOLS)?(1):(stream->lengths[new_code]));
+			length = decode_string(stream, new_code, dest);
+		}
+		// a code which has not been assigned yet: the stream is corrupted
+		else {
+			goto error;
+		}
+		
+		stream->window_end += length;
+		stream->pending += length;
+		
+		// a full dictionary reuses the code of the entry: the least recently used leaf is replaced
+		if (first == false && stream->full == true && insert == true) {
+			dictionary_evict(stream->dictionary);
+			STATS(stream->stats.evictions++);
+			dictionary_insert(stream->dictionary, (uint32_t)target, stream->old_code, target, dest[0]);
+			stream->offsets[target] = stream->old_offset;
+			stream->lengths[target] = stream->old_length + 1;
+		}
+		// the first string has no previous one to be extended, and a frozen dictionary is not updated anymore
+		else if (first == false && stream->full == false && stream->frozen == false && insert == true) {
+			
+			// adding a new entry in the dictionary: the previous string followed by the first symbol of the current one,
+			// which is where the previous string was decoded
+			dictionary_insert(stream->dictionary, (uint32_t)stream->next_code, stream->old_code, stream->next_code, dest[0]);
+			stream->offsets[stream->next_code] = stream->old_offset;
+			stream->lengths[stream->next_code] = stream->old_length + 1;
+			
+			stream->next_code++;
+			
+			// getting the number of used entries in the dictionary
+			dictionary_counter = dictionary_count(stream->dictionary);
+			
+			//check if next_code has reached max admissible value
+			if ((stream->next_code > stream->max_code) || (dictionary_counter > stream->options.dict_size/2)) {
+				
+				// the LRU replacement keeps the full dictionary, and reuses its codes
+				if (stream->options.lru == true)
+					stream->full = true;
+				// the adaptive policy keeps the full dictionary, until the compressor writes CLEAR
+				else if (stream->options.adaptive == true)
+					stream->frozen = true;
+				else {
+					// reinit the dictionary
+					dictionary_restart(stream);
+					STATS(stream->stats.resets_full++);
+				}
+			}
+			// the shadow parse starts from the current string, once the active dictionary is filled enough
+			else if (stream->options.standby > 0 && stream->standby_on == false && stream->next_code >= stream->standby_from) {
+				stream->standby_on = true;
+				stream->shadow_pos = offset;
+				stream->shadow_length = 0;
+			}
+		}
+		
+		// the width covers the next code, which is CLEAR when the dictionary is frozen, and is never assigned when it is full
+		if (first == false && stream->options.variable == true)
+			stream->width = code_width(stream->width, (stream->full == true)?(stream->next_code - 1):(stream->next_code), stream->first_code);
+		// the first code after a restart point can be wider than the following ones (see lz78_decode_restart)
+		else if (first == true && stream->options.variable == true)
+			stream->width = code_width(LZ78_MIN_WIDTH, stream->next_code, stream->first_code);
+		
+		// the current code has just been used
+		if (stream->options.lru == true)
+			dictionary_touch(stream->dictionary, new_code);
+		
+		// the shadow parse follows the decoded data, and the replacement of a dictionary which is going to be full is anticipated
+		if (stream->options.standby > 0) {
+			if (stream->standby_on == true)
+				standby_feed(stream, stream->window + (stream->shadow_pos - stream->window_base), stream->window_end - stream->shadow_pos);
+			stream->swapping = dictionary_limit(stream);
+			if (stream->swapping == true && stream->options.variable == true)
+				stream->width = code_width(LZ78_MIN_WIDTH, stream->standby_next, stream->first_code);
+		}
+		
+		// the current code has just been decoded: this is its last occurrence
+		if (new_code >= SYMBOLS)
+			stream->offsets[new_code] = offset;
+		
+		stream->old_code = new_code;
+		stream->old_offset = offset;
+		stream->old_length = length;
+	}
+	
+	// copying the decoded bytes left, as far as they fit in the output area
+	count = (stream->pending < len - done)?(stream->pending):(len - done);
+	if (count > 0) {
+		memcpy(out + done, stream->window + (stream->window_end - stream->window_base - stream->pending), count);
+		stream->pending -= count;
+		done += count;
+	}
+	
+	*produced = done;
+	stream->stats.bytes_out += done;
+	
+	return (stream->ended == true && stream->pending == 0)?(LZ78_END):(LZ78_OK);
+	
+error:
+	*produced = done;
+	stream->stats.bytes_out += done;
+	return LZ78_ERROR;
+}
+
+void lz78_decode_limit (LZ78_STREAM* stream, uint64_t max_codes)
+{
+	if (stream != NULL)
+		stream->max_codes = max_codes;
+}
+
+const LZ78_RESTART* lz78_restarts (LZ78_STREAM* stream, size_t* count)
+{
+	*count = 0;
+	if (stream == NULL || stream->compressing == false)
+		return NULL;
+	
+	*count = stream->restart_count;
+	
+	return stream->restarts;
+}
+
+int lz78_decode_restart (LZ78_STREAM* stream, const LZ78_RESTART* restart)
+{
+	if (stream == NULL || stream->compressing == true || stream->started == true || stream->stats.codes > 0)
+		return LZ78_ERROR;
+	
+	// the compressor writes the first code after a full reset as wide as the previous one: the decompressor reads it
+	// before its own reset, which follows the entry of that code
+	if (restart->width != stream->width && (stream->options.variable == false || restart->width < stream->width ||
+		restart->width > stream->options.bits))
+		return LZ78_ERROR;
+	stream->width = restart->width;
+	
+	return LZ78_OK;
+}
+
+uint32_t decode_string (LZ78_STREAM* stream, CODE code, uint8_t* dest)
+{
+	uint64_t offset;
+	uint32_t length, i;
+	
+	// the children of the root are implicit: the code is the symbol
+	if (code < SYMBOLS) {
+		dest[0] = (uint8_t)code;
+		return 1;
+	}
+	
+	length = stream->lengths[code];
+	offset = stream->offsets[code];
+	
+	// the last occurrence is still in the window, and it precedes the destination (short strings are copied inline)
+	if (offset >= stream->window_base) {
+		if (length <= 16) {
+			for (i = 0; i < length; i++)
+				dest[i] = stream->window[offset - stream->window_base + i];
+		}
+		else {
+			memcpy(dest, stream->window + (offset - stream->window_base), length);
+		}
+		return length;
+	}
+	
+	// otherwise the symbols are stored backwards, moving up in the tree
+	for (i = length; code >= SYMBOLS; code = dictionary_get_entry_parent(stream->dictionary, code))
+		dest[--i] = (uint8_t)dictionary_get_entry_symbol(stream->dictionary, code);
+	dest[--i] = (uint8_t)code;
+	
+	return length;
+}
+
+uint8_t* window_reserve (LZ78_STREAM* stream, uint32_t len)
+{
+	size_t used, keep;
+	
+	used = stream->window_end - stream->window_base;
+	
+	// keeping the newest half of the window, which holds at least the previous string
+	if (used + len > stream->window_size) {
+		keep = stream->window_size / 2;
+		memmove(stream->window, stream->window + (used - keep), keep);
+		stream->window_base += used - keep;
+		used = keep;
+	}
+	
+	return stream->window + used;
+}
+
+int monitor_ratio (LZ78_STREAM* stream, uint64_t position)
+{
+	uint64_t ratio;
+	
+	stream->check_bits += stream->width;
+	
+	// the decompressor reads the following codes as wide as the next code, which is CLEAR
+	if (stream->options.variable == true)
+		stream->width = code_width(stream->width, stream->next_code, stream->first_code);
+	
+	if (position - stream->check_in < LZ78_CHECK_GAP)
+		return 0;
+	
+	// ratio between the input and the output bits of the window
+	ratio = ((position - stream->check_in) * 8 * 1000) / stream->check_bits;
+	stream->check_in = position;
+	stream->check_bits = 0;
+	
+	if (ratio > stream->best_ratio)
+		stream->best_ratio = ratio;
+	
+	// the window is still close enough to the best one, and it is not expanded (a new dictionary can't do worse)
+	if (ratio >= 1000 && ratio * 100 >= stream->best_ratio * (100 - stream->options.reset_threshold))
+		return 0;
+	
+	stream->clear_pending = true;
+	
+	return encode_clear(stream, position);
+}
+
+int encode_clear (LZ78_STREAM* stream, uint64_t position)
+{
+	uint64_t data;
+	int ret;
+	
+	data = (uint64_t)stream->next_code;
+	ret = bit_write(stream->bf, &data, stream->width);
+	if (ret != 0)
+		return ret;
+	
+	stream->stats.codes++;
+	STATS(stream->stats.resets_clear++);
+	stream->clear_pending = false;
+	stream->frozen = false;
+	
+	// reinit the dictionary
+	dictionary_restart(stream);
+	
+	if (stream->options.variable == true)
+		stream->width = code_width(stream->width, stream->next_code, stream->first_code);
+	
+	return restart_record(stream, position);
+}
+
+int restart_record (LZ78_STREAM* stream, uint64_t position)
+{
+	LZ78_RESTART* restarts;
+	size_t size;
+	
+	// the resets closer than LZ78_RESTART_GAP to the previous restart point would make the index larger than what it saves
+	if (stream->options.index == false ||
+		(stream->restart_count > 0 && position - stream->restarts[stream->restart_count - 1].offset < LZ78_RESTART_GAP))
+		return 0;
+	
+	if (stream->restart_count == stream->restart_size) {
+		size = (stream->restart_size > 0)?(stream->restart_size * 2):(64);
+		restarts = realloc(stream->restarts, size * sizeof(LZ78_RESTART));
+		if (restarts == NULL)
+			return -1;
+		stream->restarts = restarts;
+		stream->restart_size = size;
+	}
+	
+	// the code following the reset has the width of the last code before it, which the decompressor reads before resetting
+	stream->restarts[stream->restart_count].offset = position;
+	stream->restarts[stream->restart_count].bit_offset = bit_tell(stream->bf);
+	stream->restarts[stream->restart_count].width = stream->width;
+	stream->restart_count++;
+	
+	return 0;
+}
+
+void standby_feed (LZ78_STREAM* stream, const uint8_t* data, size_t len)
+{
+	uint32_t index;
+	size_t i;
+	
+	for (i = 0; i < len; i++) {
+		
+		// the first symbol is the current node
+		if (stream->shadow_length == 0) {
+			stream->shadow_code = data[i];
+			stream->shadow_length = 1;
+			continue;
+		}
+		
+		index = dictionary_lookup(stream->standby, stream->shadow_code, (SYMBOL)data[i]);
+		if (dictionary_is_entry_unused(stream->standby, index) == false) {
+			stream->shadow_code = dictionary_get_entry_code(stream->standby, index);
+			stream->shadow_length++;
+			continue;
+		}
+		
+		// the string is added, unless the standby dictionary would be full as soon as it becomes the active one
+		if (stream->standby_next + 1 <= stream->max_code && dictionary_count(stream->standby) + 1 <= stream->options.dict_size/2) {
+			dictionary_insert(stream->standby, index, stream->shadow_code, stream->standby_next, (SYMBOL)data[i]);
+			
+			// the decompressor also records the string as the active dictionary does: it ends with the current byte
+			if (stream->compressing == false) {
+				dictionary_insert(stream->standby_codes, (uint32_t)stream->standby_next, stream->shadow_code, stream->standby_next, (SYMBOL)data[i]);
+				stream->standby_offsets[stream->standby_next] = stream->shadow_pos + i - stream->shadow_length;
+				stream->standby_lengths[stream->standby_next] = stream->shadow_length + 1;
+			}
+			
+			stream->standby_next++;
+		}
+		
+		stream->shadow_code = data[i];
+		stream->shadow_length = 1;
+	}
+	
+	stream->shadow_pos += len;
+}
+
+void standby_swap (LZ78_STREAM* stream)
+{
+	dictionary* dictionary;
+	uint64_t* offsets;
+	uint32_t* lengths;
+	
+	// the tables of the active dictionary become the new standby ones, which are reset
+	if (stream->compressing == true) {
+		dictionary = stream->dictionary;
+		stream->dictionary = stream->standby;
+		stream->standby = dictionary;
+	}
+	else {
+		dictionary = stream->dictionary;
+		stream->dictionary = stream->standby_codes;
+		stream->standby_codes = dictionary;
+		dictionary_decompressor_init(stream->standby_codes);
+		
+		offsets = stream->offsets;
+		stream->offsets = stream->standby_offsets;
+		stream->standby_offsets = offsets;
+		
+		lengths = stream->lengths;
+		stream->lengths = stream->standby_lengths;
+		stream->standby_lengths = lengths;
+	}
+	dictionary_compressor_init(stream->standby);
+	
+	stream->next_code = stream->standby_next;
+	stream->standby_next = FIRST_CODE;
+	stream->standby_on = false;
+	stream->shadow_length = 0;
+	STATS(stream->stats.resets_swap++);
+	
+	// the width covers the next code of the new active dictionary
+	if (stream->options.variable == true)
+		stream->width = code_width(LZ78_MIN_WIDTH, stream->next_code, stream->first_code);
+}
+
+bool dictionary_limit (LZ78_STREAM* stream)
+{
+	return (stream->next_code + 1 > stream->max_code) || (dictionary_count(stream->dictionary) + 1 > stream->options.dict_size/2);
+}
+
+void dictionary_restart (LZ78_STREAM* stream)
+{
+	PRESET* preset;
+	CODE parent, i;
+	uint32_t index;
+	
+	preset = stream->options.preset;
+	
+	// a new compressor maps the image of its dictionary with the preset entries, when the file has one of its size
+	if (stream->compressing == true && preset != NULL && preset->image_fd >= 0 &&
+		dictionary_image_map(stream->dictionary, preset->image_fd, preset->image_offset) == 0 &&
+		dictionary_count(stream->dictionary) == SYMBOLS + (int)preset->count) {
+		stream->next_code = FIRST_CODE + preset->count;
+		stream->first_code = stream->next_code;
+		return;
+	}
+	
+	if (stream->compressing == true)
+		dictionary_compressor_init(stream->dictionary);
+	else
+		dictionary_decompressor_init(stream->dictionary);
+	stream->next_code = FIRST_CODE;
+	
+	if (preset == NULL)
+		return;
+	
+	// the entries are inserted as the data would do, every one after its parent
+	for (i = 0; i < preset->count; i++, stream->next_code++) {
+		parent = preset->parents[i];
+		if (stream->compressing == true) {
+			index = dictionary_lookup(stream->dictionary, parent, (SYMBOL)preset->symbols[i]);
+			dictionary_insert(stream->dictionary, index, parent, stream->next_code, (SYMBOL)preset->symbols[i]);
+		}
+		else {
+			dictionary_insert(stream->dictionary, (uint32_t)stream->next_code, parent, stream->next_code, (SYMBOL)preset->symbols[i]);
+			stream->offsets[stream->next_code] = 0;
+			stream->lengths[stream->next_code] = ((parent < SYMBOLS)?(1):(stream->lengths[parent])) + 1;
+		}
+	}
+	stream->first_code = stream->next_code;
+}
+
+int code_width (int width, CODE next, CODE first)
+{
+	// after a reset the codes start again from the narrowest width which covers the preset entries
+	if (next == first)
+		width = LZ78_MIN_WIDTH;
+	
+	// the next code usually grows by one, so the width grows by at most one bit, but a standby dictionary can start from any code
+	while (((CODE)1 << width) <= next)
+		width++;
+	
+	return width;
+}
@@ -0,0 +1,260 @@
+/*
+ * lz78.h
+ * Francesco Piras - Dario Varano
+ * June 2015
+ */
+
+#ifndef _LZ78_H
+#define _LZ78_H
+
+#include "definitions.h"
+#include "bitio.h"
+
+/**
+ * NOTE ON THE STREAM CONTEXT
+ * 
+ * All the state of a compression or decompression (the dictionary, the bit buffer, the current code and the
+ * statistics) is kept in a stream context, so that any number of streams can be processed at the same time,
+ * by any number of threads, as long as a single stream is used by one thread at a time.
+ * 
+ * The in-memory interface works like zlib: the caller passes input and output buffers of any size, and every
+ * call consumes as much input and produces as much output as possible:
+ * 
+ * 		compression:	lz78_compress_init, lz78_compress_chunk (any number of times), lz78_compress_finish
+ * 						(until it returns LZ78_END), lz78_free
+ * 		decompression:	lz78_decompress_init, lz78_decompress_chunk (until it returns LZ78_END), lz78_free
+ * 
+ * The file drivers bind the context to a bit file instead, with lz78_open, and call lz78_encode, lz78_encode_end
+ * and lz78_decode directly.
+ */
+
+#define LZ78_OK			0				// the call made progress, the stream is not over
+#define LZ78_END		1				// the stream is over
+#define LZ78_ERROR		-1				// the stream is corrupted, or the parameters are not valid
+
+/**
+ * NOTE ON THE STATISTICS
+ * 
+ * The counters of bytes and codes are always kept, since the codec needs them. The other ones (lookups, probes,
+ * resets, evictions and timings) cost a few instructions on the hot path, so they are compiled out, and left to 0,
+ * when the library is built with -DLZ78_NO_STATS (make STATS=0).
+ */
+
+#define LZ78_RESET_THRESHOLD	10		// default loss (in percent) of the compression ratio which clears a frozen dictionary
+
+/**
+ * @brief The statistics of a stream
+ * 
+ */
+typedef struct lz78_stats_struct {
+	uint64_t bytes_in;			// number of bytes consumed
+	uint64_t bytes_out;			// number of bytes produced
+	uint64_t codes;				// number of codes written or read (EOS excluded)
+	uint64_t resets;			// number of resets of the dictionary, for any cause
+	uint64_t resets_full;		// resets of a full dictionary (fixed reset policy)
+	uint64_t resets_clear;		// resets requested by a CLEAR code (adaptive reset policy)
+	uint64_t resets_swap;		// replacements of a full dictionary by the standby one
+	uint64_t evictions;			// codes evicted from a full dictionary and reused (LRU replacement policy)
+	uint64_t lookups;			// number of dictionary lookups
+	uint64_t direct_lookups;	// number of dictionary lookups served by the direct table (the other ones are hashed)
+	uint64_t collisions;		// number of collisions of the dictionary lookups
+	uint64_t max_probe;			// longest probe length of a hashed lookup, that is its number of collisions (0 if the first slot is the right one)
+	uint64_t probes[PROBE_BUCKETS];	// histogram of the number of collisions of the hashed lookups
+	uint64_t setup_time;		// time (in nanoseconds) spent allocating the stream
+	uint64_t codec_time;		// time (in nanoseconds) spent encoding or decoding, the I/O of a bound bit file included
+	uint64_t memory;			// size (in bytes) of the tables of the stream (the largest stream, in a total)
+} LZ78_STATS;
+
+/**
+ * @brief A restart point: a position where the compressor emptied its dictionary, from which a fresh decompression
+ * 		stream can start (see lz78_decode_restart)
+ * 
+ */
+typedef struct lz78_restart_struct {
+	uint64_t offset;			// position (in bytes) of the uncompressed data following the reset
+	uint64_t bit_offset;		// position (in bits, from the first code of the stream) of the first code following the reset
+	int width;					// width (in bits) of that code
+} LZ78_RESTART;
+
+/**
+ * @brief A compression or decompression stream
+ * 
+ */
+typedef struct lz78_stream LZ78_STREAM;
+
+/**
+ * @brief It allocates a compression stream, whose output is taken with lz78_compress_chunk and lz78_compress_finish
+ * 
+ * @param options the compression parameters (bits and dict_size)
+ * @return LZ78_STREAM* pointer to the stream allocated in the dynamic memory, or NULL if an error occurs
+ */
+LZ78_STREAM* lz78_compress_init (OPTIONS* options);
+
+/**
+ * @brief It compresses a chunk of data
+ * 
+ * @param stream the pointer to the compression stream
+ * @param in the input data
+ * @param in_len the number of input bytes
+ * @param in_used the number of input bytes consumed (set by the function)
+ * @param out the output area
+ * @param out_len the size (in bytes) of the output area
+ * @param out_used the number of output bytes produced (set by the function)
+ * @return int LZ78_OK or LZ78_ERROR. If not all the input has been consumed, the output area was too small
+ */
+int lz78_compress_chunk (LZ78_STREAM* stream, const uint8_t* in, size_t in_len, size_t* in_used, uint8_t* out, size_t out_len, size_t* out_used);
+
+/**
+ * @brief It terminates the compression, producing the last codes and EOS
+ * 
+ * @param stream the pointer to the compression stream
+ * @param out the output area
+ * @param out_len the size (in bytes) of the output area
+ * @param out_used the number of output bytes produced (set by the function)
+ * @return int LZ78_END when the whole stream has been produced, LZ78_OK if it has to be called again with more output space,
+ * 		or LZ78_ERROR
+ */
+int lz78_compress_finish (LZ78_STREAM* stream, uint8_t* out, size_t out_len, size_t* out_used);
+
+/**
+ * @brief It allocates a decompression stream, whose input is given with lz78_decompress_chunk
+ * 
+ * @param options the decompression parameters (bits and dict_size)
+ * @return LZ78_STREAM* pointer to the stream allocated in the dynamic memory, or NULL if an error occurs
+ */
+LZ78_STREAM* lz78_decompress_init (OPTIONS* options);
+
+/**
+ * @brief It decompresses a chunk of data
+ * 
+ * @param stream the pointer to the decompression stream
+ * @param in the input data
+ * @param in_len the number of input bytes
+ * @param in_used the number of input bytes consumed (set by the function)
+ * @param out the output area
+ * @param out_len the size (in bytes) of the output area
+ * @param out_used the number of output bytes produced (set by the function)
+ * @return int LZ78_END when EOS has been read and all the data has been produced, LZ78_OK if more input or
+ * 		more output space is needed, or LZ78_ERROR
+ */
+int lz78_decompress_chunk (LZ78_STREAM* stream, const uint8_t* in, size_t in_len, size_t* in_used, uint8_t* out, size_t out_len, size_t* out_used);
+
+/**
+ * @brief It returns the statistics of a stream
+ * 
+ * @param stream the pointer to the stream
+ * @param stats the pointer to the structure to be filled
+ * @return void
+ */
+void lz78_stats (LZ78_STREAM* stream, LZ78_STATS* stats);
+
+/**
+ * @brief It adds the statistics of a stream to a total, as when a file is processed by independent streams
+ * 
+ * @param total the pointer to the total
+ * @param stats the pointer to the statistics to be added
+ * @return void
+ */
+void lz78_stats_add (LZ78_STATS* total, LZ78_STATS* stats);
+
+/**
+ * @brief It makes a stream start again from the beginning, as a new one with the same parameters, without allocating
+ * 		its dictionary again: a stream of lz78_open is bound to another bit file, a stream of the in-memory interface
+ * 		gets a new empty one (bf has to be NULL). The statistics start again from 0
+ * 
+ * @param stream the pointer to the stream
+ * @param bf the bit file of the codes, or NULL for a stream of the in-memory interface
+ * @return int LZ78_OK or LZ78_ERROR
+ */
+int lz78_reset (LZ78_STREAM* stream, BIT_FILE* bf);
+
+/**
+ * @brief It writes the image of the dictionary of a compressor with some parameters, right after it loaded the entries
+ * 		of its preset dictionary, so that the compressors with a dictionary of the same size can map it (see preset.h)
+ * 
+ * @param options the parameters of the compressor, with the preset dictionary
+ * @param fp the file, open for writing
+ * @return int a flag indicating if the image has been written (0) or if an error occurs (-1)
+ */
+int lz78_image_save (OPTIONS* options, FILE* fp);
+
+/**
+ * @brief It deallocates a stream (the bit file of lz78_open is not closed)
+ * 
+ * @param stream the pointer to the stream
+ * @return void
+ */
+void lz78_free (LZ78_STREAM* stream);
+
+/**
+ * @brief It allocates a stream bound to a bit file, opened in writing mode for a compression or in reading mode for a decompression
+ * 
+ * @param options the parameters (bits and dict_size)
+ * @param bf the pointer to the bit file, which stays owned by the caller
+ * @param compressing flag indicating a compression stream (decompression if false)
+ * @return LZ78_STREAM* pointer to the stream allocated in the dynamic memory, or NULL if an error occurs
+ */
+LZ78_STREAM* lz78_open (OPTIONS* options, BIT_FILE* bf, bool compressing);
+
+/**
+ * @brief It compresses data, writing the codes on the bit file of the stream
+ * 
+ * @param stream the pointer to the compression stream
+ * @param in the input data
+ * @param len the number of input bytes
+ * @param used the number of input bytes consumed (set by the function): less than len only if the buffer of a stream bit file is full
+ * @return int LZ78_OK or LZ78_ERROR
+ */
+int lz78_encode (LZ78_STREAM* stream, const uint8_t* in, size_t len, size_t* used);
+
+/**
+ * @brief It writes the last code and EOS on the bit file of the stream
+ * 
+ * @param stream the pointer to the compression stream
+ * @return int LZ78_END when done, LZ78_OK if the buffer of a stream bit file is full, or LZ78_ERROR
+ */
+int lz78_encode_end (LZ78_STREAM* stream);
+
+/**
+ * @brief It decompresses the codes read from the bit file of the stream
+ * 
+ * @param stream the pointer to the decompression stream
+ * @param out the output area
+ * @param len the size (in bytes) of the output area
+ * @param produced the number of bytes produced (set by the function)
+ * @return int LZ78_END when EOS (or the code limit) has been reached and all the data has been produced,
+ * 		LZ78_OK if the output area is full or a stream bit file needs more bytes, or LZ78_ERROR
+ */
+int lz78_decode (LZ78_STREAM* stream, uint8_t* out, size_t len, size_t* produced);
+
+/**
+ * @brief It limits the number of codes read by a decompression stream, which ends after them as if EOS was read
+ * 
+ * @param stream the pointer to the decompression stream
+ * @param max_codes the number of codes to be read, or 0 to read up to EOS
+ * @return void
+ */
+void lz78_decode_limit (LZ78_STREAM* stream, uint64_t max_codes);
+
+/**
+ * @brief It returns the restart points recorded by a compression stream with options->index: the first one is the
+ * 		beginning of the stream, the other ones follow the resets of the dictionary, in order (a reset less than 4 KiB
+ * 		of input after the previous restart point is skipped)
+ * 
+ * @param stream the pointer to the compression stream
+ * @param count the number of restart points (set by the function)
+ * @return const LZ78_RESTART* the restart points, valid until the stream is reset or deallocated, or NULL if there is none
+ */
+const LZ78_RESTART* lz78_restarts (LZ78_STREAM* stream, size_t* count);
+
+/**
+ * @brief It makes a new decompression stream start from a restart point: its bit file has already been placed on the
+ * 		first code following the reset, which is decoded with the width it has been written with
+ * 
+ * @param stream the pointer to the decompression stream, which has not decoded anything yet
+ * @param restart the restart point
+ * @return int LZ78_OK or LZ78_ERROR
+ */
+int lz78_decode_restart (LZ78_STREAM* stream, const LZ78_RESTART* restart);
+
+#endif
@@ -5,47 +5,112 @@
  */
 
 #include <time.h>
+#include <errno.h>
 #include <unistd.h>
+#include <string.h>
+#include <getopt.h>
+#include <sys/resource.h>
 #include "definitions.h"
 #include "compressor.h"
 #include "decompressor.h"
+#include "blocks.h"
+#include "archive.h"
+#include "threadpool.h"
+#include "preset.h"
+#include "dictionary.h"
+
+/**
+ * @brief It prints the statistics of a compression or decompression as a JSON object
+ *
+ * @param out the output stream
+ * @param compression flag indicating a compression (decompression if false)
+ * @param ret the result of the operation
+ * @param wall the wall time (in seconds) of the operation
+ * @param stats the pointer to the statistics
+ * @return void
+ */
+void print_stats_json (FILE* out, bool compression, int ret, double wall, LZ78_STATS* stats);
 
 int main(int argc, char** argv)
 {
 	int arg;
 	char* input;
 	char* output;
+	char* preset_path;
 	bool compression_flag;
+	bool archive_flag;
+	bool test_flag;
+	bool json_stats;
+	bool range_flag;
+	char* range_end;
+	uint64_t range_start, range_len;
+	FILE* messages;
+	FILE* stats_out;
+	struct option long_options[] = {
+		{ "stats", required_argument, NULL, 'S' },
+		{ "index", no_argument, NULL, 'I' },
+		{ "range", required_argument, NULL, 'R' },
+		{ "table", required_argument, NULL, 'T' },
+		{ NULL, 0, NULL, 0 }
+	};
 	
 	int ret;
-	uint32_t dict_size, bits;
-	clock_t start, end;
+	uint32_t dict_size, bits, threads, block_size, buffer_size, load_factor, reset_threshold, standby;
+	OPTIONS options;
+	LZ78_STATS stats;
+	struct timespec start, end;
 	double diff;
 	
-	/* TO DELETE */
-	COLLISIONS = 0;
-	LOOKUP_COUNT = 0;
+	memset(&stats, 0, sizeof(stats));
 
-
-	// checking the number of the argument (they have to be at least 2)
-	if (argc < 2) {
-		fprintf(stderr, "Too few arguments specified\n");
-		return -1;
-	}
-	
 	// set compression as default operation
 	compression_flag = true;
+	// a single file by default
+	archive_flag = false;
+	// the decompressed data is written by default
+	test_flag = false;
 
 	// bits init
 	bits = 0;
 	// table size init
 	dict_size = 0;
+	// sequential format by default
+	threads = 0;
+	block_size = 0;
+	// default buffers
+	buffer_size = 0;
+	// default load factor of the dictionary
+	load_factor = 0;
+	// fixed width codes by default
+	options.variable = false;
+	// fixed reset policy by default
+	options.adaptive = false;
+	options.lru = false;
+	reset_threshold = 0;
+	// no standby dictionary by default
+	standby = 0;
+	// no checksum by default
+	options.checksum = false;
+	// the codec thread reads and writes the files by default
+	options.pipeline = false;
+	// the compressor's hash table is probed linearly by default
+	options.table = DICTIONARY_LINEAR;
+	// no seek index by default, and the whole data is decompressed
+	options.index = false;
+	range_flag = false;
+	range_start = range_len = 0;
+	// an empty dictionary by default
+	preset_path = NULL;
+
+	// the statistics are printed as text, with the other messages
+	json_stats = false;
+	messages = stdout;
 
 	// initialization of input and output filename
 	input = output = NULL;
 	
 	// analyzing the arguments
-	while ((arg = getopt(argc, argv, "b:cdi:o:s:")) != -1) {
+	while ((arg = getopt_long(argc, argv, "aAb:B:cdD:ei:j:kl:M:o:pr:s:tvw:", long_options, NULL)) != -1) {
 		switch (arg) {
 			
 			// number of bits used for encoding
@@ -68,14 +133,112 @@ int main(int argc, char** argv)
 				if (optarg != NULL){
 					long int dict_size_tmp;
 					dict_size_tmp = strtol(optarg, NULL, 10);
-					if (dict_size_tmp == 0L || dict_size_tmp > UINT32_MAX) {
-						fprintf(stderr, "Bad dictionary size\n");
+					if (dict_size_tmp < MIN_DICT_SIZE || dict_size_tmp > MAX_DICT_SIZE) {
+						fprintf(stderr, "Bad dictionary size. It has to be from %d to %d\n", MIN_DICT_SIZE, MAX_DICT_SIZE);
 						return -1;
 					}
 					dict_size = dict_size_tmp;
 				}
 				break;
 				
+			// number of worker threads
+			case 'j':
+				if (optarg != NULL) {
+					long int threads_tmp;
+					threads_tmp = strtol(optarg, NULL, 10);
+					if (threads_tmp <= 0L || threads_tmp > 1024) {
+						fprintf(stderr, "Bad threads number\n");
+						return -1;
+					}
+					threads = threads_tmp;
+				}
+				break;
+				
+			// block size (in KiB) of the container format
+			case 'B':
+				if (optarg != NULL) {
+					long int block_size_tmp;
+					block_size_tmp = strtol(optarg, NULL, 10);
+					if (block_size_tmp <= 0L || block_size_tmp > (1L << 21)) {
+						fprintf(stderr, "Bad block size\n");
+						return -1;
+					}
+					block_size = block_size_tmp * 1024;
+				}
+				break;
+				
+			// maximum percentage of used entries of the compressor's dictionary
+			case 'l':
+				if (optarg != NULL) {
+					long int load_factor_tmp;
+					load_factor_tmp = strtol(optarg, NULL, 10);
+					if (load_factor_tmp < DICTIONARY_MIN_LOAD_FACTOR || load_factor_tmp > DICTIONARY_MAX_LOAD_FACTOR) {
+						fprintf(stderr, "Bad load factor\n");
+						return -1;
+					}
+					load_factor = load_factor_tmp;
+				}
+				break;
+				
+			// size (in KiB) of the input and output buffers
+			case 'M':
+				if (optarg != NULL) {
+					long int buffer_size_tmp;
+					buffer_size_tmp = strtol(optarg, NULL, 10);
+					if (buffer_size_tmp <= 0L || buffer_size_tmp > (BIT_MAX_BUFFER_SIZE / 1024)) {
+						fprintf(stderr, "Bad buffer size\n");
+						return -1;
+					}
+					buffer_size = buffer_size_tmp * 1024;
+				}
+				break;
+				
+			// adaptive reset policy
+			case 'a':
+				options.adaptive = true;
+				break;
+				
+			// loss (in percent) of the compression ratio which clears the dictionary
+			case 'r':
+				if (optarg != NULL) {
+					long int reset_threshold_tmp;
+					reset_threshold_tmp = strtol(optarg, NULL, 10);
+					if (reset_threshold_tmp <= 0L || reset_threshold_tmp >= 100L) {
+						fprintf(stderr, "Bad reset threshold\n");
+						return -1;
+					}
+					reset_threshold = reset_threshold_tmp;
+				}
+				break;
+				
+			// archive of the files of a directory or of a list
+			case 'A':
+				archive_flag = true;
+				break;
+				
+			// LRU replacement policy
+			case 'e':
+				options.lru = true;
+				break;
+				
+			// fill percentage of the dictionary from which the standby one is populated
+			case 'w':
+				if (optarg != NULL) {
+					long int standby_tmp;
+					standby_tmp = strtol(optarg, NULL, 10);
+					if (standby_tmp <= 0L || standby_tmp >= 100L) {
+						fprintf(stderr, "Bad standby fill percentage\n");
+						return -1;
+					}
+					standby = standby_tmp;
+				}
+				break;
+				
+			// codes as wide as needed by the dictionary
+			case 'v':
+				options.variable = true;
+				break;
+				
 			// case of compression
 			case 'c':
 				compression_flag = true;
@@ -85,6 +248,64 @@ int main(int argc, char** argv)
 			case 'd':
 				compression_flag = false;
 				break;
+				
+			// test mode: the input is decompressed and verified, nothing is written
+			case 't':
+				compression_flag = false;
+				test_flag = true;
+				break;
+				
+			// CRC32C of the uncompressed data after every stream
+			case 'k':
+				options.checksum = true;
+				break;
+				
+			// reading, coding and writing in three threads
+			case 'p':
+				options.pipeline = true;
+				break;
+				
+			// layout of the compressor's hash table
+			case 'T':
+				if (strcmp(optarg, "linear") == 0)
+					options.table = DICTIONARY_LINEAR;
+				else if (strcmp(optarg, "buckets") == 0)
+					options.table = DICTIONARY_BUCKETS;
+				else if (strcmp(optarg, "robinhood") == 0)
+					options.table = DICTIONARY_ROBIN_HOOD;
+				else {
+					fprintf(stderr, "Bad table layout\n");
+					return -1;
+				}
+				break;
+				
+			// seek index after the stream
+			case 'I':
+				options.index = true;
+				break;
+				
+			// range of the uncompressed data to be decompressed, as start:len
+			case 'R':
+				errno = 0;
+				range_start = strtoull(optarg, &range_end, 10);
+				if (range_end == optarg || *range_end != ':' || optarg[0] == '-' || range_end[1] == '-') {
+					fprintf(stderr, "Bad range\n");
+					return -1;
+				}
+				optarg = range_end + 1;
+				range_len = strtoull(optarg, &range_end, 10);
+				if (errno != 0 || range_end == optarg || *range_end != '\0') {
+					fprintf(stderr, "Bad range\n");
+					return -1;
+				}
+				compression_flag = false;
+				range_flag = true;
+				break;
+				
+			// preset dictionary file
+			case 'D':
+				preset_path = optarg;
+				break;
 			
 			// input file 
 			case 'i':
@@ -95,80 +316,244 @@ int main(int argc, char** argv)
 			case 'o':
 				output = optarg;
 				break;
+			
+			// format of the statistics: the JSON object is the only output on stdout, the messages go to stderr
+			case 'S':
+				if (strcmp(optarg, "json") == 0) {
+					json_stats = true;
+					messages = stderr;
+				}
+				else if (strcmp(optarg, "text") == 0) {
+					json_stats = false;
+					messages = stdout;
+				}
+				else {
+					fprintf(stderr, "Bad statistics format\n");
+					return -1;
+				}
+				break;
 
 			default:
 				break;
 		}
 	}
 	
-	// check that if no input file specified, if it's the case an error occurs
-	if (input == NULL) {
-		fprintf(stderr, "Missing input file\n");
-		return -1;
-	}
+	// without files, the data is read from the standard input and written on the standard output ("-" selects them too)
+	if (input == NULL)
+		input = "-";
+	if (output == NULL)
+		output = "-";
 	
-	// check that if no output file specified, if it's the case a default name is assigned
-	if (output == NULL) {
-		fprintf(stdout, "Missing output file. Default file will be used\n");
-		if (compression_flag == true) {
-			output = "./compressed";
-		}
-		else {
-			output = "./decompressed";
+	// the test mode discards the decompressed data, the standard output is free
+	if (test_flag == true)
+		output = NULL;
+	
+	// the standard output carries the data: the messages and the statistics go to the standard error
+	stats_out = stdout;
+	if (output != NULL && strcmp(output, "-") == 0) {
+		messages = stderr;
+		stats_out = stderr;
+		
+		if (compression_flag == true && isatty(STDOUT_FILENO)) {
+			fprintf(stderr, "Compressed data can't be written on a terminal\n");
+			return -1;
 		}
 	}
 	
 	// if not '-b' nor the number of bits are specified, we use a default value
 	if (bits == 0) {
-		fprintf(stdout, "Missing bits number. Default value (12) will be used\n");
+		fprintf(messages, "Missing bits number. Default value (12) will be used\n");
 		bits = 12;
 	}
-	// check that 9 <= BITS <= 15
-	else if (bits > 15) {
-		fprintf(stderr, "Too much bits specified. Max bits number is 15\n");
+	// check that MIN_BITS <= BITS <= MAX_BITS
+	else if (bits > MAX_BITS) {
+		fprintf(stderr, "Too much bits specified. Max bits number is %d\n", MAX_BITS);
 		return -1;
 	}
-	else if (bits < 9) {
-		fprintf(stderr, "Too few bits specified. Min bits number is 9\n");
+	else if (bits < MIN_BITS) {
+		fprintf(stderr, "Too few bits specified. Min bits number is %d\n", MIN_BITS);
 		return -1;
 	}
 	
 	// checking table size
 	if (dict_size == 0){
 		dict_size = (1 << bits);
-		fprintf(stdout, "Missing dictionary size. Default value (%d) will be used\n", dict_size);
+		fprintf(messages, "Missing dictionary size. Default value (%d) will be used\n", dict_size);
+	}
+	
+	// the LRU replacement never resets the dictionary
+	if (options.adaptive == true && options.lru == true) {
+		fprintf(stderr, "The adaptive reset policy and the LRU replacement are exclusive\n");
+		return -1;
+	}
+	
+	// the recency list needs every entry in its slot, while the other tables can drop or move them
+	if (options.table != DICTIONARY_LINEAR && options.lru == true) {
+		fprintf(stderr, "Only the linear table can be used with the LRU replacement\n");
+		return -1;
+	}
+	
+	// the standby dictionary replaces the reset
+	if (standby > 0 && (options.adaptive == true || options.lru == true)) {
+		fprintf(stderr, "The standby dictionary can't be used with the adaptive reset policy or the LRU replacement\n");
+		return -1;
+	}
+	
+	// the seek index belongs to a single stream, and a range is taken from it
+	if (options.index == true && (compression_flag == false || archive_flag == true || threads > 0 || block_size > 0)) {
+		fprintf(stderr, "The seek index is written only by the compression of a single stream\n");
+		return -1;
+	}
+	if (range_flag == true && (archive_flag == true || test_flag == true)) {
+		fprintf(stderr, "A range can't be decompressed from an archive or in test mode\n");
+		return -1;
+	}
+	
+	// the pipelined mode is for a single stream, the block container and the archives having their own threads
+	if (options.pipeline == true && (archive_flag == true || threads > 0 || block_size > 0 || range_flag == true)) {
+		fprintf(stderr, "The pipelined mode is used only for a single stream\n");
+		return -1;
+	}
+	
+	// a block size selects the container format, which is compressed by at least one worker thread
+	if (block_size > 0 && threads == 0)
+		threads = 1;
+	
+	options.bits = bits;
+	options.dict_size = dict_size;
+	options.threads = threads;
+	options.block_size = block_size;
+	options.buffer_size = buffer_size;
+	options.load_factor = load_factor;
+	options.reset_threshold = reset_threshold;
+	options.standby = standby;
+	options.preset = NULL;
+	
+	// the preset dictionary has to fit the dictionary of the compressor, and the standby dictionary starts without it
+	if (preset_path != NULL) {
+		if (standby > 0) {
+			fprintf(stderr, "The preset dictionary can't be used with the standby dictionary\n");
+			return -1;
+		}
+		options.preset = preset_load(preset_path);
+		if (options.preset == NULL) {
+			fprintf(stderr, "Bad preset dictionary\n");
+			return -1;
+		}
+		if (compression_flag == true && options.preset->count > preset_capacity(&options)) {
+			fprintf(stderr, "The preset dictionary has too many entries for these parameters (at most %u)\n", preset_capacity(&options));
+			preset_free(options.preset);
+			return -1;
+		}
 	}
 	
 	// case of compression
 	if (compression_flag == true) {
-		printf ("Starting compression: symbols %d bits - dictionary size %d bytes\n", bits, dict_size);
-		start = clock();
-		ret = compress (input, output, bits, dict_size);
-		end = clock();
+		fprintf (messages, "Starting compression: symbols %d bits - dictionary size %d bytes\n", bits, dict_size);
+		if (archive_flag == true)
+			fprintf (messages, "Archive: %d threads\n", (threads > 0)?(threads):(thread_pool_default_size()));
+		else if (threads > 0)
+			fprintf (messages, "Block container: %d threads - block size %d bytes\n", threads, (block_size > 0)?(block_size):(DEFAULT_BLOCK_SIZE));
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		if (archive_flag == true)
+			ret = archive_compress (input, output, &options, &stats);
+		else
+			ret = compress (input, output, &options, &stats);
+		clock_gettime(CLOCK_MONOTONIC, &end);
 		
-		// computation time
-		diff = ((double)(end-start)/CLOCKS_PER_SEC);
+		// computation time, as wall time: the block container and the segments are processed by several threads
+		diff = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
 		if	(ret == -1)
-			printf ("Ops: error during compression\n");
+			fprintf (messages, "Ops: error during compression\n");
 		else
-			printf ("Compressed in %f s\n", diff);
+			fprintf (messages, "Compressed in %f s\n", diff);
 
-		printf ("\nTotal collisions %d\nTotal Lookup %d\nAverage collisions %f\n", COLLISIONS, LOOKUP_COUNT, ((double)COLLISIONS/(double)LOOKUP_COUNT));
+		if (json_stats == true)
+			print_stats_json(stats_out, true, ret, diff, &stats);
+#ifndef LZ78_NO_STATS
+		// the counters are printed only when they are compiled in, and the averages only when there is something to average
+		// (the probe length of a lookup is its number of collisions, as in the JSON statistics)
+		else {
+			fprintf (messages, "\nTotal collisions %" PRIu64 "\nTotal Lookup %" PRIu64 "\n", stats.collisions, stats.lookups);
+			if (stats.lookups > 0) {
+				fprintf (messages, "Average collisions %f\n", (double)stats.collisions / (double)stats.lookups);
+				fprintf (messages, "Direct lookups %" PRIu64 " (%.1f%%)\nHashed lookups %" PRIu64 " (%.1f%%)\n",
+						stats.direct_lookups, 100.0 * (double)stats.direct_lookups / (double)stats.lookups,
+						stats.lookups - stats.direct_lookups, 100.0 * (double)(stats.lookups - stats.direct_lookups) / (double)stats.lookups);
+			}
+			if (stats.lookups > stats.direct_lookups)
+				fprintf (messages, "Average probe length %f\n", (double)stats.collisions / (double)(stats.lookups - stats.direct_lookups));
+			fprintf (messages, "Max probe length %" PRIu64 "\n", stats.max_probe);
+			fprintf (messages, "Dictionary resets %" PRIu64 "\n", stats.resets);
+		}
+#endif
 	}
 	// case of decompression
 	else {
-		printf ("Starting decompression: %d bits symbols - %d bytes dictionary size\n", bits, dict_size);
-		start = clock();
-		ret = decompress (input, output, bits, dict_size);
-		end = clock();
+		fprintf (messages, "Starting decompression: %d bits symbols - %d bytes dictionary size\n", bits, dict_size);
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		if (range_flag == true)
+			ret = decompress_range (input, output, &options, range_start, range_len, &stats);
+		else
+			ret = decompress (input, output, &options, &stats);
+		clock_gettime(CLOCK_MONOTONIC, &end);
 		
-		// computation time
-		diff = ((double)(end-start)/CLOCKS_PER_SEC);
+		// computation time, as wall time: the block container and the segments are processed by several threads
+		diff = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
 		if	(ret == -1)
-			printf ("Ops: error during decompression\n");
+			fprintf (messages, "Ops: error during decompression\n");
+		else if (test_flag == true)
+			fprintf (messages, "Verified in %f s\n", diff);
 		else
-			printf ("Decompressed in %f s\n", diff);
+			fprintf (messages, "Decompressed in %f s\n", diff);
+		
+		if (json_stats == true)
+			print_stats_json(stats_out, false, ret, diff, &stats);
 	}
 	
+	preset_free(options.preset);
+	
 	return ret;
 }
+
+void print_stats_json (FILE* out, bool compression, int ret, double wall, LZ78_STATS* stats)
+{
+	static const char* buckets[PROBE_BUCKETS] = { "0", "1", "2", "3", "4-7", "8-15", "16-31", "32+" };
+	struct rusage usage;
+	uint64_t raw, packed;
+	int i;
+	
+	// the raw data is the input of a compression and the output of a decompression
+	raw = (compression == true)?(stats->bytes_in):(stats->bytes_out);
+	packed = (compression == true)?(stats->bytes_out):(stats->bytes_in);
+	
+	// the peak resident set of the whole process (in KiB on Linux)
+	memset(&usage, 0, sizeof(usage));
+	getrusage(RUSAGE_SELF, &usage);
+	
+	fprintf(out, "{\n");
+	fprintf(out, "  \"operation\": \"%s\",\n", (compression == true)?("compress"):("decompress"));
+	fprintf(out, "  \"status\": \"%s\",\n", (ret == 0)?("ok"):("error"));
+#ifdef LZ78_NO_STATS
+	fprintf(out, "  \"counters\": false,\n");
+#else
+	fprintf(out, "  \"counters\": true,\n");
+#endif
+	fprintf(out, "  \"bytes_in\": %" PRIu64 ",\n  \"bytes_out\": %" PRIu64 ",\n", stats->bytes_in, stats->bytes_out);
+	fprintf(out, "  \"ratio\": %.4f,\n", (packed > 0)?((double)raw / (double)packed):(0.0));
+	fprintf(out, "  \"codes\": %" PRIu64 ",\n", stats->codes);
+	fprintf(out, "  \"mean_phrase_length\": %.4f,\n", (stats->codes > 0)?((double)raw / (double)stats->codes):(0.0));
+	fprintf(out, "  \"resets\": {\"total\": %" PRIu64 ", \"full\": %" PRIu64 ", \"clear\": %" PRIu64 ", \"swap\": %" PRIu64 "},\n",
+			stats->resets, stats->resets_full, stats->resets_clear, stats->resets_swap);
+	fprintf(out, "  \"evictions\": %" PRIu64 ",\n", stats->evictions);
+	fprintf(out, "  \"lookups\": {\"total\": %" PRIu64 ", \"direct\": %" PRIu64 ", \"collisions\": %" PRIu64 ", \"max_probe\": %" PRIu64 "},\n",
+			stats->lookups, stats->direct_lookups, stats->collisions, stats->max_probe);
+	fprintf(out, "  \"probe_histogram\": {");
+	for (i = 0; i < PROBE_BUCKETS; i++)
+		fprintf(out, "%s\"%s\": %" PRIu64, (i > 0)?(", "):(""), buckets[i], stats->probes[i]);
+	fprintf(out, "},\n");
+	fprintf(out, "  \"time\": {\"wall\": %.6f, \"setup\": %.6f, \"codec\": %.6f},\n",
+			wall, (double)stats->setup_time / 1e9, (double)stats->codec_time / 1e9);
+	fprintf(out, "  \"memory\": {\"stream\": %" PRIu64 ", \"peak_rss\": %" PRIu64 "}\n", stats->memory, (uint64_t)usage.ru_maxrss * 1024);
+	fprintf(out, "}\n");
+}
@@ -0,0 +1,394 @@
+/*
+ * pipeline.c
+ * Francesco Piras - Dario Varano
+ * June 2015
+ */
+
+#include "pipeline.h"
+#include "header.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+#define PIPELINE_SPIN		1024				// checks of a counter before a waiting thread sleeps
+
+/**
+ * @brief The pipeline structure: the producer of the ring is the reader thread or the codec thread,
+ * 		the consumer is the codec thread or the writer thread
+ *
+ */
+typedef struct pipeline_struct {
+	int fd;						// the duplicated descriptor
+	bool writing;				// the thread writes the blocks to the file (it reads them from the file if false)
+	uint8_t* blocks;			// the blocks of the ring, one after the other
+	size_t block_size;			// size (in bytes) of every block
+	size_t lens[PIPELINE_BLOCKS];	// number of bytes of every filled block
+	uint64_t head;				// number of blocks filled by the producer (atomic)
+	uint64_t tail;				// number of blocks emptied by the consumer (atomic)
+	bool end;					// the producer has filled its last block (atomic)
+	bool stop;					// the codec thread has closed the pipeline of a reader thread (atomic)
+	bool failed;				// a write of the writer thread has failed, so the following blocks are discarded (atomic)
+	int status;					// the result of the reader thread (1 end of file, -1 error), set before end
+	int sleepers;				// number of threads sleeping on wake (atomic)
+	pthread_mutex_t lock;		// protects the sleep on wake
+	pthread_cond_t wake;		// signaled when a counter or a flag changes and a thread is sleeping
+	pthread_t thread;			// the reader or writer thread
+	bool holding;				// the codec thread holds the block at tail (reader thread only)
+	size_t pos;					// bytes taken from the held block, or put in the block at head (writer thread)
+} PIPELINE;
+
+/**
+ * @brief It allocates a pipeline and starts its thread
+ *
+ * @param fd the descriptor of the file, which is duplicated
+ * @param block_size the size (in bytes) of the blocks (0 selects PIPELINE_BLOCK)
+ * @param writing flag selecting a writer thread (a reader thread if false)
+ * @return PIPELINE* the pointer to the structure allocated in the dynamic memory, or NULL if an error occurs
+ */
+PIPELINE* pipeline_alloc (int fd, size_t block_size, bool writing);
+
+/**
+ * @brief It waits until a counter of the ring changes, or the producer has ended, or the pipeline is being closed:
+ * 		the counter is checked for a while before sleeping, since the other thread usually moves on quickly
+ *
+ * @param pipe the pointer to the pipeline
+ * @param counter the head or the tail of the ring
+ * @param seen the value of the counter already seen
+ * @return void
+ */
+void pipeline_wait (PIPELINE* pipe, uint64_t* counter, uint64_t seen);
+
+/**
+ * @brief It wakes the thread sleeping on the pipeline, if any, after a counter or a flag has changed
+ *
+ * @param pipe the pointer to the pipeline
+ * @return void
+ */
+void pipeline_wake (PIPELINE* pipe);
+
+/**
+ * @brief It hands the block at head, with the bytes put in it, to the writer thread
+ *
+ * @param pipe the pointer to the pipeline of a writer thread
+ * @return int a flag indicating if the block has been handed (0) or if the writer thread has failed (-1)
+ */
+int pipeline_push (PIPELINE* pipe);
+
+/**
+ * @brief The reader thread: it fills every free block with a read system call, until the end of the file
+ *
+ * @param arg the pointer to the pipeline
+ * @return void* NULL
+ */
+void* pipeline_read_thread (void* arg);
+
+/**
+ * @brief The writer thread: it writes every filled block, until the codec thread has filled its last one
+ *
+ * @param arg the pointer to the pipeline
+ * @return void* NULL
+ */
+void* pipeline_write_thread (void* arg);
+
+PIPELINE* pipeline_reader (int fd, size_t block_size)
+{
+	return pipeline_alloc(fd, block_size, false);
+}
+
+PIPELINE* pipeline_writer (int fd, size_t block_size)
+{
+	return pipeline_alloc(fd, block_size, true);
+}
+
+PIPELINE* pipeline_alloc (int fd, size_t block_size, bool writing)
+{
+	PIPELINE* pipe;
+
+	pipe = calloc(1, sizeof(PIPELINE));
+	if (pipe == NULL)
+		return NULL;
+
+	pipe->writing = writing;
+	pipe->block_size = (block_size > 0)?(block_size):(PIPELINE_BLOCK);
+	pipe->blocks = malloc(PIPELINE_BLOCKS * pipe->block_size);
+	pipe->fd = dup(fd);
+	if (pipe->blocks == NULL || pipe->fd < 0)
+		goto error;
+
+	pthread_mutex_init(&pipe->lock, NULL);
+	pthread_cond_init(&pipe->wake, NULL);
+	if (pthread_create(&pipe->thread, NULL, (writing == true)?(pipeline_write_thread):(pipeline_read_thread), pipe) != 0) {
+		pthread_cond_destroy(&pipe->wake);
+		pthread_mutex_destroy(&pipe->lock);
+		goto error;
+	}
+
+	return pipe;
+
+error:
+	if (pipe->fd >= 0)
+		close(pipe->fd);
+	free(pipe->blocks);
+	free(pipe);
+	return NULL;
+}
+
+void pipeline_wait (PIPELINE* pipe, uint64_t* counter, uint64_t seen)
+{
+	int i;
+
+	for (i = 0; i < PIPELINE_SPIN; i++)
+		if (__atomic_load_n(counter, __ATOMIC_ACQUIRE) != seen)
+			return;
+
+	// the sleeper is counted before the last check: a thread which changes the counter after it sees the count,
+	// as both are sequentially consistent, and then it signals the condition under the lock
+	__atomic_add_fetch(&pipe->sleepers, 1, __ATOMIC_SEQ_CST);
+	pthread_mutex_lock(&pipe->lock);
+	while (__atomic_load_n(counter, __ATOMIC_SEQ_CST) == seen && __atomic_load_n(&pipe->end, __ATOMIC_SEQ_CST) == false &&
+			__atomic_load_n(&pipe->stop, __ATOMIC_SEQ_CST) == false)
+		pthread_cond_wait(&pipe->wake, &pipe->lock);
+	pthread_mutex_unlock(&pipe->lock);
+	__atomic_sub_fetch(&pipe->sleepers, 1, __ATOMIC_SEQ_CST);
+}
+
+void pipeline_wake (PIPELINE* pipe)
+{
+	if (__atomic_load_n(&pipe->sleepers, __ATOMIC_SEQ_CST) == 0)
+		return;
+
+	pthread_mutex_lock(&pipe->lock);
+	pthread_cond_broadcast(&pipe->wake);
+	pthread_mutex_unlock(&pipe->lock);
+}
+
+void* pipeline_read_thread (void* arg)
+{
+	PIPELINE* pipe;
+	uint64_t head, tail;
+	ssize_t result;
+
+	pipe = arg;
+	pipe->status = 1;
+
+	// the thread can be cancelled only while it waits for the data of a pipe
+	pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+
+	for (head = 0; ; head++) {
+		// waiting for the codec thread to give a block back
+		while ((tail = __atomic_load_n(&pipe->tail, __ATOMIC_ACQUIRE)) + PIPELINE_BLOCKS == head &&
+				__atomic_load_n(&pipe->stop, __ATOMIC_ACQUIRE) == false)
+			pipeline_wait(pipe, &pipe->tail, tail);
+		if (__atomic_load_n(&pipe->stop, __ATOMIC_ACQUIRE) == true)
+			break;
+
+		// a single read system call, as input_next does, so that the data of a pipe is coded as soon as it comes
+		do {
+			pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
+			result = read(pipe->fd, pipe->blocks + (head % PIPELINE_BLOCKS) * pipe->block_size, pipe->block_size);
+			pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+		} while (result < 0 && errno == EINTR);
+
+		if (result <= 0) {
+			pipe->status = (result < 0)?(-1):(1);
+			break;
+		}
+
+		pipe->lens[head % PIPELINE_BLOCKS] = (size_t)result;
+		__atomic_store_n(&pipe->head, head + 1, __ATOMIC_SEQ_CST);
+		pipeline_wake(pipe);
+	}
+
+	__atomic_store_n(&pipe->end, true, __ATOMIC_SEQ_CST);
+	pipeline_wake(pipe);
+
+	return NULL;
+}
+
+void* pipeline_write_thread (void* arg)
+{
+	PIPELINE* pipe;
+	uint64_t head, tail;
+
+	pipe = arg;
+
+	for (tail = 0; ; tail++) {
+		// waiting for the codec thread to fill a block, the end being checked before the head it follows
+		while ((head = __atomic_load_n(&pipe->head, __ATOMIC_ACQUIRE)) == tail) {
+			if (__atomic_load_n(&pipe->end, __ATOMIC_ACQUIRE) == true) {
+				if (__atomic_load_n(&pipe->head, __ATOMIC_ACQUIRE) == tail)
+					return NULL;
+				continue;
+			}
+			pipeline_wait(pipe, &pipe->head, tail);
+		}
+
+		// after an error the blocks are still emptied, so that the codec thread never waits for them
+		if (__atomic_load_n(&pipe->failed, __ATOMIC_RELAXED) == false &&
+			write_full(pipe->fd, pipe->blocks + (tail % PIPELINE_BLOCKS) * pipe->block_size, pipe->lens[tail % PIPELINE_BLOCKS]) < 0)
+			__atomic_store_n(&pipe->failed, true, __ATOMIC_SEQ_CST);
+
+		__atomic_store_n(&pipe->tail, tail + 1, __ATOMIC_SEQ_CST);
+		pipeline_wake(pipe);
+	}
+}
+
+int pipeline_next (PIPELINE* pipe, const uint8_t** data, size_t* len)
+{
+	uint64_t tail;
+
+	*data = NULL;
+	*len = 0;
+
+	// the block returned by the previous call goes back to the reader thread
+	tail = __atomic_load_n(&pipe->tail, __ATOMIC_RELAXED);
+	if (pipe->holding == true) {
+		pipe->holding = false;
+		__atomic_store_n(&pipe->tail, ++tail, __ATOMIC_SEQ_CST);
+		pipeline_wake(pipe);
+	}
+
+	// waiting for the reader thread to fill a block, the end being checked before the head it follows
+	while (__atomic_load_n(&pipe->head, __ATOMIC_ACQUIRE) == tail) {
+		if (__atomic_load_n(&pipe->end, __ATOMIC_ACQUIRE) == true) {
+			if (__atomic_load_n(&pipe->head, __ATOMIC_ACQUIRE) == tail)
+				return pipe->status;
+			continue;
+		}
+		pipeline_wait(pipe, &pipe->head, tail);
+	}
+
+	*data = pipe->blocks + (tail % PIPELINE_BLOCKS) * pipe->block_size;
+	*len = pipe->lens[tail % PIPELINE_BLOCKS];
+	pipe->holding = true;
+	pipe->pos = 0;
+
+	return 0;
+}
+
+ssize_t pipeline_fill (void* arg, void* data, size_t len)
+{
+	PIPELINE* pipe;
+	const uint8_t* block;
+	size_t size;
+	int ret;
+
+	pipe = arg;
+
+	// the held block is emptied before the next one is taken
+	while (pipe->holding == false || pipe->pos == pipe->lens[pipe->tail % PIPELINE_BLOCKS]) {
+		ret = pipeline_next(pipe, &block, &size);
+		if (ret != 0)
+			return (ret == 1)?(0):(-1);
+	}
+
+	size = pipe->lens[pipe->tail % PIPELINE_BLOCKS] - pipe->pos;
+	if (len > size)
+		len = size;
+	memcpy(data, pipe->blocks + (pipe->tail % PIPELINE_BLOCKS) * pipe->block_size + pipe->pos, len);
+	pipe->pos += len;
+
+	return (ssize_t)len;
+}
+
+int pipeline_buffer (PIPELINE* pipe, uint8_t** data, size_t* size)
+{
+	uint64_t head, tail;
+
+	// waiting for the writer thread to empty a block
+	head = __atomic_load_n(&pipe->head, __ATOMIC_RELAXED);
+	while ((tail = __atomic_load_n(&pipe->tail, __ATOMIC_ACQUIRE)) + PIPELINE_BLOCKS == head)
+		pipeline_wait(pipe, &pipe->tail, tail);
+
+	if (__atomic_load_n(&pipe->failed, __ATOMIC_ACQUIRE) == true)
+		return -1;
+
+	*data = pipe->blocks + (head % PIPELINE_BLOCKS) * pipe->block_size + pipe->pos;
+	*size = pipe->block_size - pipe->pos;
+
+	return 0;
+}
+
+int pipeline_commit (PIPELINE* pipe, size_t len)
+{
+	pipe->pos += len;
+	if (pipe->pos < pipe->block_size)
+		return 0;
+
+	return pipeline_push(pipe);
+}
+
+int pipeline_push (PIPELINE* pipe)
+{
+	uint64_t head;
+
+	head = __atomic_load_n(&pipe->head, __ATOMIC_RELAXED);
+	pipe->lens[head % PIPELINE_BLOCKS] = pipe->pos;
+	pipe->pos = 0;
+	__atomic_store_n(&pipe->head, head + 1, __ATOMIC_SEQ_CST);
+	pipeline_wake(pipe);
+
+	return (__atomic_load_n(&pipe->failed, __ATOMIC_ACQUIRE) == true)?(-1):(0);
+}
+
+ssize_t pipeline_drain (void* arg, void* data, size_t len)
+{
+	PIPELINE* pipe;
+	uint8_t* block;
+	size_t size, done;
+
+	pipe = arg;
+
+	for (done = 0; done < len; done += size) {
+		if (pipeline_buffer(pipe, &block, &size) < 0)
+			return -1;
+		if (size > len - done)
+			size = len - done;
+		memcpy(block, (uint8_t*)data + done, size);
+		if (pipeline_commit(pipe, size) < 0)
+			return -1;
+	}
+
+	return (ssize_t)len;
+}
+
+int pipeline_close (PIPELINE* pipe)
+{
+	int ret;
+
+	if (pipe == NULL)
+		return -1;
+
+	ret = 0;
+
+	// the writer thread writes the last block, even if it is not full, and then it ends
+	if (pipe->writing == true) {
+		if (pipe->pos > 0)
+			pipeline_push(pipe);
+		__atomic_store_n(&pipe->end, true, __ATOMIC_SEQ_CST);
+		pipeline_wake(pipe);
+		pthread_join(pipe->thread, NULL);
+		if (pipe->failed == true)
+			ret = -1;
+	}
+	// the reader thread stops at its next block, or at once if it is waiting for the data of a pipe
+	else {
+		__atomic_store_n(&pipe->stop, true, __ATOMIC_SEQ_CST);
+		pipeline_wake(pipe);
+		pthread_cancel(pipe->thread);
+		pthread_join(pipe->thread, NULL);
+	}
+
+	// the errors of a file on a network file system can be reported when it is closed
+	if (close(pipe->fd) < 0)
+		ret = -1;
+
+	pthread_cond_destroy(&pipe->wake);
+	pthread_mutex_destroy(&pipe->lock);
+	free(pipe->blocks);
+	free(pipe);
+
+	return ret;
+}
@@ -0,0 +1,118 @@
+/*
+ * pipeline.h
+ * Francesco Piras - Dario Varano
+ * June 2015
+ */
+
+#ifndef _PIPELINE_H
+#define _PIPELINE_H
+
+#include "definitions.h"
+
+#include <sys/types.h>
+
+#define PIPELINE_BLOCK		(1024 * 1024)		// default size (in bytes) of the blocks of a pipeline
+#define PIPELINE_BLOCKS		4					// number of blocks of the ring of a pipeline
+
+/**
+ * NOTE ON THE PIPELINED MODE
+ *
+ * In the pipelined mode a single stream is compressed or decompressed by three threads: a reader thread fills the
+ * blocks of a ring with the input file, the calling thread (the codec) encodes or decodes them into the blocks of a
+ * second ring, and a writer thread writes those to the output file. Every ring has a single producer and a single
+ * consumer, which only publish the number of blocks they have filled or emptied (by atomic stores), so no lock is taken
+ * while the rings are neither empty nor full; a thread which has to wait spins for a while and then sleeps on a
+ * condition variable, which the other thread signals only when it knows it is sleeping.
+ *
+ * 			reader thread						codec thread						writer thread
+ * 		read() --> [ ring of input blocks ] --> lz78 --> [ ring of output blocks ] --> write()
+ *
+ * The codec sees the same bytes, in the same order, as with direct reads and writes, so the output is the same.
+ */
+
+/**
+ * @brief A ring of blocks between a thread doing I/O on a file descriptor and the calling thread
+ *
+ */
+typedef struct pipeline_struct PIPELINE;
+
+/**
+ * @brief It starts a reader thread, which reads a file by blocks from its current position into the ring
+ *
+ * @param fd the descriptor of the file, which is duplicated (so that the caller can close its own one)
+ * @param block_size the size (in bytes) of the blocks (0 selects PIPELINE_BLOCK)
+ * @return PIPELINE* the pointer to the structure allocated in the dynamic memory, or NULL if an error occurs
+ */
+PIPELINE* pipeline_reader (int fd, size_t block_size);
+
+/**
+ * @brief It starts a writer thread, which writes the blocks of the ring to a file from its current position
+ *
+ * @param fd the descriptor of the file, which is duplicated (so that the caller can close its own one)
+ * @param block_size the size (in bytes) of the blocks (0 selects PIPELINE_BLOCK)
+ * @return PIPELINE* the pointer to the structure allocated in the dynamic memory, or NULL if an error occurs
+ */
+PIPELINE* pipeline_writer (int fd, size_t block_size);
+
+/**
+ * @brief It returns the next block read by the reader thread: the block is valid until the next call,
+ * 		which gives it back to the reader thread, or until the pipeline is closed
+ *
+ * @param pipe the pointer to the pipeline of a reader thread
+ * @param data the pointer to be set to the first byte of the block
+ * @param len the pointer to be set to the size (in bytes) of the block
+ * @return int a flag indicating if a block has been returned (0), if the end of the file has been reached (1) or if an error occurs (-1)
+ */
+int pipeline_next (PIPELINE* pipe, const uint8_t** data, size_t* len);
+
+/**
+ * @brief It copies the next bytes read by the reader thread (the reading function of a bit file, see bit_set_io)
+ *
+ * @param pipe the pointer to the pipeline of a reader thread
+ * @param data the destination area
+ * @param len the size (in bytes) of the destination area
+ * @return ssize_t the number of bytes copied (0 at the end of the file), or -1 if an error occurs
+ */
+ssize_t pipeline_fill (void* pipe, void* data, size_t len);
+
+/**
+ * @brief It returns the free part of the block being filled for the writer thread, waiting for a free block if needed
+ *
+ * @param pipe the pointer to the pipeline of a writer thread
+ * @param data the pointer to be set to the first free byte of the block
+ * @param size the pointer to be set to the number of free bytes of the block (at least 1)
+ * @return int a flag indicating if the free area has been returned (0) or if the writer thread has failed (-1)
+ */
+int pipeline_buffer (PIPELINE* pipe, uint8_t** data, size_t* size);
+
+/**
+ * @brief It adds the first bytes of the free area returned by pipeline_buffer to the block, which is handed to
+ * 		the writer thread once it is full
+ *
+ * @param pipe the pointer to the pipeline of a writer thread
+ * @param len the number of bytes written in the free area
+ * @return int a flag indicating if the bytes have been added (0) or if the writer thread has failed (-1)
+ */
+int pipeline_commit (PIPELINE* pipe, size_t len);
+
+/**
+ * @brief It copies bytes to the blocks of the writer thread (the writing function of a bit file, see bit_set_io)
+ *
+ * @param pipe the pointer to the pipeline of a writer thread
+ * @param data the bytes to be written
+ * @param len the number of bytes
+ * @return ssize_t the number of bytes copied (len), or -1 if the writer thread has failed
+ */
+ssize_t pipeline_drain (void* pipe, void* data, size_t len);
+
+/**
+ * @brief It stops the thread of a pipeline and deallocates it: the last block of a writer thread is written first,
+ * 		while a reader thread is stopped even if it is waiting for the data of a pipe
+ *
+ * @param pipe the pointer to the pipeline
+ * @return int a flag indicating if all the blocks have been written and the duplicated descriptor has been closed (0)
+ * 		or if an error occurs (-1)
+ */
+int pipeline_close (PIPELINE* pipe);
+
+#endif
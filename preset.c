@@ -0,0 +1,186 @@
+/*
+ * preset.c
+ * Francesco Piras - Dario Varano
+ * June 2015
+ */
+
+#include "preset.h"
+#include "checksum.h"
+#include "dictionary.h"
+#include "lz78.h"
+
+#include <string.h>
+#include <unistd.h>
+
+static const uint8_t preset_magic[4] = { 'L', '7', '8', 'D' };
+
+/**
+ * @brief It reads a 32 bits little endian value
+ *
+ * @param buf the source area
+ * @return uint32_t the value
+ */
+uint32_t preset_get32 (const uint8_t* buf);
+
+/**
+ * @brief It writes a 32 bits little endian value
+ *
+ * @param buf the destination area
+ * @param value the value
+ * @return void
+ */
+void preset_put32 (uint8_t* buf, uint32_t value);
+
+PRESET* preset_load (char* path)
+{
+	PRESET* preset;
+	FILE* fp;
+	uint8_t header[PRESET_HEADER_SIZE];
+	uint8_t* entries;
+	size_t size;
+	CODE i;
+
+	fp = fopen(path, "rb");
+	if (fp == NULL)
+		return NULL;
+
+	preset = calloc(1, sizeof(PRESET));
+	entries = NULL;
+	if (preset == NULL)
+		goto error;
+	preset->image_fd = -1;
+
+	// checking the header
+	if (fread(header, 1, PRESET_HEADER_SIZE, fp) != PRESET_HEADER_SIZE || memcmp(header, preset_magic, sizeof(preset_magic)) != 0 ||
+		header[4] < 1 || header[4] > PRESET_VERSION)
+		goto error;
+	preset->count = preset_get32(header + 8);
+	preset->id = preset_get32(header + 12);
+	if (preset->count == 0 || preset->count > ((CODE)1 << MAX_BITS))
+		goto error;
+
+	size = (size_t)preset->count * PRESET_ENTRY_SIZE;
+	entries = malloc(size);
+	preset->parents = malloc((size_t)preset->count * sizeof(CODE));
+	preset->symbols = malloc(preset->count);
+	if (entries == NULL || preset->parents == NULL || preset->symbols == NULL || fread(entries, 1, size, fp) != size)
+		goto error;
+
+	// the id covers the entries, and every entry extends a first symbol or a previous entry
+	if (crc32c(0, entries, size) != preset->id)
+		goto error;
+	for (i = 0; i < preset->count; i++) {
+		preset->parents[i] = preset_get32(entries + (size_t)i * PRESET_ENTRY_SIZE);
+		preset->symbols[i] = entries[(size_t)i * PRESET_ENTRY_SIZE + 4];
+		if (preset->parents[i] == EOS || preset->parents[i] >= FIRST_CODE + i)
+			goto error;
+	}
+
+	// the dictionary image is mapped by the compressors, from a descriptor which outlives the file
+	if (header[4] >= 2) {
+		preset->image_offset = (off_t)((PRESET_HEADER_SIZE + size + DICTIONARY_IMAGE_ALIGN - 1) / DICTIONARY_IMAGE_ALIGN) * DICTIONARY_IMAGE_ALIGN;
+		preset->image_fd = dup(fileno(fp));
+	}
+
+	free(entries);
+	fclose(fp);
+
+	return preset;
+
+error:
+	free(entries);
+	preset_free(preset);
+	fclose(fp);
+	return NULL;
+}
+
+int preset_save (char* path, CODE count, CODE* parents, uint8_t* symbols, OPTIONS* options)
+{
+	PRESET preset;
+	OPTIONS image_options;
+	FILE* fp;
+	uint8_t header[PRESET_HEADER_SIZE];
+	uint8_t* entries;
+	size_t size;
+	CODE i;
+	int ret;
+
+	size = (size_t)count * PRESET_ENTRY_SIZE;
+	entries = malloc(size);
+	if (entries == NULL)
+		return -1;
+
+	for (i = 0; i < count; i++) {
+		preset_put32(entries + (size_t)i * PRESET_ENTRY_SIZE, parents[i]);
+		entries[(size_t)i * PRESET_ENTRY_SIZE + 4] = symbols[i];
+	}
+
+	memset(header, 0, PRESET_HEADER_SIZE);
+	memcpy(header, preset_magic, sizeof(preset_magic));
+	header[4] = (options != NULL)?(PRESET_VERSION):(1);
+	preset_put32(header + 8, count);
+	preset_put32(header + 12, crc32c(0, entries, size));
+
+	ret = -1;
+	fp = fopen(path, "wb");
+	if (fp != NULL) {
+		if (fwrite(header, 1, PRESET_HEADER_SIZE, fp) == PRESET_HEADER_SIZE && fwrite(entries, 1, size, fp) == size)
+			ret = 0;
+
+		// the image is the dictionary of a compressor with these parameters, right after it loaded the entries
+		if (ret == 0 && options != NULL) {
+			memset(&preset, 0, sizeof(PRESET));
+			preset.count = count;
+			preset.parents = parents;
+			preset.symbols = symbols;
+			preset.image_fd = -1;
+			image_options = *options;
+			image_options.preset = &preset;
+			ret = lz78_image_save(&image_options, fp);
+		}
+		if (fclose(fp) != 0)
+			ret = -1;
+	}
+	free(entries);
+
+	return ret;
+}
+
+CODE preset_capacity (OPTIONS* options)
+{
+	CODE limit;
+
+	// the streams reset their dictionary after the maximum code or when half of dict_size is used
+	limit = ((CODE)1 << options->bits) - 1;
+	if (options->adaptive == true)
+		limit--;
+	if (limit > (CODE)options->dict_size / 2)
+		limit = options->dict_size / 2;
+
+	return (limit > FIRST_CODE)?((limit - FIRST_CODE) / 2):(0);
+}
+
+void preset_free (PRESET* preset)
+{
+	if (preset == NULL)
+		return;
+
+	free(preset->parents);
+	free(preset->symbols);
+	if (preset->image_fd >= 0)
+		close(preset->image_fd);
+	free(preset);
+}
+
+uint32_t preset_get32 (const uint8_t* buf)
+{
+	return (uint32_t)buf[0] | ((uint32_t)buf[1] << 8) | ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24);
+}
+
+void preset_put32 (uint8_t* buf, uint32_t value)
+{
+	buf[0] = value & 0xFF;
+	buf[1] = (value >> 8) & 0xFF;
+	buf[2] = (value >> 16) & 0xFF;
+	buf[3] = (value >> 24) & 0xFF;
+}
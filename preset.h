@@ -0,0 +1,94 @@
+/*
+ * preset.h
+ * Francesco Piras - Dario Varano
+ * June 2015
+ */
+
+#ifndef _PRESET_H
+#define _PRESET_H
+
+#include "definitions.h"
+
+#include <sys/types.h>
+
+/**
+ * NOTE ON THE PRESET DICTIONARY FILE
+ *
+ * A preset dictionary holds the entries which a stream finds in its dictionary at the start and after every reset,
+ * instead of an empty one. The entries take the codes from FIRST_CODE on, in the order of the file, and each one
+ * extends an entry which precedes it (or a first symbol), so that they form a subtree of the dictionary:
+ *
+ * 		byte	0 - 3				4			5 - 7	8 - 11		12 - 15		16 ...
+ * 			+-------------------+-----------+-------+-----------+-----------+-------------------+
+ * 			| 'L' '7' '8' 'D'	|  version	|	0	|	count	|	 id		| count entries		|
+ * 			+-------------------+-----------+-------+-----------+-----------+-------------------+
+ *
+ * 		entry:		+-----------+-----------+
+ * 					|	parent	|	symbol	|
+ * 					+-----------+-----------+
+ * 					   32 bits	   8 bits
+ *
+ * Multi-byte fields are little endian. The id is the CRC32C of the entries: a stream compressed with a preset
+ * dictionary stores it in its header, so that it is decompressed only with the same dictionary.
+ *
+ * From version 2 the entries are followed by the image of a compressor's dictionary holding them (see dictionary.h),
+ * at the next multiple of DICTIONARY_IMAGE_ALIGN: a compressor whose dictionary has the same size maps it, instead of
+ * inserting the entries after every reset. The image doesn't change the id, and the decompressor doesn't use it.
+ */
+
+#define PRESET_HEADER_SIZE	16			// size (in bytes) of the header of a preset dictionary file
+#define PRESET_ENTRY_SIZE	5			// size (in bytes) of an entry of a preset dictionary file
+#define PRESET_VERSION		2			// current version of the preset dictionary file (1 has no dictionary image)
+
+/**
+ * @brief A preset dictionary, shared read-only by any number of streams
+ *
+ */
+typedef struct preset_struct {
+	uint32_t id;				// CRC32C of the entries
+	CODE count;					// number of entries
+	CODE* parents;				// the parent of every entry (the entry i has the code FIRST_CODE + i)
+	uint8_t* symbols;			// the symbol of every entry
+	int image_fd;				// descriptor of the file, kept open when it holds a dictionary image, or -1
+	off_t image_offset;			// position of the dictionary image in the file
+} PRESET;
+
+/**
+ * @brief It reads a preset dictionary file, checking that every entry extends a previous one
+ *
+ * @param path the file name
+ * @return PRESET* pointer to the preset dictionary allocated in the dynamic memory, or NULL if an error occurs
+ */
+PRESET* preset_load (char* path);
+
+/**
+ * @brief It writes a preset dictionary file
+ *
+ * @param path the file name
+ * @param count the number of entries
+ * @param parents the parent of every entry, which has to precede it
+ * @param symbols the symbol of every entry
+ * @param options the parameters of the streams whose dictionary image follows the entries, or NULL to write
+ * 		only the entries (version 1)
+ * @return int a flag indicating if the file has been written (0) or if an error occurs (-1)
+ */
+int preset_save (char* path, CODE count, CODE* parents, uint8_t* symbols, OPTIONS* options);
+
+/**
+ * @brief It returns the maximum number of entries of a preset dictionary usable by the streams with some parameters:
+ * 		at most half of the codes available before a reset, so that the streams still learn from their data
+ *
+ * @param options the parameters of the streams
+ * @return CODE the maximum number of entries
+ */
+CODE preset_capacity (OPTIONS* options);
+
+/**
+ * @brief It releases a preset dictionary
+ *
+ * @param preset the pointer to the preset dictionary, or NULL
+ * @return void
+ */
+void preset_free (PRESET* preset);
+
+#endif
@@ -0,0 +1,128 @@
+/*
+ * seek.c
+ * Francesco Piras - Dario Varano
+ * June 2015
+ */
+
+#include "seek.h"
+#include "header.h"
+
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+static const uint8_t seek_magic[4] = { 'L', '7', '8', 'R' };
+
+int seek_write (BIT_FILE* bf, const LZ78_RESTART* restarts, size_t count, uint64_t raw_size)
+{
+	uint8_t trailer[SEEK_TRAILER_SIZE];
+	uint64_t data;
+	size_t i;
+	int pad;
+	
+	if (count > UINT32_MAX)
+		return -1;
+	
+	// the index starts at a byte boundary: the fields are then written as whole little endian bytes
+	data = 0;
+	pad = (int)((8 - bit_tell(bf) % 8) % 8);
+	if (pad > 0 && bit_write(bf, &data, pad) != 0)
+		return -1;
+	
+	for (i = 0; i < count; i++) {
+		data = restarts[i].offset;
+		if (bit_write(bf, &data, 64) != 0)
+			return -1;
+		data = restarts[i].bit_offset;
+		if (bit_write(bf, &data, 64) != 0)
+			return -1;
+		data = (uint64_t)restarts[i].width;
+		if (bit_write(bf, &data, 8) != 0)
+			return -1;
+	}
+	
+	memcpy(trailer, seek_magic, sizeof(seek_magic));
+	put_le32(trailer + 4, (uint32_t)count);
+	put_le64(trailer + 8, raw_size);
+	data = get_le64(trailer);
+	if (bit_write(bf, &data, 64) != 0)
+		return -1;
+	data = get_le64(trailer + 8);
+	
+	return (bit_write(bf, &data, 64) == 0)?(0):(-1);
+}
+
+int seek_read (int fd, LZ78_RESTART** restarts, size_t* count, uint64_t* raw_size)
+{
+	struct stat st;
+	uint8_t trailer[SEEK_TRAILER_SIZE];
+	uint8_t* entries;
+	LZ78_RESTART* list;
+	size_t size, i;
+	off_t start;
+	
+	*restarts = NULL;
+	*count = 0;
+	
+	// checking the trailer, at the end of the file
+	if (fstat(fd, &st) < 0 || S_ISREG(st.st_mode) == 0 || st.st_size < SEEK_TRAILER_SIZE ||
+		pread(fd, trailer, SEEK_TRAILER_SIZE, st.st_size - SEEK_TRAILER_SIZE) != SEEK_TRAILER_SIZE ||
+		memcmp(trailer, seek_magic, sizeof(seek_magic)) != 0)
+		return -1;
+	*count = get_le32(trailer + 4);
+	*raw_size = get_le64(trailer + 8);
+	
+	// the list precedes the trailer, and the first restart point is the beginning of the stream
+	size = *count * SEEK_ENTRY_SIZE;
+	if (*count == 0 || (uint64_t)size > (uint64_t)(st.st_size - SEEK_TRAILER_SIZE))
+		return -1;
+	start = st.st_size - SEEK_TRAILER_SIZE - (off_t)size;
+	
+	entries = malloc(size);
+	list = malloc(*count * sizeof(LZ78_RESTART));
+	if (entries == NULL || list == NULL || pread(fd, entries, size, start) != (ssize_t)size)
+		goto error;
+	
+	for (i = 0; i < *count; i++) {
+		list[i].offset = get_le64(entries + i * SEEK_ENTRY_SIZE);
+		list[i].bit_offset = get_le64(entries + i * SEEK_ENTRY_SIZE + 8);
+		list[i].width = entries[i * SEEK_ENTRY_SIZE + 16];
+		
+		// the codes of every restart point precede the index, and follow the ones of the previous restart point
+		if (list[i].width < MIN_BITS || list[i].width > MAX_BITS || list[i].offset > *raw_size ||
+			list[i].bit_offset >= (uint64_t)start * 8)
+			goto error;
+		if ((i == 0 && (list[i].offset != 0 || list[i].bit_offset != 0)) ||
+			(i > 0 && (list[i].offset < list[i - 1].offset || list[i].bit_offset <= list[i - 1].bit_offset)))
+			goto error;
+	}
+	
+	free(entries);
+	*restarts = list;
+	
+	return 0;
+	
+error:
+	free(entries);
+	free(list);
+	*count = 0;
+	return -1;
+}
+
+const LZ78_RESTART* seek_find (const LZ78_RESTART* restarts, size_t count, uint64_t offset)
+{
+	size_t low, high, middle;
+	
+	// binary search of the last restart point whose offset is not after the position
+	low = 0;
+	high = count;
+	while (high - low > 1) {
+		middle = low + (high - low) / 2;
+		if (restarts[middle].offset <= offset)
+			low = middle;
+		else
+			high = middle;
+	}
+	
+	return &restarts[low];
+}
@@ -0,0 +1,72 @@
+/*
+ * seek.h
+ * Francesco Piras - Dario Varano
+ * June 2015
+ */
+
+#ifndef _SEEK_H
+#define _SEEK_H
+
+#include "definitions.h"
+#include "bitio.h"
+#include "lz78.h"
+
+/**
+ * NOTE ON THE SEEK INDEX
+ *
+ * With HEADER_EXTRA_INDEX the single stream following the header is followed by the list of its restart points,
+ * the positions where the compressor emptied its dictionary (see lz78_restarts). The list starts at the first
+ * byte after the stream (after EOS and the checksum, padded with zeros), and it ends with a trailer, so that it
+ * is found from the end of the file:
+ *
+ * 		restart point:	+-----------+---------------+-------+
+ * 						|  offset	|  bit_offset	| width	|
+ * 						+-----------+---------------+-------+
+ * 						   64 bits		64 bits		  8 bits
+ *
+ * 		trailer:		+-------------------+-----------+-----------+
+ * 						| 'L' '7' '8' 'R'	|	count	|  raw_size	|
+ * 						+-------------------+-----------+-----------+
+ * 						     32 bits		   32 bits	   64 bits
+ *
+ * Multi-byte fields are little endian. The offset is the position of the uncompressed data, the bit offset the one
+ * of the first code after the reset (from the first code of the stream, which follows the header), and raw_size is
+ * the size of the uncompressed data. The decompressor stops at EOS, so the ones which don't know the index ignore it.
+ */
+
+#define SEEK_ENTRY_SIZE		17			// size (in bytes) of a restart point of the seek index
+#define SEEK_TRAILER_SIZE	16			// size (in bytes) of the trailer of the seek index
+
+/**
+ * @brief It writes the seek index of a stream, after its last code (and its checksum)
+ *
+ * @param bf the pointer to the output bit file of the stream
+ * @param restarts the restart points of the stream
+ * @param count the number of restart points
+ * @param raw_size the size (in bytes) of the uncompressed data
+ * @return int a flag indicating if the index has been written (0) or if an error occurs (-1)
+ */
+int seek_write (BIT_FILE* bf, const LZ78_RESTART* restarts, size_t count, uint64_t raw_size);
+
+/**
+ * @brief It reads the seek index at the end of a compressed file, checking that the restart points are in order
+ *
+ * @param fd the descriptor of the compressed file, which has to be a regular file (its position doesn't change)
+ * @param restarts the restart points, allocated in the dynamic memory (set by the function)
+ * @param count the number of restart points (set by the function)
+ * @param raw_size the size (in bytes) of the uncompressed data (set by the function)
+ * @return int a flag indicating if the index has been read (0) or if it is missing or corrupted (-1)
+ */
+int seek_read (int fd, LZ78_RESTART** restarts, size_t* count, uint64_t* raw_size);
+
+/**
+ * @brief It finds the last restart point which precedes a position of the uncompressed data
+ *
+ * @param restarts the restart points, in order
+ * @param count the number of restart points (at least one)
+ * @param offset the position (in bytes) of the uncompressed data
+ * @return const LZ78_RESTART* the restart point from which the position is decoded
+ */
+const LZ78_RESTART* seek_find (const LZ78_RESTART* restarts, size_t count, uint64_t offset);
+
+#endif
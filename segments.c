@@ -0,0 +1,254 @@
+/*
+ * segments.c
+ * Francesco Piras - Dario Varano
+ * June 2015
+ */
+
+#include "segments.h"
+#include "threadpool.h"
+#include "header.h"
+#include "bitio.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define SEGMENTS_PER_THREAD	4				// tasks of a batch for every worker thread
+#define SEGMENTS_MIN_CODES	(1 << 16)		// minimum number of codes of a task: short segments are decoded together
+#define SEGMENTS_CHUNK		(64 * 1024)		// initial size (in bytes) of the decoded data of a run, doubled when it is full
+
+/**
+ * @brief A run of consecutive segments of the stream and its decoded data
+ * 
+ */
+typedef struct segment_struct {
+	uint8_t* stream;			// the whole mapped stream
+	size_t stream_size;			// size (in bytes) of the stream
+	uint64_t offset;			// bit offset of the first code of the run
+	uint64_t codes;				// number of codes of the run
+	OPTIONS* options;			// parameters of the stream
+	uint8_t* data;				// decoded data
+	size_t data_size;			// number of decoded bytes
+	LZ78_STATS stats;			// statistics of the decoding
+	int result;					// outcome of the decoding (0 or -1)
+} SEGMENT;
+
+/**
+ * @brief The task decoding a run of segments
+ * 
+ * @param arg the pointer to the run
+ * @return void
+ */
+void segment_decompress_task (void* arg);
+
+/**
+ * @brief It checks that the code at the specified position is EOS
+ * 
+ * @param stream the mapped stream
+ * @param size the size (in bytes) of the stream
+ * @param offset the bit offset of the code
+ * @param bits the number of bits used for encoding
+ * @return bool true if the code is EOS
+ */
+bool segments_check_eos (uint8_t* stream, size_t size, uint64_t offset, int bits);
+
+int segments_decompress (int in, char* output, OPTIONS* options, LZ78_STATS* stats)
+{
+	struct stat info;
+	THREAD_POOL* pool;
+	SEGMENT* segments;
+	SEGMENT* current;
+	SEGMENT* next;
+	SEGMENT* tmp;
+	uint8_t* stream;
+	uint64_t total_codes, data_codes, length, first;
+	int out, i, batch, current_count, next_count;
+	
+	// only a regular file has a known size, and can be mapped
+	if (fstat(in, &info) < 0)
+		return -1;
+	if (S_ISREG(info.st_mode) == 0 || info.st_size == 0)
+		return 1;
+	
+	// every code is bits wide and the padding is shorter than a byte, so the number of codes is the number of whole codes
+	total_codes = ((uint64_t)info.st_size * 8) / options->bits;
+	if (total_codes == 0 || ((total_codes * options->bits) + 7) / 8 != (uint64_t)info.st_size)
+		return -1;
+	
+	// the last code is EOS
+	data_codes = total_codes - 1;
+	
+	// a task decodes whole segments, and at least SEGMENTS_MIN_CODES codes
+	length = segments_length(options->bits, options->dict_size);
+	length *= (SEGMENTS_MIN_CODES + length - 1) / length;
+	
+	if (stats != NULL)
+		memset(stats, 0, sizeof(LZ78_STATS));
+	
+	stream = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, in, 0);
+	if (stream == MAP_FAILED)
+		return -1;
+	
+	// checking that the stream has been produced with these parameters
+	if (segments_check_eos(stream, info.st_size, data_codes * options->bits, options->bits) == false) {
+		munmap(stream, info.st_size);
+		return -1;
+	}
+	
+	out = open_output(output);
+	if (out < 0) {
+		munmap(stream, info.st_size);
+		return -1;
+	}
+	
+	batch = options->threads * SEGMENTS_PER_THREAD;
+	segments = calloc(2 * batch, sizeof(SEGMENT));
+	pool = thread_pool_create(options->threads);
+	if (segments == NULL || pool == NULL)
+		goto error;
+	
+	for (i = 0; i < 2 * batch; i++) {
+		segments[i].stream = stream;
+		segments[i].stream_size = info.st_size;
+		segments[i].options = options;
+	}
+	
+	current = segments;
+	next = segments + batch;
+	current_count = 0;
+	first = 0;
+	
+	do {
+		// submitting the next batch of runs
+		thread_pool_wait(pool);
+		for (next_count = 0; next_count < batch && first < data_codes; next_count++) {
+			next[next_count].offset = first * options->bits;
+			next[next_count].codes = (data_codes - first < length)?(data_codes - first):(length);
+			first += next[next_count].codes;
+			if (thread_pool_submit(pool, segment_decompress_task, &next[next_count]) < 0) {
+				next_count++;
+				goto error;
+			}
+		}
+		
+		// writing the current batch, in order, while the worker threads decode the next one
+		for (i = 0; i < current_count; i++) {
+			if (current[i].result < 0)
+				goto error;
+			if (write_full(out, current[i].data, current[i].data_size) < 0)
+				goto error;
+			lz78_stats_add(stats, &current[i].stats);
+			free(current[i].data);
+			current[i].data = NULL;
+		}
+		
+		tmp = current;
+		current = next;
+		next = tmp;
+		current_count = next_count;
+		
+	} while (current_count > 0);
+	
+	thread_pool_destroy(pool);
+	free(segments);
+	munmap(stream, info.st_size);
+	
+	return (close(out) < 0)?(-1):(0);
+	
+error:
+	thread_pool_destroy(pool);
+	if (segments != NULL) {
+		for (i = 0; i < 2 * batch; i++)
+			free(segments[i].data);
+		free(segments);
+	}
+	munmap(stream, info.st_size);
+	close(out);
+	return -1;
+}
+
+uint64_t segments_length (int bits, int dict_size)
+{
+	uint64_t max_code, limit;
+	
+	max_code = (1 << bits) - 1;
+	limit = ((uint64_t)(dict_size / 2) < max_code)?(dict_size / 2):(max_code);
+	
+	// the reset happens after the code whose entry makes next_code (and the used entries) exceed the limit
+	return (limit > SYMBOLS - 1)?(limit - (SYMBOLS - 1)):(1);
+}
+
+void segment_decompress_task (void* arg)
+{
+	SEGMENT* segment;
+	BIT_FILE* input;
+	LZ78_STREAM* stream;
+	uint8_t* data;
+	size_t size, len;
+	int ret;
+	
+	segment = arg;
+	segment->result = -1;
+	segment->data = NULL;
+	segment->data_size = 0;
+	memset(&segment->stats, 0, sizeof(LZ78_STATS));
+	
+	input = bit_open_mem(segment->stream, segment->stream_size, "r");
+	if (input == NULL)
+		return;
+	
+	// the decoded data is collected in a growing memory buffer
+	size = SEGMENTS_CHUNK;
+	segment->data = malloc(size);
+	if (segment->data == NULL) {
+		bit_close(input);
+		return;
+	}
+	
+	// the run starts with a fresh dictionary, as after a reset, and the following resets happen as in a sequential decoding
+	stream = lz78_open(segment->options, input, false);
+	if (stream != NULL && bit_seek(input, segment->offset) == 0) {
+		lz78_decode_limit(stream, segment->codes);
+		do {
+			if (segment->data_size == size) {
+				data = realloc(segment->data, size * 2);
+				if (data == NULL) {
+					ret = LZ78_ERROR;
+					break;
+				}
+				segment->data = data;
+				size *= 2;
+			}
+			ret = lz78_decode(stream, segment->data + segment->data_size, size - segment->data_size, &len);
+			segment->data_size += len;
+		} while (ret == LZ78_OK);
+		
+		if (ret == LZ78_END)
+			segment->result = 0;
+		lz78_stats(stream, &segment->stats);
+	}
+	
+	lz78_free(stream);
+	bit_close(input);
+}
+
+bool segments_check_eos (uint8_t* stream, size_t size, uint64_t offset, int bits)
+{
+	BIT_FILE* bf;
+	uint64_t data;
+	int res;
+	
+	bf = bit_open_mem(stream, size, "r");
+	if (bf == NULL)
+		return false;
+	
+	res = -1;
+	if (bit_seek(bf, offset) == 0)
+		res = bit_read(bf, &data, bits);
+	
+	bit_close(bf);
+	
+	return (res == 2)?(true):(false);
+}
@@ -0,0 +1,48 @@
+/*
+ * segments.h
+ * Francesco Piras - Dario Varano
+ * June 2015
+ */
+
+#ifndef _SEGMENTS_H
+#define _SEGMENTS_H
+
+#include "definitions.h"
+#include "lz78.h"
+
+/**
+ * NOTE ON THE SEGMENTS OF A HEADERLESS STREAM
+ * 
+ * Every code of a headerless stream is exactly bits wide, and both the compressor and the decompressor reset the
+ * dictionary after a fixed number of codes: each code adds an entry, and the reset happens as soon as
+ * next_code > max_code or more than dict_size/2 entries are used. So the stream is a sequence of segments of
+ * 
+ * 		min(max_code, dict_size/2) - 256		codes
+ * 
+ * (at least 1), each one starting with an empty dictionary at bit offset (segment * codes * bits), and the
+ * number of codes follows from the file size, since the padding after EOS is shorter than a byte.
+ * Runs of consecutive segments are decoded in parallel, each one into its own memory buffer, and written in order.
+ */
+
+/**
+ * @brief It decompresses a headerless stream, whose parameters are in options, using options->threads worker threads
+ * 
+ * @param in the input file descriptor, placed at the beginning of the file
+ * @param output the output file name, or NULL to discard the decoded data
+ * @param options the decompression parameters
+ * @param stats the pointer to the structure filled with the statistics of all the segments, or NULL
+ * @return int a flag indicating if the decompression operation has been completed successfully (0),
+ * 		if the input is not a regular file so that it has to be decompressed sequentially (1) or if an error occurs (-1)
+ */
+int segments_decompress (int in, char* output, OPTIONS* options, LZ78_STATS* stats);
+
+/**
+ * @brief It returns the number of codes after which the dictionary of a headerless stream is reset
+ * 
+ * @param bits the number of bits used for encoding
+ * @param dict_size the size of the dictionary
+ * @return uint64_t the number of codes of a segment
+ */
+uint64_t segments_length (int bits, int dict_size);
+
+#endif
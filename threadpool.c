@@ -0,0 +1,325 @@
+/*
+ * threadpool.c
+ * Francesco Piras - Dario Varano
+ * June 2015
+ */
+
+#include "threadpool.h"
+
+#include <pthread.h>
+#include <unistd.h>
+
+/**
+ * @brief A queued task
+ *
+ */
+typedef struct job_struct {
+	TASK task;					// the function to be executed
+	void* arg;					// the argument of the function
+	struct job_struct* next;	// next queued task (towards the tail)
+	struct job_struct* prev;	// previous queued task (towards the head)
+} JOB;
+
+/**
+ * @brief The queue of a worker thread: the owner takes its tasks from the head, in submission order,
+ * 		the other worker threads steal from the tail
+ *
+ */
+typedef struct deque_struct {
+	pthread_mutex_t lock;		// protects the queue
+	JOB* head;					// first queued task
+	JOB* tail;					// last queued task
+} DEQUE;
+
+/**
+ * @brief The argument of a worker thread
+ *
+ */
+typedef struct worker_struct {
+	struct thread_pool* pool;	// the thread pool
+	int index;					// the index of the worker thread, which is also the one of its queue
+} WORKER;
+
+typedef struct thread_pool {
+	pthread_mutex_t lock;		// protects the following fields up to stop
+	pthread_cond_t work;		// signaled when a task is queued or the pool is stopping
+	pthread_cond_t idle;		// signaled when the last pending task completes
+	int queued;					// number of tasks in the queues
+	int pending;				// number of tasks queued or running
+	int next;					// queue of the next submitted task
+	bool stop;					// flag telling the worker threads to exit
+	int threads;				// number of worker threads
+	pthread_t* workers;			// worker thread identifiers
+	WORKER* args;				// worker thread arguments
+	DEQUE* deques;				// the queues, one for each worker thread
+} THREAD_POOL;
+
+// index of the calling worker thread, -1 for the other threads
+static __thread int self = -1;
+
+/**
+ * @brief The body of a worker thread: it executes the tasks of its queue, or steals the ones of the other queues,
+ * 		until the pool is stopped
+ *
+ * @param arg the pointer to the argument of the worker thread
+ * @return void* always NULL
+ */
+void* thread_pool_worker (void* arg);
+
+/**
+ * @brief It takes a task: the first one of the queue of the worker thread, or else the last one of another queue
+ *
+ * @param pool the pointer to the thread pool
+ * @param index the index of the worker thread
+ * @return JOB* the task, or NULL if all the queues are empty
+ */
+JOB* thread_pool_take (THREAD_POOL* pool, int index);
+
+THREAD_POOL* thread_pool_create (int threads)
+{
+	THREAD_POOL* pool;
+	int i;
+
+	if (threads < 1)
+		return NULL;
+
+	pool = calloc(1, sizeof(THREAD_POOL));
+	if (pool == NULL)
+		return NULL;
+
+	pool->workers = calloc(threads, sizeof(pthread_t));
+	pool->args = calloc(threads, sizeof(WORKER));
+	pool->deques = calloc(threads, sizeof(DEQUE));
+	if (pool->workers == NULL || pool->args == NULL || pool->deques == NULL) {
+		free(pool->workers);
+		free(pool->args);
+		free(pool->deques);
+		free(pool);
+		return NULL;
+	}
+
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->work, NULL);
+	pthread_cond_init(&pool->idle, NULL);
+	for (i = 0; i < threads; i++)
+		pthread_mutex_init(&pool->deques[i].lock, NULL);
+	pool->threads = threads;
+
+	// starting the worker threads, an error stops the ones already started
+	for (i = 0; i < threads; i++) {
+		pool->args[i].pool = pool;
+		pool->args[i].index = i;
+		if (pthread_create(&pool->workers[i], NULL, thread_pool_worker, &pool->args[i]) != 0) {
+			pool->stop = true;
+			pool->threads = i;
+			thread_pool_destroy(pool);
+			return NULL;
+		}
+	}
+
+	return pool;
+}
+
+int thread_pool_submit (THREAD_POOL* pool, TASK task, void* arg)
+{
+	int index;
+
+	if (pool == NULL)
+		return -1;
+
+	// the tasks are spread over the queues in turn
+	pthread_mutex_lock(&pool->lock);
+	index = pool->next;
+	pool->next = (pool->next + 1) % pool->threads;
+	pthread_mutex_unlock(&pool->lock);
+
+	return thread_pool_submit_to(pool, index, task, arg);
+}
+
+int thread_pool_submit_to (THREAD_POOL* pool, int index, TASK task, void* arg)
+{
+	JOB* job;
+	DEQUE* deque;
+
+	if (pool == NULL || task == NULL || index < 0 || index >= pool->threads)
+		return -1;
+
+	job = malloc(sizeof(JOB));
+	if (job == NULL)
+		return -1;
+
+	job->task = task;
+	job->arg = arg;
+	job->next = NULL;
+
+	// the task is accounted before being queued, so that it can't complete before
+	pthread_mutex_lock(&pool->lock);
+	pool->queued++;
+	pool->pending++;
+	pthread_mutex_unlock(&pool->lock);
+
+	// appending the task to the queue
+	deque = &pool->deques[index];
+	pthread_mutex_lock(&deque->lock);
+	job->prev = deque->tail;
+	if (deque->tail != NULL)
+		deque->tail->next = job;
+	else
+		deque->head = job;
+	deque->tail = job;
+	pthread_mutex_unlock(&deque->lock);
+
+	// waking up a worker thread: any of them can steal the task
+	pthread_mutex_lock(&pool->lock);
+	pthread_cond_signal(&pool->work);
+	pthread_mutex_unlock(&pool->lock);
+
+	return 0;
+}
+
+void thread_pool_wait (THREAD_POOL* pool)
+{
+	if (pool == NULL)
+		return;
+
+	pthread_mutex_lock(&pool->lock);
+	while (pool->pending > 0)
+		pthread_cond_wait(&pool->idle, &pool->lock);
+	pthread_mutex_unlock(&pool->lock);
+}
+
+void thread_pool_destroy (THREAD_POOL* pool)
+{
+	int i;
+
+	if (pool == NULL)
+		return;
+
+	thread_pool_wait(pool);
+
+	// telling the worker threads to exit and waiting for them
+	pthread_mutex_lock(&pool->lock);
+	pool->stop = true;
+	pthread_cond_broadcast(&pool->work);
+	pthread_mutex_unlock(&pool->lock);
+
+	for (i = 0; i < pool->threads; i++)
+		pthread_join(pool->workers[i], NULL);
+
+	for (i = 0; i < pool->threads; i++)
+		pthread_mutex_destroy(&pool->deques[i].lock);
+	pthread_cond_destroy(&pool->idle);
+	pthread_cond_destroy(&pool->work);
+	pthread_mutex_destroy(&pool->lock);
+	free(pool->deques);
+	free(pool->args);
+	free(pool->workers);
+	free(pool);
+}
+
+int thread_pool_size (THREAD_POOL* pool)
+{
+	if (pool == NULL)
+		return 0;
+
+	return pool->threads;
+}
+
+int thread_pool_self (void)
+{
+	return self;
+}
+
+int thread_pool_default_size (void)
+{
+	long n;
+
+	n = sysconf(_SC_NPROCESSORS_ONLN);
+
+	return (n > 0)?((int)n):(1);
+}
+
+JOB* thread_pool_take (THREAD_POOL* pool, int index)
+{
+	DEQUE* deque;
+	JOB* job;
+	int i;
+
+	// the own queue first, from the head
+	deque = &pool->deques[index];
+	pthread_mutex_lock(&deque->lock);
+	job = deque->head;
+	if (job != NULL) {
+		deque->head = job->next;
+		if (deque->head != NULL)
+			deque->head->prev = NULL;
+		else
+			deque->tail = NULL;
+	}
+	pthread_mutex_unlock(&deque->lock);
+	if (job != NULL)
+		return job;
+
+	// then the other queues, from the tail, starting from the next one
+	for (i = 1; i < pool->threads; i++) {
+		deque = &pool->deques[(index + i) % pool->threads];
+		pthread_mutex_lock(&deque->lock);
+		job = deque->tail;
+		if (job != NULL) {
+			deque->tail = job->prev;
+			if (deque->tail != NULL)
+				deque->tail->next = NULL;
+			else
+				deque->head = NULL;
+		}
+		pthread_mutex_unlock(&deque->lock);
+		if (job != NULL)
+			return job;
+	}
+
+	return NULL;
+}
+
+void* thread_pool_worker (void* arg)
+{
+	THREAD_POOL* pool;
+	WORKER* worker;
+	JOB* job;
+
+	worker = arg;
+	pool = worker->pool;
+	self = worker->index;
+
+	while (1) {
+		job = thread_pool_take(pool, worker->index);
+
+		if (job != NULL) {
+			pthread_mutex_lock(&pool->lock);
+			pool->queued--;
+			pthread_mutex_unlock(&pool->lock);
+
+			job->task(job->arg);
+			free(job);
+
+			// waking up the waiting threads if this was the last pending task
+			pthread_mutex_lock(&pool->lock);
+			pool->pending--;
+			if (pool->pending == 0)
+				pthread_cond_broadcast(&pool->idle);
+			pthread_mutex_unlock(&pool->lock);
+			continue;
+		}
+
+		// waiting for a task, or for the pool to be stopped: a task accounted but not queued yet is taken at the next round
+		pthread_mutex_lock(&pool->lock);
+		while (pool->queued == 0 && pool->stop == false)
+			pthread_cond_wait(&pool->work, &pool->lock);
+		if (pool->queued == 0) {
+			pthread_mutex_unlock(&pool->lock);
+			break;
+		}
+		pthread_mutex_unlock(&pool->lock);
+	}
+
+	return NULL;
+}
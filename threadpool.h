@@ -0,0 +1,94 @@
+/*
+ * threadpool.h
+ * Francesco Piras - Dario Varano
+ * June 2015
+ */
+
+#ifndef _THREADPOOL_H
+#define _THREADPOOL_H
+
+#include "definitions.h"
+
+/**
+ * @brief A task executed by a worker thread
+ * 
+ */
+typedef void (*TASK) (void* arg);
+
+/**
+ * @brief A fixed set of worker threads, each one with its own queue of tasks: a worker thread executes the tasks
+ * 		of its queue in submission order, and when it is empty it steals the last tasks of the other queues
+ * 
+ */
+typedef struct thread_pool THREAD_POOL;
+
+/**
+ * @brief It starts the worker threads
+ * 
+ * @param threads the number of worker threads
+ * @return THREAD_POOL* pointer to the structure allocated in the dynamic memory, or NULL if an error occurs
+ */
+THREAD_POOL* thread_pool_create (int threads);
+
+/**
+ * @brief It queues a task, spreading the tasks over the queues of the worker threads in turn
+ * 
+ * @param pool the pointer to the thread pool
+ * @param task the function to be executed
+ * @param arg the argument of the function
+ * @return int a flag indicating if the task has been queued (0) or if an error occurs (-1)
+ */
+int thread_pool_submit (THREAD_POOL* pool, TASK task, void* arg);
+
+/**
+ * @brief It queues a task on the queue of a worker thread (an idle worker thread can still steal it)
+ * 
+ * @param pool the pointer to the thread pool
+ * @param index the index of the worker thread, from 0 to the number of worker threads - 1
+ * @param task the function to be executed
+ * @param arg the argument of the function
+ * @return int a flag indicating if the task has been queued (0) or if an error occurs (-1)
+ */
+int thread_pool_submit_to (THREAD_POOL* pool, int index, TASK task, void* arg);
+
+/**
+ * @brief It waits until all the submitted tasks have been executed
+ * 
+ * @param pool the pointer to the thread pool
+ * @return void
+ */
+void thread_pool_wait (THREAD_POOL* pool);
+
+/**
+ * @brief It waits for the submitted tasks, stops the worker threads and deallocates the thread pool
+ * 
+ * @param pool the pointer to the thread pool
+ * @return void
+ */
+void thread_pool_destroy (THREAD_POOL* pool);
+
+/**
+ * @brief It returns the number of worker threads
+ * 
+ * @param pool the pointer to the thread pool
+ * @return int the number of worker threads, or 0 in case of error
+ */
+int thread_pool_size (THREAD_POOL* pool);
+
+/**
+ * @brief It returns the index of the calling worker thread, so that a task can use the resources of the
+ * 		worker thread which executes it
+ * 
+ * @return int the index of the worker thread, from 0 to the number of worker threads - 1, or -1 if the caller
+ * 		is not a worker thread
+ */
+int thread_pool_self (void);
+
+/**
+ * @brief It returns the number of online processors, which is the default number of worker threads
+ * 
+ * @return int the number of online processors (at least 1)
+ */
+int thread_pool_default_size (void);
+
+#endif
@@ -0,0 +1,298 @@
+/*
+ * train.c
+ * Francesco Piras - Dario Varano
+ * June 2015
+ */
+
+#include <unistd.h>
+#include <string.h>
+#include "definitions.h"
+#include "dictionary.h"
+#include "preset.h"
+
+#define TRAIN_NODES		(1 << 20)			// default maximum number of phrases learned from the samples
+#define TRAIN_CHUNK		(1024 * 1024)		// size (in bytes) of the chunks read from the samples
+
+/**
+ * @brief The phrases learned from the samples, with the number of times the parse went through each one
+ *
+ */
+typedef struct trainer_struct {
+	dictionary* dictionary;					// the phrases, looked up as a compressor does
+	CODE next_code;							// next code to be assigned
+	CODE max_code;							// last code which can be assigned
+	CODE* parents;							// the parent of every code
+	uint8_t* symbols;						// the symbol of every code
+	uint64_t* visits;						// how many times the parse went through every code
+	CODE current;							// current node of the parse
+	bool started;							// flag indicating that the current node is set
+} TRAINER;
+
+/**
+ * @brief It parses a file of samples as a compressor would do, without a dictionary size limit: every phrase
+ * 		extends the longest known one, and the phrases the parse goes through are counted
+ *
+ * @param trainer the pointer to the trainer
+ * @param path the file name
+ * @param lines flag indicating that every line is a separate message (the parse starts again after a newline)
+ * @return int a flag indicating if the file has been parsed (0) or if an error occurs (-1)
+ */
+int train_file (TRAINER* trainer, char* path, bool lines);
+
+/**
+ * @brief It compares two codes by the visits of their phrases (more visited first) and then by code, for qsort.
+ * 		A phrase is visited at least as often as its extensions, and it has a lower code, so it always comes first
+ */
+int compare_visits (const void* a, const void* b);
+
+// the visits compared by compare_visits
+static uint64_t* sort_visits;
+
+int main (int argc, char** argv)
+{
+	TRAINER trainer;
+	OPTIONS options;
+	CODE* order;
+	CODE* codes;
+	CODE* parents;
+	uint8_t* symbols;
+	CODE count, capacity, limit, nodes, i;
+	long int tmp;
+	char* output;
+	bool lines, image;
+	int arg, file, ret;
+
+	memset(&options, 0, sizeof(OPTIONS));
+	options.bits = 12;
+	limit = 0;
+	nodes = TRAIN_NODES;
+	lines = false;
+	image = true;
+	output = NULL;
+
+	// parsing the options
+	while ((arg = getopt(argc, argv, "ab:f:ln:m:o:s:t:x")) != -1) {
+		switch (arg) {
+			case 'a':
+				options.adaptive = true;
+				break;
+			case 'b':
+				tmp = strtol(optarg, NULL, 10);
+				if (tmp < MIN_BITS || tmp > MAX_BITS) {
+					fprintf(stderr, "Bad bits number\n");
+					return -1;
+				}
+				options.bits = (int)tmp;
+				break;
+			case 'f':
+				tmp = strtol(optarg, NULL, 10);
+				if (tmp < DICTIONARY_MIN_LOAD_FACTOR || tmp > DICTIONARY_MAX_LOAD_FACTOR) {
+					fprintf(stderr, "Bad load factor\n");
+					return -1;
+				}
+				options.load_factor = (int)tmp;
+				break;
+			case 'l':
+				lines = true;
+				break;
+			case 'n':
+				tmp = strtol(optarg, NULL, 10);
+				if (tmp <= 0L || tmp > (1L << MAX_BITS)) {
+					fprintf(stderr, "Bad number of entries\n");
+					return -1;
+				}
+				limit = (CODE)tmp;
+				break;
+			case 'm':
+				tmp = strtol(optarg, NULL, 10);
+				if (tmp <= 0L || tmp > (1L << 26)) {
+					fprintf(stderr, "Bad number of phrases\n");
+					return -1;
+				}
+				nodes = (CODE)tmp;
+				break;
+			case 'o':
+				output = optarg;
+				break;
+			case 's':
+				tmp = strtol(optarg, NULL, 10);
+				if (tmp < MIN_DICT_SIZE || tmp > MAX_DICT_SIZE) {
+					fprintf(stderr, "Bad dictionary size. It has to be from %d to %d\n", MIN_DICT_SIZE, MAX_DICT_SIZE);
+					return -1;
+				}
+				options.dict_size = (int)tmp;
+				break;
+			case 't':
+				if (strcmp(optarg, "linear") == 0)
+					options.table = DICTIONARY_LINEAR;
+				else if (strcmp(optarg, "buckets") == 0)
+					options.table = DICTIONARY_BUCKETS;
+				else if (strcmp(optarg, "robinhood") == 0)
+					options.table = DICTIONARY_ROBIN_HOOD;
+				else {
+					fprintf(stderr, "Bad table layout\n");
+					return -1;
+				}
+				break;
+			case 'x':
+				image = false;
+				break;
+			case '?':
+				fprintf(stderr, "Usage: %s [-a] [-b bits] [-s dict_size] [-f load_factor] [-t linear|buckets|robinhood] [-n entries] [-m phrases] [-l] [-x] -o dictfile sample...\n", argv[0]);
+				return -1;
+		}
+	}
+
+	if (output == NULL || optind >= argc) {
+		fprintf(stderr, "Usage: %s [-a] [-b bits] [-s dict_size] [-f load_factor] [-t linear|buckets|robinhood] [-n entries] [-m phrases] [-l] [-x] -o dictfile sample...\n", argv[0]);
+		return -1;
+	}
+	if (options.dict_size == 0)
+		options.dict_size = 1 << options.bits;
+
+	// the preset dictionary fits the streams with the same parameters
+	capacity = preset_capacity(&options);
+	if (limit == 0 || limit > capacity)
+		limit = capacity;
+	if (limit == 0) {
+		fprintf(stderr, "The dictionary size leaves no room for a preset dictionary\n");
+		return -1;
+	}
+
+	memset(&trainer, 0, sizeof(TRAINER));
+	trainer.max_code = FIRST_CODE + nodes - 1;
+	trainer.next_code = FIRST_CODE;
+	trainer.dictionary = dictionary_alloc(nodes * 2, true, DICTIONARY_LINEAR);
+	trainer.parents = malloc((size_t)(trainer.max_code + 1) * sizeof(CODE));
+	trainer.symbols = malloc(trainer.max_code + 1);
+	trainer.visits = calloc(trainer.max_code + 1, sizeof(uint64_t));
+	if (trainer.dictionary == NULL || trainer.parents == NULL || trainer.symbols == NULL || trainer.visits == NULL) {
+		fprintf(stderr, "Out of memory\n");
+		return -1;
+	}
+	dictionary_compressor_init(trainer.dictionary);
+
+	for (file = optind; file < argc; file++) {
+		if (train_file(&trainer, argv[file], lines) < 0) {
+			fprintf(stderr, "Can't read %s\n", argv[file]);
+			return -1;
+		}
+	}
+
+	// the most visited phrases, each one after its parent: the phrases never reused are not worth an entry
+	count = trainer.next_code - FIRST_CODE;
+	order = malloc(((size_t)count + 1) * sizeof(CODE));
+	codes = calloc(trainer.max_code + 1, sizeof(CODE));
+	parents = malloc(((size_t)limit + 1) * sizeof(CODE));
+	symbols = malloc((size_t)limit + 1);
+	if (order == NULL || codes == NULL || parents == NULL || symbols == NULL) {
+		fprintf(stderr, "Out of memory\n");
+		return -1;
+	}
+	for (i = 0; i < count; i++)
+		order[i] = FIRST_CODE + i;
+	sort_visits = trainer.visits;
+	qsort(order, count, sizeof(CODE), compare_visits);
+
+	// the entries are numbered again in the order of the file, so their parents are renumbered too
+	for (i = 0; i < count && i < limit && trainer.visits[order[i]] > 0; i++) {
+		codes[order[i]] = FIRST_CODE + i;
+		parents[i] = (trainer.parents[order[i]] < SYMBOLS)?(trainer.parents[order[i]]):(codes[trainer.parents[order[i]]]);
+		symbols[i] = trainer.symbols[order[i]];
+	}
+	count = i;
+
+	if (count == 0) {
+		fprintf(stderr, "The samples have no repeated phrases\n");
+		return -1;
+	}
+
+	ret = preset_save(output, count, parents, symbols, (image == true)?(&options):(NULL));
+	if (ret < 0)
+		fprintf(stderr, "Can't write %s\n", output);
+	else
+		printf("Preset dictionary %s: %u entries (at most %u for %d bits and dictionary size %d)\n", output, count, capacity,
+				options.bits, options.dict_size);
+
+	free(order);
+	free(codes);
+	free(parents);
+	free(symbols);
+	free(trainer.parents);
+	free(trainer.symbols);
+	free(trainer.visits);
+	dictionary_free(trainer.dictionary);
+
+	return ret;
+}
+
+int train_file (TRAINER* trainer, char* path, bool lines)
+{
+	FILE* fp;
+	uint8_t* chunk;
+	uint32_t index;
+	size_t len, i;
+
+	fp = (strcmp(path, "-") == 0)?(stdin):(fopen(path, "rb"));
+	if (fp == NULL)
+		return -1;
+	chunk = malloc(TRAIN_CHUNK);
+	if (chunk == NULL) {
+		if (fp != stdin)
+			fclose(fp);
+		return -1;
+	}
+
+	// every file is a separate message
+	trainer->started = false;
+
+	while ((len = fread(chunk, 1, TRAIN_CHUNK, fp)) > 0) {
+		for (i = 0; i < len; i++) {
+			if (trainer->started == false) {
+				trainer->current = chunk[i];
+				trainer->started = true;
+			}
+			else {
+				index = dictionary_lookup(trainer->dictionary, trainer->current, (SYMBOL)chunk[i]);
+
+				// the phrase goes on, or a new phrase is learned, as long as there is room for it
+				if (dictionary_is_entry_unused(trainer->dictionary, index) == false) {
+					trainer->current = dictionary_get_entry_code(trainer->dictionary, index);
+					trainer->visits[trainer->current]++;
+				}
+				else {
+					if (trainer->next_code <= trainer->max_code) {
+						dictionary_insert(trainer->dictionary, index, trainer->current, trainer->next_code, (SYMBOL)chunk[i]);
+						trainer->parents[trainer->next_code] = trainer->current;
+						trainer->symbols[trainer->next_code] = chunk[i];
+						trainer->next_code++;
+					}
+					trainer->current = chunk[i];
+				}
+			}
+
+			// the next message starts after the newline
+			if (lines == true && chunk[i] == '\n')
+				trainer->started = false;
+		}
+	}
+
+	free(chunk);
+	if (fp != stdin)
+		fclose(fp);
+
+	return 0;
+}
+
+int compare_visits (const void* a, const void* b)
+{
+	CODE x, y;
+
+	x = *(const CODE*)a;
+	y = *(const CODE*)b;
+
+	if (sort_visits[x] != sort_visits[y])
+		return (sort_visits[x] > sort_visits[y])?(-1):(1);
+
+	return (x < y)?(-1):((x > y)?(1):(0));
+}